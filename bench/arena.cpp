@@ -0,0 +1,37 @@
+/* Parse + teardown benchmark for the AST allocation strategy.
+   Only uses the Parser/Program interface, so it builds against older checkouts too (see `make bench-arena`). */
+
+#include "parser/Parser.h"
+
+#include <chrono>
+#include <iostream>
+#include <sys/resource.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    auto parseStart = Clock::now();
+    Parser p;
+    Program* prog;
+    try {
+        prog = p.program();
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+    double parseTime = millisecondsSince(parseStart);
+
+    auto teardownStart = Clock::now();
+    delete prog;
+    double teardownTime = millisecondsSince(teardownStart);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cerr << "parse: " << parseTime << " ms, teardown: " << teardownTime << " ms, "
+              << "peak RSS: " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+}
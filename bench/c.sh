@@ -0,0 +1,27 @@
+#!/bin/sh
+# Times the C backend against the in-process engines: every program is translated with --c and built with
+# $CC -O2 (both timed), then the native executable, the interpreter, the VM and the JIT run it.
+# Usage: bench/c.sh <pascal-parser> <file.pas>...
+
+parser=$1
+shift
+CC=${CC:-cc}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+milliseconds() {
+    start=$(date +%s%N)
+    "$@" > /dev/null 2>&1
+    echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+for file in "$@"; do
+    name=$(basename "$file" .pas)
+    translate=$(milliseconds "$parser" --c "$file")
+    "$parser" --c "$file" > "$work/$name.c" || exit 1
+    build=$(milliseconds $CC -O2 -o "$work/$name" "$work/$name.c")
+
+    echo "$file: translated in $translate ms, built in $build ms, native $(milliseconds "$work/$name") ms," \
+         "interpreter $(milliseconds "$parser" --run "$file") ms, vm $(milliseconds "$parser" --run=vm "$file") ms," \
+         "jit $(milliseconds "$parser" --jit "$file") ms"
+done
@@ -0,0 +1,85 @@
+/* AST2Dot on a large program: the whole graph collected in memory, and on the current tree also streamed to
+   /dev/null and split into one file per method (DotClusters). Built with -DDOT_BASELINE against a revision that
+   still named the nodes through a std::map (see `make bench-dot`).
+   Usage: dot <file.pas> [directory for the method files] */
+
+#include "parser/Parser.h"
+#ifndef DOT_BASELINE
+#include "parser/DotClusters.h"
+#endif
+
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/resource.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static long peakMegabytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> [directory]" << std::endl;
+        return -1;
+    }
+
+    SourceFile* source = SourceFile::map(argv[1]);
+    if (source == NULL) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return -1;
+    }
+
+    Parser p(source);
+    Program* prog;
+    try {
+        prog = p.program();
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+    std::cout << "parsed, peak RSS " << peakMegabytes() << " MB" << std::endl;
+
+#ifndef DOT_BASELINE
+    // streamed first, so its peak RSS is not hidden by the in-memory run
+    auto start = Clock::now();
+    {
+        int fd = open("/dev/null", O_WRONLY);
+        OutputSink output(fd);
+        AST2Dot ast2dot(&output);
+        ast2dot.visit(prog);
+        output.flush();
+        close(fd);
+    }
+    std::cout << "streamed: " << millisecondsSince(start) << " ms, peak RSS " << peakMegabytes() << " MB" << std::endl;
+
+    if (argc > 2) {
+        start = Clock::now();
+        DotClusters clusters(argv[2]);
+        size_t failed = clusters.write(prog);
+        std::cout << "one file per method (" << prog->methods.size() + 1 << " files, " << failed << " failed): "
+                  << millisecondsSince(start) << " ms" << std::endl;
+    }
+
+    start = Clock::now();
+#else
+    auto start = Clock::now();
+#endif
+    size_t length;
+    {
+        AST2Dot ast2dot;
+        ast2dot.visit(prog);
+        length = ast2dot.getResult().size();
+    }
+    std::cout << "in memory (" << length / (1024 * 1024) << " MB): " << millisecondsSince(start) << " ms, peak RSS "
+              << peakMegabytes() << " MB" << std::endl;
+
+    delete prog;
+}
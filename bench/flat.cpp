@@ -0,0 +1,150 @@
+/* Pointer tree vs. flat AST: memory per node and the time of a whole program scan (counting identifiers and
+   the deepest line) and of AST2Text on both. Usage: flat <file.pas> [repetitions] */
+
+#include "parser/Parser.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* the scan over the tree: visits every node through visit()/visitX() */
+class TreeScan : public ASTVisitor<TreeScan> {
+public:
+    size_t identifiers = 0;
+    int lastLine = 0;
+
+    void visitProgram(Program* prog) {
+        for (const auto& meth : prog->methods) visit(meth);
+        visit(prog->main);
+    }
+    void visitMethod(Method* meth) { visit(meth->block); }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        if (stmt->arrayIndex != NULL) visit(stmt->arrayIndex);
+        visit(stmt->value);
+    }
+    void visitCall(Stmt::Call* stmt) { for (const auto& argument : stmt->arguments) visit(argument); }
+    void visitIf(Stmt::If* stmt) {
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) visit(stmt->elseBody);
+    }
+    void visitWhile(Stmt::While* stmt) {
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+    void visitBlock(Stmt::Block* stmt) { for (const auto& statement : stmt->statements) visit(statement); }
+
+    void visitBinary(Expr::Binary* expr) {
+        visit(expr->left);
+        visit(expr->right);
+    }
+    void visitCall(Expr::Call* expr) { for (const auto& argument : expr->arguments) visit(argument); }
+    void visitGrouping(Expr::Grouping* expr) { visit(expr->expression); }
+    void visitIdentifier(Expr::Identifier* expr) {
+        identifiers++;
+        lastLine = std::max(lastLine, expr->token.lineNumber);
+        if (expr->arrayIndexExpression != NULL) visit(expr->arrayIndexExpression);
+    }
+    void visitLiteral(Expr::Literal* expr) {}
+    void visitUnary(Expr::Unary* expr) { visit(expr->right); }
+};
+
+/* the same scan over the flat AST: one pass over the arrays */
+static void flatScan(const FlatAST* flat, size_t& identifiers, int& lastLine) {
+    identifiers = 0;
+    lastLine = 0;
+
+    for (Flat::NodeIndex node = 0; node < flat->size(); node++) {
+        if (flat->kinds[node] == Flat::IDENTIFIER) {
+            identifiers++;
+            lastLine = std::max(lastLine, static_cast<int>(flat->lines[node]));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> [repetitions]" << std::endl;
+        return -1;
+    }
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    SourceFile* source = SourceFile::map(argv[1]);
+    if (source == NULL) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return -1;
+    }
+
+    Parser p(source);
+    Program* prog;
+    try {
+        prog = p.program();
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+
+    auto convertStart = Clock::now();
+    AST2Flat ast2flat;
+    FlatAST* flat = ast2flat.convert(prog);
+    double convertTime = millisecondsSince(convertStart);
+
+    // the arena holds the tree nodes and their child lists, the interned texts are shared by both
+    size_t treeBytes = prog->arena->reservedBytes();
+    size_t flatBytes = flat->memoryBytes();
+
+    std::cout << flat->size() << " nodes, converted in " << convertTime << " ms" << std::endl;
+    std::cout << "tree: " << treeBytes / 1024 << " KB (" << static_cast<double>(treeBytes) / flat->size() << " bytes/node)" << std::endl;
+    std::cout << "flat: " << flatBytes / 1024 << " KB (" << static_cast<double>(flatBytes) / flat->size() << " bytes/node)" << std::endl;
+
+    double treeScan = 0, flatScanTime = 0, treeText = 0, flatText = 0;
+    size_t treeIdentifiers = 0, flatIdentifiers = 0;
+    int treeLine = 0, flatLine = 0;
+
+    for (int i = 0; i < repetitions; i++) {
+        auto start = Clock::now();
+        TreeScan scan;
+        scan.visit(prog);
+        treeScan += millisecondsSince(start);
+        treeIdentifiers = scan.identifiers;
+        treeLine = scan.lastLine;
+
+        start = Clock::now();
+        flatScan(flat, flatIdentifiers, flatLine);
+        flatScanTime += millisecondsSince(start);
+
+        start = Clock::now();
+        AST2Text ast2text;
+        ast2text.visit(prog);
+        size_t treeLength = ast2text.getResult().size();
+        treeText += millisecondsSince(start);
+
+        start = Clock::now();
+        FlatAST2Text flat2text(flat);
+        size_t flatLength = flat2text.getResult().size();
+        flatText += millisecondsSince(start);
+
+        if (treeLength != flatLength) {
+            std::cerr << "AST2Text results differ" << std::endl;
+            return -1;
+        }
+    }
+
+    if (treeIdentifiers != flatIdentifiers || treeLine != flatLine) {
+        std::cerr << "scan results differ" << std::endl;
+        return -1;
+    }
+
+    std::cout << "scan (" << flatIdentifiers << " identifiers): tree " << treeScan / repetitions << " ms, flat "
+              << flatScanTime / repetitions << " ms" << std::endl;
+    std::cout << "AST2Text: tree " << treeText / repetitions << " ms, flat " << flatText / repetitions << " ms" << std::endl;
+
+    delete flat;
+    delete prog;
+}
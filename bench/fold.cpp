@@ -0,0 +1,137 @@
+/* What ConstantFolder saves the visitors that come after it: the AST nodes (and the expression nodes among
+   them) of every given program before and after folding, what was folded and how long it took. Files that do
+   not parse are skipped.
+   Usage: fold <file.pas>... */
+
+#include "parser/Parser.h"
+#include "parser/AST/Visitors/ConstantFolder.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+class Counter : public ASTVisitor<Counter> {
+public:
+    size_t nodes = 0;
+    size_t expressions = 0;
+
+    void visitProgram(Program* prog) {
+        nodes++;
+        for (const auto& meth : prog->methods) visit(meth);
+        visit(prog->main);
+    }
+    void visitMethod(Method* meth) {
+        nodes++;
+        visit(meth->block);
+    }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        nodes++;
+        if (stmt->arrayIndex != NULL) visit(stmt->arrayIndex);
+        visit(stmt->value);
+    }
+    void visitCall(Stmt::Call* stmt) {
+        nodes++;
+        for (const auto& argument : stmt->arguments) visit(argument);
+    }
+    void visitIf(Stmt::If* stmt) {
+        nodes++;
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) visit(stmt->elseBody);
+    }
+    void visitWhile(Stmt::While* stmt) {
+        nodes++;
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+    void visitBlock(Stmt::Block* stmt) {
+        nodes++;
+        for (const auto& statement : stmt->statements) visit(statement);
+    }
+
+    void visitBinary(Expr::Binary* expr) {
+        expression();
+        visit(expr->left);
+        visit(expr->right);
+    }
+    void visitCall(Expr::Call* expr) {
+        expression();
+        for (const auto& argument : expr->arguments) visit(argument);
+    }
+    void visitGrouping(Expr::Grouping* expr) {
+        expression();
+        visit(expr->expression);
+    }
+    void visitIdentifier(Expr::Identifier* expr) {
+        expression();
+        if (expr->arrayIndexExpression != NULL) visit(expr->arrayIndexExpression);
+    }
+    void visitLiteral(Expr::Literal* expr) { expression(); }
+    void visitUnary(Expr::Unary* expr) {
+        expression();
+        visit(expr->right);
+    }
+
+private:
+    void expression() {
+        nodes++;
+        expressions++;
+    }
+};
+
+static Counter count(Program* prog) {
+    Counter counter;
+    counter.visit(prog);
+    return counter;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    size_t totalBefore = 0, totalAfter = 0;
+    for (int i = 1; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cout << argv[i] << ": skipped, syntax error" << std::endl;
+            continue;
+        }
+
+        Counter before = count(prog);
+
+        auto start = Clock::now();
+        ConstantFolder folder(prog);
+        folder.fold();
+        double foldTime = millisecondsSince(start);
+
+        Counter after = count(prog);
+        totalBefore += before.nodes;
+        totalAfter += after.nodes;
+
+        std::cout << argv[i] << ": " << before.nodes << " -> " << after.nodes << " nodes (expressions "
+                  << before.expressions << " -> " << after.expressions << "), " << folder.folded << " folded, "
+                  << folder.simplified << " simplified, " << folder.groupings << " groupings removed in "
+                  << foldTime << " ms" << std::endl;
+
+        delete prog;
+    }
+
+    std::cout << "total: " << totalBefore << " -> " << totalAfter << " nodes" << std::endl;
+}
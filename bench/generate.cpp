@@ -0,0 +1,540 @@
+/* Generates random programs of exactly the grammar Parser.h accepts, for workloads of a chosen shape and size
+   (see `make generate`). The same options and seed always give the same program: the random numbers come from
+   std::mt19937_64, whose sequence the standard fixes, reduced by modulo rather than by a distribution (those
+   differ between standard libraries). Names are declared nowhere in particular, the programs parse but are
+   not meant to be run.
+
+   Usage: generate [--seed=N] [--size=N[K|M|G]] [--methods=N] [--statement-depth=N] [--expression-depth=N]
+                   [--vocabulary=N]
+     --size              bytes to generate at least (the last statement is finished), the methods share them;
+                         a lower bound only, every method gets a statement at least, so many methods on a small
+                         size make the program larger (--size=1K --methods=1000 writes about 450 KB, with a
+                         warning when it is more than twice the size)
+     --methods           functions and procedures, by default one per METHOD_SIZE bytes (or METHODS without a size)
+     --statement-depth   nesting of blocks, ifs and whiles in a method body
+     --expression-depth  nesting of the deepest operand of every expression in groupings, unary operators, calls
+                         and array indexes
+     --vocabulary        distinct identifiers
+   --size, --methods and --vocabulary take positive numbers (with K, M or G), the others numbers from 0. */
+
+#include "parser/OutputSink.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const size_t METHOD_SIZE = 4096;
+static const size_t METHODS = 10;
+static const size_t STATEMENTS = 8;        // per method without a size
+static const size_t MAIN_STATEMENTS = 4;
+static const size_t MAX_LIST = 3;          // arguments, declaration lines, names per line, operators in a row
+static const size_t MAX_BLOCK = 4;         // statements of a nested block
+static const size_t SIDE_DEPTH = 2;        // nesting of the operands beside the deepest one of an expression
+
+/* two letter syllables that no keyword is made of */
+static const char* const SYLLABLES[] = { "ba", "ko", "mi", "ru", "te", "lo", "xa", "zu", "fe", "ni", "po", "sa", "gi", "wo", "hu", "ye" };
+static const char* const TYPES[] = { "integer", "real", "boolean" };
+static const char* const RELATIONS[] = { "=", "<>", "<", "<=", ">", ">=" };
+static const char* const ADDITIONS[] = { "+", "-", "or" };
+static const char* const MULTIPLICATIONS[] = { "*", "/", "div", "and" };
+
+template <typename T, size_t N>
+static constexpr size_t count(T (&)[N]) { return N; }
+
+class Generator {
+public:
+    uint64_t seed = 1;
+    size_t size = 0;
+    size_t methods = 0;
+    size_t statementDepth = 3;
+    size_t expressionDepth = 3;
+    size_t vocabulary = 1000;
+
+    Generator(OutputSink* output) : output{output} {}
+
+    void generate() {
+        random.seed(seed);
+        for (size_t i = 0; i < vocabulary; i++) {
+            names.push_back(name(i));
+        }
+        if (methods == 0) {
+            methods = size > 0 ? std::max<size_t>(1, size / METHOD_SIZE) : METHODS;
+        }
+
+        out += "program ";
+        identifier();
+        out += ";\n";
+        declarations(0);
+        out += '\n';
+
+        for (size_t i = 0; i < methods; i++) {
+            // each method fills its share of what is left
+            size_t share = size > emitted + out.size() ? (size - emitted - out.size()) / (methods - i) : 0;
+            method(share);
+            flush(false);
+        }
+
+        out += "begin\n";
+        for (size_t i = 0; i < MAIN_STATEMENTS; i++) {
+            indent(1);
+            statement(1);
+            out += i + 1 < MAIN_STATEMENTS ? ";\n" : "\n";
+        }
+        out += "end.\n";
+        flush(true);
+    }
+
+    size_t written() const { return emitted; }
+
+private:
+    OutputSink* output;
+    std::mt19937_64 random;
+    std::vector<std::string> names;
+    std::string out;     // not yet written to the output
+    size_t emitted = 0;  // bytes written to the output
+
+    /* a number in [0, n) */
+    size_t next(size_t n) { return random() % n; }
+    bool chance(size_t percent) { return next(100) < percent; }
+
+    /* the ith identifier of the vocabulary, two syllables at least */
+    static std::string name(size_t i) {
+        std::string result;
+        do {
+            result += SYLLABLES[i % 16];
+            i /= 16;
+        } while (i > 0 || result.size() < 4);
+        return result;
+    }
+
+    void flush(bool always) {
+        if (always || out.size() >= OutputSink::BUFFER_SIZE) {
+            *output << out;
+            emitted += out.size();
+            out.clear();
+        }
+    }
+
+    void indent(size_t level) { out.append(4 * level, ' '); }
+    void identifier() { out += names[next(names.size())]; }
+    void integer() { out += std::to_string(next(1000)); }
+
+    /* ---------------- Declarations ---------------- */
+
+    void declarations(size_t level) {
+        if (!chance(70)) {
+            return;
+        }
+        indent(level);
+        out += "var ";
+        size_t lines = 1 + next(MAX_LIST);
+        for (size_t i = 0; i < lines; i++) {
+            if (i > 0) {
+                indent(level + 1);
+            }
+            declarationLine();
+            out += ";\n";
+        }
+    }
+
+    void declarationLine() {
+        size_t variables = 1 + next(MAX_LIST);
+        for (size_t i = 0; i < variables; i++) {
+            if (i > 0) {
+                out += ", ";
+            }
+            identifier();
+        }
+        out += ": ";
+        type();
+    }
+
+    void type() {
+        if (chance(20)) {
+            size_t start = next(10);
+            out += "array [" + std::to_string(start) + ".." + std::to_string(start + next(1000)) + "] of ";
+        }
+        out += TYPES[next(count(TYPES))];
+    }
+
+    /* ---------------- Methods ---------------- */
+
+    /* a function or procedure of about share bytes (STATEMENTS statements without a size) */
+    void method(size_t share) {
+        size_t start = emitted + out.size();
+        bool function = chance(50);
+
+        out += function ? "function " : "procedure ";
+        identifier();
+        out += " (";
+        size_t lines = next(MAX_LIST + 1);
+        for (size_t i = 0; i < lines; i++) {
+            if (i > 0) {
+                out += "; ";
+            }
+            declarationLine();
+        }
+        out += ')';
+        if (function) {
+            out += " : ";
+            type();
+        }
+        out += ";\n";
+        declarations(1);
+
+        out += "begin\n";
+        for (size_t i = 0; size > 0 ? i == 0 || emitted + out.size() - start < share : i < STATEMENTS; i++) {
+            if (i > 0) {
+                out += ";\n";
+            }
+            indent(1);
+            statement(1);
+            flush(false);
+        }
+        out += "\nend;\n\n";
+    }
+
+    /* ---------------- Statements ---------------- */
+
+    void statement(size_t level) {
+        size_t kind = level > statementDepth ? next(60) : next(100);
+        if (kind < 45) {
+            assignment();
+        } else if (kind < 60) {
+            call();
+        } else if (kind < 75) {
+            out += "if ";
+            expression();
+            out += " then\n";
+            indent(level + 1);
+            statement(level + 1);
+            if (chance(50)) {
+                out += '\n';
+                indent(level);
+                out += "else\n";
+                indent(level + 1);
+                statement(level + 1);
+            }
+        } else if (kind < 85) {
+            out += "while ";
+            expression();
+            out += " do\n";
+            indent(level + 1);
+            statement(level + 1);
+        } else {
+            block(level);
+        }
+    }
+
+    void block(size_t level) {
+        out += "begin";
+        size_t statements = next(MAX_BLOCK + 1);
+        for (size_t i = 0; i < statements; i++) {
+            out += i == 0 ? "\n" : ";\n";
+            indent(level + 1);
+            statement(level + 1);
+        }
+        out += '\n';
+        indent(level);
+        out += "end";
+    }
+
+    void assignment() {
+        identifier();
+        if (chance(20)) {
+            out += '[';
+            expression();
+            out += ']';
+        }
+        out += " := ";
+        expression();
+    }
+
+    void call() {
+        identifier();
+        out += '(';
+        size_t arguments = next(MAX_LIST + 1);
+        for (size_t i = 0; i < arguments; i++) {
+            if (i > 0) {
+                out += ", ";
+            }
+            expression();
+        }
+        out += ')';
+    }
+
+    /* ---------------- Expressions ---------------- */
+
+    /**
+     * An expression whose deepest operand is nested expressionDepth times in groupings, unary operators, calls
+     * and array indexes. The levels are written from the outside in with a stack of what closes them rather than
+     * by recursion, so any depth can be generated. The operands and arguments beside them (sides) are nested
+     * SIDE_DEPTH times at most. Only additions and multiplications join a level to its sides, a relation is only
+     * added at the top: the grammar allows one per expression.
+     */
+    void expression() {
+        std::vector<std::string> closings; // innermost last
+        bool afterUnary = false;           // a side in front would take the rest of the levels out of the unary operator
+        for (size_t level = 0; level < expressionDepth; level++) {
+            if (!afterUnary && chance(50)) {
+                sideFactor(sideDepth(level));
+                arithmetic();
+            }
+
+            std::string closing;
+            afterUnary = false;
+            switch (next(4)) {
+                case 0:
+                    out += '(';
+                    closing = ")";
+                    break;
+                case 1:
+                    out += chance(50) ? "-" : "not ";
+                    afterUnary = true;
+                    break;
+                case 2:
+                    identifier();
+                    out += '(';
+                    if (chance(30)) {
+                        sideExpression(sideDepth(level));
+                        out += ", ";
+                    }
+                    closing = detached([&] {
+                        if (chance(30)) {
+                            out += ", ";
+                            sideExpression(sideDepth(level));
+                        }
+                        out += ')';
+                    });
+                    break;
+                default:
+                    identifier();
+                    out += '[';
+                    closing = "]";
+            }
+
+            if (chance(30)) {
+                closing += detached([&] {
+                    arithmetic();
+                    sideFactor(sideDepth(level));
+                });
+            }
+            closings.push_back(std::move(closing));
+        }
+
+        operand();
+        while (!closings.empty()) {
+            out += closings.back();
+            closings.pop_back();
+        }
+
+        if (chance(25)) {
+            out += ' ';
+            out += RELATIONS[next(count(RELATIONS))];
+            out += ' ';
+            sideSimpleExpression(sideDepth(0));
+        }
+    }
+
+    /* the nesting left for the sides of a level */
+    size_t sideDepth(size_t level) { return level + 1 < expressionDepth ? std::min(SIDE_DEPTH, expressionDepth - level - 1) : 0; }
+
+    /* what fn writes, as a string instead of into the output */
+    template <typename Fn>
+    std::string detached(Fn fn) {
+        std::string result;
+        out.swap(result);
+        fn();
+        out.swap(result);
+        return result;
+    }
+
+    void arithmetic() {
+        out += ' ';
+        out += chance(50) ? ADDITIONS[next(count(ADDITIONS))] : MULTIPLICATIONS[next(count(MULTIPLICATIONS))];
+        out += ' ';
+    }
+
+    /* the sides nest depth more times at most */
+    void sideExpression(size_t depth) {
+        sideSimpleExpression(depth);
+        if (chance(25)) {
+            out += ' ';
+            out += RELATIONS[next(count(RELATIONS))];
+            out += ' ';
+            sideSimpleExpression(depth);
+        }
+    }
+
+    void sideSimpleExpression(size_t depth) {
+        sideTerm(depth);
+        for (size_t i = next(MAX_LIST); i > 0; i--) {
+            out += ' ';
+            out += ADDITIONS[next(count(ADDITIONS))];
+            out += ' ';
+            sideTerm(depth);
+        }
+    }
+
+    void sideTerm(size_t depth) {
+        sideFactor(depth);
+        for (size_t i = next(MAX_LIST); i > 0; i--) {
+            out += ' ';
+            out += MULTIPLICATIONS[next(count(MULTIPLICATIONS))];
+            out += ' ';
+            sideFactor(depth);
+        }
+    }
+
+    void sideFactor(size_t depth) {
+        if (depth == 0 || !chance(20)) {
+            operand();
+            return;
+        }
+
+        switch (next(4)) {
+            case 0:
+                out += '(';
+                sideExpression(depth - 1);
+                out += ')';
+                break;
+            case 1:
+                out += chance(50) ? "-" : "not ";
+                sideFactor(depth - 1);
+                break;
+            case 2:
+                identifier();
+                arguments(depth - 1);
+                break;
+            default:
+                identifier();
+                out += '[';
+                sideExpression(depth - 1);
+                out += ']';
+        }
+    }
+
+    void arguments(size_t depth) {
+        out += '(';
+        size_t arguments = next(MAX_LIST + 1);
+        for (size_t i = 0; i < arguments; i++) {
+            if (i > 0) {
+                out += ", ";
+            }
+            sideExpression(depth);
+        }
+        out += ')';
+    }
+
+    /* a literal or a variable */
+    void operand() {
+        switch (next(8)) {
+            case 0:
+            case 1:
+                integer();
+                break;
+            case 2:
+                integer();
+                out += '.';
+                out += std::to_string(next(100));
+                break;
+            case 3:
+                out += chance(50) ? "true" : "false";
+                break;
+            case 4:
+                out += '\'';
+                identifier();
+                out += '\'';
+                break;
+            default:
+                identifier();
+        }
+    }
+};
+
+/* a count, with an optional K, M or G (powers of 1024) if units are allowed; false if the text is none or too large */
+static bool parseCount(const char* text, bool units, size_t& result) {
+    if (*text < '0' || *text > '9') {
+        return false; // strtoull would skip spaces and take a sign
+    }
+    char* end;
+    errno = 0;
+    unsigned long long count = strtoull(text, &end, 10);
+    size_t unit = 1;
+    switch (units ? *end : 0) {
+        case 'G': case 'g': unit *= 1024;
+        case 'M': case 'm': unit *= 1024;
+        case 'K': case 'k': unit *= 1024;
+            end++;
+    }
+    if (*end != 0 || errno == ERANGE || count > SIZE_MAX / unit) {
+        return false;
+    }
+    result = count * unit;
+    return true;
+}
+
+static int usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--seed=N] [--size=N[K|M|G]] [--methods=N] [--statement-depth=N] "
+              << "[--expression-depth=N] [--vocabulary=N]" << std::endl;
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    OutputSink output(STDOUT_FILENO);
+    Generator generator(&output);
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = strchr(argv[i], '=');
+        if (value == NULL) {
+            return usage(argv[0]);
+        }
+        std::string option(argv[i], value++ - argv[i]);
+
+        size_t count = 0;
+        if (option == "--size" || option == "--methods" || option == "--vocabulary") {
+            if (!parseCount(value, true, count) || count == 0) {
+                usage(argv[0]);
+                std::cerr << option << " takes a positive number, not \"" << value << "\"" << std::endl;
+                return -1;
+            }
+        } else if (option == "--seed" || option == "--statement-depth" || option == "--expression-depth") {
+            if (!parseCount(value, false, count)) {
+                usage(argv[0]);
+                std::cerr << option << " takes a number, not \"" << value << "\"" << std::endl;
+                return -1;
+            }
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return -1;
+        }
+
+        if (option == "--seed") {
+            generator.seed = count;
+        } else if (option == "--size") {
+            generator.size = count;
+        } else if (option == "--methods") {
+            generator.methods = count;
+        } else if (option == "--statement-depth") {
+            generator.statementDepth = count;
+        } else if (option == "--expression-depth") {
+            generator.expressionDepth = count;
+        } else {
+            generator.vocabulary = count;
+        }
+    }
+
+    generator.generate();
+    output.flush();
+    if (generator.size > 0 && generator.written() / 2 > generator.size) {
+        std::cerr << "Warning: wrote " << generator.written() << " bytes, --size=" << generator.size << " is a lower bound "
+                  << "(the declarations and a statement at least per method, methods: " << generator.methods << ")" << std::endl;
+    }
+    return output.good() ? 0 : 1;
+}
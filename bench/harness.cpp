@@ -0,0 +1,247 @@
+/* The phases of a parse timed one by one on a fixed corpus (see `make bench`): tokenization alone (yylex, or the
+   SIMD lexer), Parser::program(), AST2Text, AST2Dot (both streamed to /dev/null) and the destruction of the
+   AST. Every repetition runs each phase over the whole corpus, the medians and 95th percentiles of those times
+   are written to a JSON file together with the tokens per second and the peak RSS of the process. With a
+   baseline (an earlier results file) every median is compared with it, a phase that got slower by more than the
+   threshold fails the run.
+   Usage: harness [--repetitions=N] [--output=results.json] [--baseline=baseline.json] [--threshold=percent]
+                  [--lexer=flex|simd] <file.pas>... */
+
+#include "parser/Parser.h"
+#include "lsp/Json.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const PHASES[] = { "lex", "parse", "ast2text", "ast2dot", "destroy" };
+static const size_t PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+enum Phase { LEX, PARSE, AST2TEXT, AST2DOT, DESTROY };
+
+struct Result {
+    double median = 0; // ms for the whole corpus
+    double p95 = 0;
+};
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double percentile(std::vector<double> times, double p) {
+    std::sort(times.begin(), times.end());
+    return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+}
+
+/* one repetition: every phase over every file, the times are added to the ones of the phases */
+static bool repeat(const std::vector<std::string>& paths, const std::vector<SourceFile*>& sources, LexerKind lexerKind,
+                   OutputSink& discard, double (&times)[PHASE_COUNT], size_t& tokens) {
+    tokens = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        auto start = Clock::now();
+        Lexer* lexer = Parser::createLexer(sources[i], lexerKind);
+        while (lexer->next() != 0) {
+            tokens++;
+        }
+        delete lexer;
+        times[LEX] += millisecondsSince(start);
+
+        // the program takes over its source, so it is mapped again for every parse
+        SourceFile* source = SourceFile::map(paths[i].c_str());
+        Parser parser(source, lexerKind);
+        start = Clock::now();
+        Program* prog;
+        try {
+            prog = parser.program();
+        } catch (SyntaxException ex) {
+            std::cerr << paths[i] << ": syntax error: " << ex.what() << std::endl;
+            return false;
+        }
+        times[PARSE] += millisecondsSince(start);
+
+        start = Clock::now();
+        {
+            AST2Text ast2text(&discard);
+            ast2text.visit(prog);
+            discard.flush();
+        }
+        times[AST2TEXT] += millisecondsSince(start);
+
+        start = Clock::now();
+        {
+            AST2Dot ast2dot(&discard);
+            ast2dot.visit(prog);
+            discard.flush();
+        }
+        times[AST2DOT] += millisecondsSince(start);
+
+        start = Clock::now();
+        delete prog;
+        times[DESTROY] += millisecondsSince(start);
+    }
+    return true;
+}
+
+static void writeResults(const char* path, const std::vector<std::string>& paths, size_t bytes, size_t tokens,
+                         LexerKind lexerKind, size_t repetitions, long peakRSS, const Result (&results)[PHASE_COUNT]) {
+    // one phase per line, so that two results files can be compared with diff as well
+    std::ofstream out(path);
+    out << std::setprecision(6);
+    out << "{\n";
+    out << "  \"corpus\": {\"files\": " << paths.size() << ", \"bytes\": " << bytes << ", \"tokens\": " << tokens << "},\n";
+    out << "  \"lexer\": \"" << (lexerKind == LexerKind::SIMD ? "simd" : "flex") << "\",\n";
+    out << "  \"repetitions\": " << repetitions << ",\n";
+    out << "  \"peak_rss_kb\": " << peakRSS << ",\n";
+    out << "  \"phases\": {\n";
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        out << "    \"" << PHASES[phase] << "\": {\"median_ms\": " << results[phase].median << ", \"p95_ms\": " << results[phase].p95
+            << ", \"tokens_per_s\": " << tokens / (results[phase].median / 1000) << "}" << (phase + 1 < PHASE_COUNT ? ",\n" : "\n");
+    }
+    out << "  }\n";
+    out << "}\n";
+}
+
+/* prints the change of every median against the baseline, returns the number of phases slower than the threshold allows */
+static size_t compare(const char* path, size_t tokens, long peakRSS, const Result (&results)[PHASE_COUNT], double threshold) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "No baseline at " << path << " yet (make bench-baseline stores one)" << std::endl;
+        return 0;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+
+    LSP::Json::Value baseline;
+    try {
+        baseline = LSP::Json::Parser::parse(content.str());
+    } catch (LSP::Json::ParseError ex) {
+        std::cerr << path << ": " << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (baseline["corpus"]["tokens"].integer() != static_cast<int64_t>(tokens)) {
+        std::cout << "The baseline was measured on a different corpus (" << baseline["corpus"]["tokens"].integer()
+                  << " tokens instead of " << tokens << "), the times are not comparable" << std::endl;
+    }
+
+    size_t regressions = 0;
+    std::cout << "against " << path << " (a phase fails above +" << threshold << " %):" << std::endl;
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        double before = baseline["phases"][PHASES[phase]]["median_ms"].number;
+        if (before <= 0) {
+            std::cout << "  " << std::setw(8) << PHASES[phase] << ": not in the baseline" << std::endl;
+            continue;
+        }
+
+        double change = (results[phase].median / before - 1) * 100;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::cout << "  " << std::setw(8) << PHASES[phase] << ": " << before << " ms -> " << results[phase].median << " ms ("
+                  << std::showpos << change << std::noshowpos << " %)" << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+
+    double rssBefore = baseline["peak_rss_kb"].number;
+    if (rssBefore > 0) {
+        std::cout << "  peak RSS: " << rssBefore << " KB -> " << peakRSS << " KB (" << std::showpos
+                  << (peakRSS / rssBefore - 1) * 100 << std::noshowpos << " %)" << std::endl;
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    size_t repetitions = 20;
+    const char* output = "bench/results.json";
+    const char* baseline = NULL;
+    double threshold = 10;
+    LexerKind lexerKind = LexerKind::FLEX;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--repetitions=", 14) == 0) {
+            repetitions = std::max(1, atoi(argv[i] + 14));
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            output = argv[i] + 9;
+        } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline = argv[i] + 11;
+        } else if (strncmp(argv[i], "--threshold=", 12) == 0) {
+            threshold = atof(argv[i] + 12);
+        } else if (strcmp(argv[i], "--lexer=simd") == 0) {
+            lexerKind = LexerKind::SIMD;
+        } else if (strcmp(argv[i], "--lexer=flex") == 0) {
+            lexerKind = LexerKind::FLEX;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--repetitions=N] [--output=results.json] [--baseline=baseline.json] "
+                  << "[--threshold=percent] [--lexer=flex|simd] <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    // the sources the lexer phase scans, mapped once
+    std::vector<SourceFile*> sources;
+    size_t bytes = 0;
+    for (const std::string& path : paths) {
+        SourceFile* source = SourceFile::map(path.c_str());
+        if (source == NULL) {
+            std::cerr << "Cannot open " << path << std::endl;
+            return -1;
+        }
+        sources.push_back(source);
+        bytes += source->size;
+    }
+
+    int devNull = open("/dev/null", O_WRONLY);
+    OutputSink discard(devNull);
+
+    // one repetition to warm up, not counted
+    double warmup[PHASE_COUNT] = {};
+    size_t tokens;
+    if (!repeat(paths, sources, lexerKind, discard, warmup, tokens)) {
+        return -1;
+    }
+
+    std::vector<double> times[PHASE_COUNT];
+    for (size_t r = 0; r < repetitions; r++) {
+        double repetition[PHASE_COUNT] = {};
+        repeat(paths, sources, lexerKind, discard, repetition, tokens);
+        for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+            times[phase].push_back(repetition[phase]);
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long peakRSS = usage.ru_maxrss;
+
+    Result results[PHASE_COUNT];
+    std::cout << paths.size() << " files, " << bytes / (1024.0 * 1024.0) << " MB, " << tokens << " tokens, "
+              << repetitions << " repetitions, peak RSS " << peakRSS << " KB" << std::endl;
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        results[phase].median = percentile(times[phase], 0.5);
+        results[phase].p95 = percentile(times[phase], 0.95);
+        std::cout << "  " << std::setw(8) << PHASES[phase] << ": median " << results[phase].median << " ms, p95 "
+                  << results[phase].p95 << " ms, " << tokens / (results[phase].median / 1000) << " tokens/s" << std::endl;
+    }
+
+    writeResults(output, paths, bytes, tokens, lexerKind, repetitions, peakRSS, results);
+    std::cout << "written to " << output << std::endl;
+
+    for (SourceFile* source : sources) {
+        delete source;
+    }
+    close(devNull);
+
+    if (baseline != NULL && compare(baseline, tokens, peakRSS, results, threshold) > 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+/* Keystrokes on a Document (see `make bench-incremental`): sessions that each type a statement into a random
+   method of the file character by character and delete it again the same way, every keystroke reparsed
+   incrementally and timed. Most states in between do not parse, those are counted as syntax errors. Full
+   parses of the same text are timed now and then for comparison. With --verify the program (or all errors)
+   after every keystroke is compared with the ones of a full parse, which is slow on large files.
+   Usage: incremental <file.pas> [keystrokes] [--verify] */
+
+#include "parser/Parser.h"
+#include "parser/Document.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* TYPED = "\n    q := 1;";
+static const size_t SEED = 20;
+static const size_t FULL_PARSE_EVERY = 100; // keystrokes between the full parses timed for comparison
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double percentile(std::vector<double>& times, double p) {
+    std::sort(times.begin(), times.end());
+    return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+}
+
+static void report(const char* what, std::vector<double> times) {
+    double sum = 0;
+    for (double time : times) {
+        sum += time;
+    }
+    std::cout << what << ": mean " << sum / times.size() << " ms, p50 " << percentile(times, 0.5) << " ms, p99 "
+              << percentile(times, 0.99) << " ms, max " << times.back() << " ms (" << times.size() << " timed)" << std::endl;
+}
+
+/* the text and line of every token of a program, in the order they appear */
+class TokenLines : public ASTVisitor<TokenLines> {
+public:
+    std::string result;
+
+    void visitProgram(Program* prog) {
+        token(prog->identifier);
+        variables(prog->declarations);
+        for (const auto& meth : prog->methods) visit(meth);
+        visit(prog->main);
+    }
+    void visitMethod(Method* meth) {
+        token(meth->identifier);
+        variables(meth->arguments);
+        variables(meth->declarations);
+        if (meth->returnType != NULL) type(*meth->returnType);
+        visit(meth->block);
+    }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        token(stmt->identifier);
+        if (stmt->arrayIndex != NULL) visit(stmt->arrayIndex);
+        visit(stmt->value);
+    }
+    void visitCall(Stmt::Call* stmt) {
+        token(stmt->callee);
+        for (const auto& argExpr : stmt->arguments) visit(argExpr);
+    }
+    void visitIf(Stmt::If* stmt) {
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) visit(stmt->elseBody);
+    }
+    void visitWhile(Stmt::While* stmt) {
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+    void visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) visit(stmtInside);
+    }
+
+    void visitBinary(Expr::Binary* expr) {
+        visit(expr->left);
+        token(expr->op);
+        visit(expr->right);
+    }
+    void visitCall(Expr::Call* expr) {
+        token(expr->callee);
+        for (const auto& argExpr : expr->arguments) visit(argExpr);
+    }
+    void visitGrouping(Expr::Grouping* expr) { visit(expr->expression); }
+    void visitIdentifier(Expr::Identifier* expr) {
+        token(expr->token);
+        if (expr->arrayIndexExpression != NULL) visit(expr->arrayIndexExpression);
+    }
+    void visitLiteral(Expr::Literal* expr) { token(expr->token); }
+    void visitUnary(Expr::Unary* expr) {
+        token(expr->op);
+        visit(expr->right);
+    }
+
+private:
+    void token(const Token& token) {
+        result += std::to_string(token.lineNumber);
+        result += ':';
+        result += token.text();
+        result += ' ';
+    }
+    void variables(const ArenaVector<Variable*>& variables) {
+        for (Variable* variable : variables) {
+            token(variable->name);
+            type(*variable->type);
+        }
+    }
+    void type(const Variable::VariableType& type) {
+        token(type.typeName);
+        if (type.kind == Variable::VariableType::Kind::ARRAY) {
+            token(static_cast<const Variable::VariableTypeArray&>(type).startRange);
+            token(static_cast<const Variable::VariableTypeArray&>(type).stopRange);
+        }
+    }
+};
+
+/* the tree and the lines of its tokens */
+static std::string describe(Program* prog) {
+    AST2Text ast2text;
+    ast2text.visit(prog);
+    TokenLines lines;
+    lines.visit(prog);
+    return ast2text.getResult() + "\n" + lines.result;
+}
+
+/* all syntax errors, one per line */
+static std::string describe(const std::vector<SyntaxException>& errors) {
+    std::string result;
+    for (const SyntaxException& ex : errors) {
+        result += std::to_string(ex.lineNumber) + ": " + ex.what() + "\n";
+    }
+    return result;
+}
+
+/* a full parse of the text, timed */
+static std::string parseFully(std::string_view text, double& time) {
+    auto start = Clock::now();
+    Parser parser(SourceFile::copy(text));
+    parser.recovering = true;
+    Program* prog = parser.program();
+    time = millisecondsSince(start);
+    std::string result = parser.errors.empty() ? describe(prog) : describe(parser.errors);
+    delete prog;
+    return result;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> [keystrokes] [--verify]" << std::endl;
+        return -1;
+    }
+
+    size_t keystrokes = 2000;
+    bool verify = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else {
+            keystrokes = std::stoul(argv[i]);
+        }
+    }
+
+    std::ifstream file(argv[1]);
+    if (!file) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return -1;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+
+    Document doc(content.str());
+    auto start = Clock::now();
+    try {
+        doc.parse();
+    } catch (SyntaxException ex) {
+        std::cerr << argv[1] << ": syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+    double initial = millisecondsSince(start);
+
+    std::string_view text = doc.text();
+    size_t lineCount = std::count(text.begin(), text.end(), '\n');
+    std::cout << argv[1] << ": " << lineCount << " lines, " << doc.program()->methods.size() << " methods, parsed in "
+              << initial << " ms" << std::endl;
+
+    std::mt19937 random(SEED);
+    std::vector<double> edits, programs, fulls;
+    size_t errors = 0, mismatches = 0;
+    size_t typedLength = strlen(TYPED);
+
+    for (size_t keystroke = 0; keystroke < keystrokes; ) {
+        // right behind the begin of a random method
+        size_t method = std::uniform_int_distribution<size_t>(0, doc.program()->methods.size() - 1)(random);
+        size_t at = doc.text().find("begin", doc.methodStart(method)) + strlen("begin");
+
+        for (size_t step = 0; step < 2 * typedLength && keystroke < keystrokes; step++, keystroke++) {
+            bool typing = step < typedLength;
+            std::string_view inserted = typing ? std::string_view(TYPED + step, 1) : std::string_view();
+            size_t offset = typing ? at + step : at + 2 * typedLength - step - 1;
+
+            std::string error;
+            auto start = Clock::now();
+            try {
+                doc.edit(offset, typing ? 0 : 1, inserted);
+            } catch (SyntaxException ex) {
+                error = ex.what();
+                errors++;
+            }
+            edits.push_back(millisecondsSince(start));
+
+            start = Clock::now();
+            Program* prog = doc.program();
+            programs.push_back(millisecondsSince(start));
+
+            if (verify) {
+                double time;
+                std::string expected = parseFully(doc.text(), time);
+                std::string actual = error.empty() ? describe(prog) : describe(doc.errors);
+                if (actual != expected) {
+                    if (mismatches++ == 0) {
+                        std::cerr << "Keystroke " << keystroke << " differs from a full parse:\n" << actual.substr(0, 300)
+                                  << "\ninstead of\n" << expected.substr(0, 300) << std::endl;
+                    }
+                }
+            } else if (keystroke % FULL_PARSE_EVERY == 0) {
+                double time;
+                parseFully(doc.text(), time);
+                fulls.push_back(time);
+            }
+        }
+    }
+
+    std::cout << keystrokes << " keystrokes, " << errors << " left a syntax error, " << doc.incrementalParses
+              << " incremental and " << doc.fullParses << " full parses" << std::endl;
+    report("edit", edits);
+    report("program() (line numbers after a line was added or removed)", programs);
+    if (!fulls.empty()) {
+        report("full parse, for comparison", fulls);
+    }
+
+    if (verify) {
+        std::cout << (mismatches == 0 ? "every keystroke matches a full parse" : std::to_string(mismatches) + " keystrokes differ from a full parse")
+                  << std::endl;
+        return mismatches == 0 ? 0 : 1;
+    }
+}
@@ -0,0 +1,86 @@
+/* Compares the ways of getting a file into the parser: read through stdio (flex buffering, texts copied into the
+   interner), mapped and scanned in place by flex or the SIMD lexer, either interleaved with parsing or lexed into
+   a token buffer first. Usage: input <file.pas> [repetitions] */
+
+#include "parser/Parser.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/* parses once and returns the time taken in seconds */
+static double parse(Parser& p) {
+    auto start = Clock::now();
+
+    Program* prog = p.program();
+    double seconds = secondsSince(start);
+
+    delete prog;
+    return seconds;
+}
+
+static void report(const char* mode, double seconds, size_t bytes, size_t tokens) {
+    std::cout << mode << ": " << seconds * 1000 << " ms, " << bytes / (1024.0 * 1024.0) / seconds << " MB/s, "
+              << tokens / seconds << " tokens/s" << std::endl;
+}
+
+/* scans the whole file into a token buffer first and parses from there */
+static void lexThenParse(const char* mode, const char* path, LexerKind lexerKind) {
+    SourceFile* source = SourceFile::map(path);
+    size_t bytes = source->size;
+
+    auto lexStart = Clock::now();
+    Lexer* lexer = Parser::createLexer(source, lexerKind);
+    TokenBuffer tokens(*lexer);
+    delete lexer;
+    double lexTime = secondsSince(lexStart);
+
+    Parser p(&tokens, source);
+    double parseTime = parse(p);
+
+    report(mode, lexTime + parseTime, bytes, p.tokenCount);
+    std::cout << "    (lex " << lexTime * 1000 << " ms, parse " << parseTime * 1000 << " ms)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> [repetitions]" << std::endl;
+        return -1;
+    }
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    try {
+        for (int i = 0; i < repetitions; i++) {
+            FILE* input = fopen(argv[1], "r");
+            if (input == NULL) {
+                std::cerr << "Cannot open " << argv[1] << std::endl;
+                return -1;
+            }
+
+            Parser streamParser(input);
+            double streamTime = parse(streamParser);
+            size_t bytes = ftell(input);
+            fclose(input);
+
+            Parser mappedParser(SourceFile::map(argv[1]));
+            double mappedTime = parse(mappedParser);
+
+            Parser simdParser(SourceFile::map(argv[1]), LexerKind::SIMD);
+            double simdTime = parse(simdParser);
+
+            report("stdio                      ", streamTime, bytes, streamParser.tokenCount);
+            report("mmap                       ", mappedTime, bytes, mappedParser.tokenCount);
+            report("mmap + SIMD                ", simdTime, bytes, simdParser.tokenCount);
+            lexThenParse("mmap, lex then parse       ", argv[1], LexerKind::FLEX);
+            lexThenParse("mmap + SIMD, lex then parse", argv[1], LexerKind::SIMD);
+        }
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+}
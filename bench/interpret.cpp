@@ -0,0 +1,65 @@
+/* Evaluation speed of the tree-walking interpreter: resolves and runs every given program (bench/programs has
+   a suite of compute heavy ones) and reports the time of both, the output of the programs goes to stdout.
+   Usage: interpret <file.pas>... */
+
+#include "parser/Parser.h"
+#include "interpreter/Interpreter.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    double total = 0;
+    for (int i = 1; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cerr << argv[i] << ": syntax error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        OutputSink output(STDOUT_FILENO);
+        try {
+            auto start = Clock::now();
+            Interpreter interpreter(prog, &output);
+            double resolveTime = millisecondsSince(start);
+
+            start = Clock::now();
+            interpreter.run();
+            double runTime = millisecondsSince(start);
+            total += runTime;
+
+            output.flush();
+            std::cout << argv[i] << ": resolved and set up in " << resolveTime << " ms, ran in " << runTime << " ms" << std::endl;
+        } catch (SemanticException ex) {
+            std::cerr << argv[i] << ": semantic error: " << ex.what() << std::endl;
+            return -1;
+        } catch (RuntimeException ex) {
+            std::cerr << argv[i] << ": runtime error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        delete prog;
+    }
+
+    std::cout << "total: " << total << " ms" << std::endl;
+}
@@ -0,0 +1,71 @@
+/* Cost of the SSA IR: lowering every given program (bench/scaled.pas is a large generated one) and running the
+   standard passes over it, each timed on its own with the instructions before and after it. With --verify the
+   IR is checked after the builder and after every pass (which costs more than the passes themselves).
+   Usage: ir [--verify] <file.pas>... */
+
+#include "parser/Parser.h"
+#include "ir/Builder.h"
+#include "ir/Passes.h"
+
+#include <string.h>
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    int first = 1;
+    bool verify = argc > 1 && strcmp(argv[1], "--verify") == 0;
+    if (verify) {
+        first++;
+    }
+
+    if (argc <= first) {
+        std::cerr << "Usage: " << argv[0] << " [--verify] <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    for (int i = first; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cout << argv[i] << ": skipped, syntax error" << std::endl;
+            continue;
+        }
+
+        try {
+            auto start = Clock::now();
+            IR::Builder builder(prog);
+            std::unique_ptr<IR::Module> module(builder.build());
+            double buildTime = millisecondsSince(start);
+
+            std::cout << argv[i] << ": resolved and lowered in " << buildTime << " ms, " << module->functions.size()
+                      << " functions, " << module->size() << " instructions" << std::endl;
+
+            IR::PassManager passes = IR::PassManager::standard();
+            passes.verify = verify;
+            passes.run(*module);
+            passes.report(std::cout);
+        } catch (SemanticException ex) {
+            std::cout << argv[i] << ": skipped, semantic error: " << ex.what() << std::endl;
+        } catch (std::logic_error ex) {
+            std::cerr << argv[i] << ": " << ex.what() << std::endl;
+            return -1;
+        }
+
+        delete prog;
+    }
+}
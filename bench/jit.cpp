@@ -0,0 +1,101 @@
+/* Native code against interpretation: runs every given program (bench/programs) on the tree-walking interpreter,
+   which is the reference, on the bytecode VM and on the VM with the JIT, checks that all three print the same (a
+   runtime error that ends a program counts as printed) and reports the times and speedups. Usage: jit <file.pas>... */
+
+#include "parser/Parser.h"
+#include "interpreter/Interpreter.h"
+#include "bytecode/Compiler.h"
+#include "bytecode/VM.h"
+#include "jit/JIT.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* compiles prog to bytecode (and native code if jit is set) and runs it, returns the time including compilation */
+static double runCompiled(Program* prog, bool jit, OutputSink* output, size_t* nativeFunctions) {
+    auto start = Clock::now();
+    std::unique_ptr<Bytecode::Module> module(Bytecode::Compiler(prog).compile());
+    JIT::Compiler compiler(module.get());
+    if (jit) {
+        *nativeFunctions = compiler.compile();
+    }
+
+    Bytecode::VM vm(module.get(), output);
+    try {
+        vm.run();
+    } catch (RuntimeException ex) {
+        *output << "Runtime error: " << ex.what() << "\n";
+    }
+    return millisecondsSince(start);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    double interpreterTotal = 0, vmTotal = 0, jitTotal = 0;
+    for (int i = 1; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cerr << argv[i] << ": syntax error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        try {
+            OutputSink reference;
+            auto start = Clock::now();
+            Interpreter interpreter(prog, &reference);
+            try {
+                interpreter.run();
+            } catch (RuntimeException ex) {
+                reference << "Runtime error: " << ex.what() << "\n";
+            }
+            double interpreterTime = millisecondsSince(start);
+
+            OutputSink vmOutput, jitOutput;
+            size_t nativeFunctions = 0;
+            double vmTime = runCompiled(prog, false, &vmOutput, &nativeFunctions);
+            double jitTime = runCompiled(prog, true, &jitOutput, &nativeFunctions);
+
+            if (vmOutput.result() != reference.result() || jitOutput.result() != reference.result()) {
+                std::cerr << argv[i] << ": the " << (vmOutput.result() != reference.result() ? "VM" : "JIT")
+                          << " printed something else than the interpreter" << std::endl;
+                return -1;
+            }
+
+            interpreterTotal += interpreterTime;
+            vmTotal += vmTime;
+            jitTotal += jitTime;
+            std::cout << argv[i] << ": " << nativeFunctions << "/" << prog->methods.size() << " methods native, interpreter "
+                      << interpreterTime << " ms, vm " << vmTime << " ms, jit " << jitTime << " ms, "
+                      << interpreterTime / jitTime << "x over the interpreter, " << vmTime / jitTime << "x over the vm"
+                      << std::endl;
+        } catch (SemanticException ex) {
+            std::cerr << argv[i] << ": semantic error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        delete prog;
+    }
+
+    std::cout << "total: interpreter " << interpreterTotal << " ms, vm " << vmTotal << " ms, jit " << jitTotal << " ms, "
+              << interpreterTotal / jitTotal << "x over the interpreter, " << vmTotal / jitTotal << "x over the vm" << std::endl;
+}
@@ -0,0 +1,382 @@
+/* Scripted client of the language server (see `make bench-lsp`): opens the file in `pascal-parser --lsp`, types
+   a statement into a random method character by character and deletes it again (every keystroke waits for the
+   diagnostics of its version), then asks for the definition of a name in that method and for all symbols of the
+   file, and times each from sending to the answer. Last a burst of keystrokes with a definition request after
+   each is sent without waiting, which the server answers by dropping the requests that went stale.
+   With --pipelined (see `make testlsp`) it only sends initialize, didOpen, documentSymbol, shutdown and exit at
+   once, the way a script does, and checks that every request is answered and the server exits with 0.
+   Usage: lsp <pascal-parser> <file.pas> [keystrokes] or lsp --pipelined <pascal-parser> <file.pas> */
+
+#include "lsp/Json.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using LSP::Json::Value;
+using LSP::Json::Writer;
+
+static const char* TYPED = "\n    q := 1;";
+static const char* URI = "file:///bench.pas";
+static const size_t SEED = 21;
+static const int CONTENT_MODIFIED = -32801;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double millisecondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void report(const char* what, std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (double time : times) {
+        sum += time;
+    }
+    auto percentile = [&](double p) { return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))]; };
+    std::cout << what << ": mean " << sum / times.size() << " ms, p50 " << percentile(0.5) << " ms, p99 "
+              << percentile(0.99) << " ms, max " << times.back() << " ms (" << times.size() << " timed)" << std::endl;
+}
+
+/* the server as a child process, talked to through pipes */
+class Connection {
+public:
+    Connection(const char* server) {
+        int toServer[2], fromServer[2];
+        if (pipe(toServer) != 0 || pipe(fromServer) != 0) {
+            throw std::runtime_error("Cannot create pipes");
+        }
+
+        pid = fork();
+        if (pid == 0) {
+            dup2(toServer[0], STDIN_FILENO);
+            dup2(fromServer[1], STDOUT_FILENO);
+            close(toServer[1]);
+            close(fromServer[0]);
+            execl(server, server, "--lsp", (char*) NULL);
+            _exit(127);
+        }
+        close(toServer[0]);
+        close(fromServer[1]);
+        out = fdopen(toServer[1], "w");
+        in = fdopen(fromServer[0], "r");
+    }
+
+    void send(const std::string& body) {
+        fprintf(out, "Content-Length: %zu\r\n\r\n", body.size());
+        fwrite(body.data(), 1, body.size(), out);
+        fflush(out);
+    }
+
+    Value receive() {
+        Value message;
+        if (!tryReceive(message)) {
+            throw std::runtime_error("Server closed the connection");
+        }
+        return message;
+    }
+
+    /* the next message, false once the server closed its output */
+    bool tryReceive(Value& message) {
+        char line[256];
+        size_t length = 0;
+        while (fgets(line, sizeof(line), in) != NULL && strcmp(line, "\r\n") != 0) {
+            if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                length = strtoul(line + 15, NULL, 10);
+            }
+        }
+        std::string body(length, '\0');
+        if (length == 0 || fread(&body[0], 1, length, in) != length) {
+            return false;
+        }
+        received = Clock::now();
+        message = LSP::Json::Parser::parse(body);
+        return true;
+    }
+
+    /* the response to the request with the id, diagnostics are counted on the way */
+    Value response(int64_t id) {
+        while (true) {
+            Value message = receive();
+            if (message["id"].type == Value::Type::NUMBER && message["id"].integer() == id) {
+                return message;
+            }
+            diagnostics += message["method"].string == "textDocument/publishDiagnostics";
+        }
+    }
+
+    /* waits for the diagnostics of the version, returns how many errors they have */
+    size_t diagnosticsOf(int64_t version) {
+        while (true) {
+            Value message = receive();
+            if (message["method"].string == "textDocument/publishDiagnostics") {
+                diagnostics++;
+                if (message["params"]["version"].integer() == version) {
+                    return message["params"]["diagnostics"].array.size();
+                }
+            }
+        }
+    }
+
+    int finish() {
+        fclose(out);
+        fclose(in);
+        int status;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    size_t diagnostics = 0;
+    Clock::time_point received; // when the last message was read, before it was parsed
+
+private:
+    pid_t pid;
+    FILE* out;
+    FILE* in;
+};
+
+static std::string notification(const char* method, const std::function<void(Writer&)>& params) {
+    Writer writer;
+    writer.beginObject().key("jsonrpc").value("2.0").key("method").value(method).key("params");
+    params(writer);
+    return writer.endObject().out;
+}
+
+static std::string request(int64_t id, const char* method, const std::function<void(Writer&)>& params) {
+    Writer writer;
+    writer.beginObject().key("jsonrpc").value("2.0").key("id").value(id).key("method").value(method).key("params");
+    params(writer);
+    return writer.endObject().out;
+}
+
+static void position(Writer& writer, size_t line, size_t character) {
+    writer.beginObject().key("line").value(line).key("character").value(character).endObject();
+}
+
+/* one keystroke: the text at the position replaced by (at most one) character */
+static std::string keystroke(int64_t version, size_t line, size_t character, size_t endLine, size_t endCharacter, std::string_view text) {
+    return notification("textDocument/didChange", [&](Writer& writer) {
+        writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).key("version").value(version).endObject()
+              .key("contentChanges").beginArray().beginObject().key("range").beginObject()
+              .key("start");
+        position(writer, line, character);
+        writer.key("end");
+        position(writer, endLine, endCharacter);
+        writer.endObject().key("text").value(text).endObject().endArray().endObject();
+    });
+}
+
+static std::string definition(int64_t id, size_t line, size_t character) {
+    return request(id, "textDocument/definition", [&](Writer& writer) {
+        writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).endObject().key("position");
+        position(writer, line, character);
+        writer.endObject();
+    });
+}
+
+/* the whole session sent before anything is read: every request has to be answered, shutdown included */
+static int pipelined(const char* serverPath, const char* path, const std::string& text) {
+    signal(SIGPIPE, SIG_IGN);
+    Connection server(serverPath);
+    auto document = [](Writer& writer) {
+        writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).endObject().endObject();
+    };
+
+    server.send(request(1, "initialize", [](Writer& writer) { writer.beginObject().endObject(); }));
+    server.send(notification("textDocument/didOpen", [&](Writer& writer) {
+        writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).key("languageId").value("pascal")
+              .key("version").value(1).key("text").value(text).endObject().endObject();
+    }));
+    server.send(request(2, "textDocument/documentSymbol", document));
+    server.send(request(3, "shutdown", [](Writer& writer) { writer.null(); }));
+    server.send(notification("exit", [](Writer& writer) { writer.null(); }));
+
+    std::vector<bool> answered(4, false);
+    Value message;
+    while (server.tryReceive(message)) {
+        if (message["id"].type == Value::Type::NUMBER && message["id"].integer() > 0 && message["id"].integer() < 4) {
+            answered[message["id"].integer()] = true;
+        }
+    }
+    int status = server.finish();
+
+    bool passed = status == 0;
+    for (int64_t id = 1; id < 4; id++) {
+        if (!answered[id]) {
+            std::cerr << path << ": request " << id << " was not answered" << std::endl;
+            passed = false;
+        }
+    }
+    if (status != 0) {
+        std::cerr << path << ": server exited with " << status << std::endl;
+    }
+    std::cout << path << ": pipelined session " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    bool pipelinedOnly = argc > 1 && strcmp(argv[1], "--pipelined") == 0;
+    if (pipelinedOnly) {
+        argv++;
+        argc--;
+    }
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <pascal-parser> <file.pas> [keystrokes] or " << argv[0]
+                  << " --pipelined <pascal-parser> <file.pas>" << std::endl;
+        return -1;
+    }
+    size_t keystrokes = argc > 3 ? std::stoul(argv[3]) : 2000;
+
+    std::ifstream file(argv[2]);
+    if (!file) {
+        std::cerr << "Cannot open " << argv[2] << std::endl;
+        return -1;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string text = content.str();
+    if (pipelinedOnly) {
+        return pipelined(argv[1], argv[2], text);
+    }
+
+    // behind the begin of every method (on the lines starting with function or procedure), the sessions leave the text as it was
+    std::vector<size_t> bodies;
+    for (size_t at = 0; at < text.size(); at = text.find('\n', at) + 1) {
+        size_t word = text.find_first_not_of(" \t", at);
+        if (word != std::string::npos && (text.compare(word, 9, "function ") == 0 || text.compare(word, 10, "procedure ") == 0)) {
+            bodies.push_back(text.find("begin", word) + strlen("begin"));
+        }
+        if (text.find('\n', at) == std::string::npos) {
+            break;
+        }
+    }
+    if (bodies.empty()) {
+        std::cerr << argv[2] << ": no methods" << std::endl;
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    Connection server(argv[1]);
+    int64_t id = 0;
+    int64_t version = 1;
+
+    server.send(request(++id, "initialize", [](Writer& writer) { writer.beginObject().endObject(); }));
+    server.response(id);
+    server.send(notification("initialized", [](Writer& writer) { writer.beginObject().endObject(); }));
+
+    auto start = Clock::now();
+    server.send(notification("textDocument/didOpen", [&](Writer& writer) {
+        writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).key("languageId").value("pascal")
+              .key("version").value(version).key("text").value(text).endObject().endObject();
+    }));
+    if (server.diagnosticsOf(version) != 0) {
+        std::cerr << argv[2] << ": the server reports a syntax error" << std::endl;
+        return -1;
+    }
+    std::cout << argv[2] << ": " << std::count(text.begin(), text.end(), '\n') << " lines, " << bodies.size()
+              << " methods, opened in " << millisecondsSince(start) << " ms" << std::endl;
+
+    std::mt19937 random(SEED);
+    std::vector<double> edits, definitions, symbols;
+    size_t errors = 0, found = 0;
+    size_t typedLength = strlen(TYPED);
+    std::string symbolsSize;
+
+    for (size_t done = 0; done < keystrokes; ) {
+        size_t at = bodies[std::uniform_int_distribution<size_t>(0, bodies.size() - 1)(random)];
+        size_t line = std::count(text.begin(), text.begin() + at, '\n');
+        size_t character = at - (text.rfind('\n', at - 1) + 1);
+
+        // the position in front of every typed character, and behind the last one
+        std::vector<std::pair<size_t, size_t>> positions = {{line, character}};
+        for (size_t i = 0; i < typedLength; i++) {
+            positions.push_back(TYPED[i] == '\n' ? std::make_pair(positions.back().first + 1, size_t(0))
+                                                 : std::make_pair(positions.back().first, positions.back().second + 1));
+        }
+
+        for (size_t step = 0; step < 2 * typedLength && done < keystrokes; step++, done++) {
+            bool typing = step < typedLength;
+            size_t index = typing ? step : 2 * typedLength - step - 1;
+            auto from = positions[index];
+            auto to = typing ? from : positions[index + 1];
+
+            start = Clock::now();
+            server.send(keystroke(++version, from.first, from.second, to.first, to.second,
+                                  typing ? std::string_view(TYPED + step, 1) : std::string_view()));
+            errors += server.diagnosticsOf(version) > 0;
+            edits.push_back(millisecondsBetween(start, server.received));
+        }
+
+        // the first variable assigned in the method body (the session is complete again)
+        size_t name = text.find(":=", at);
+        while (name > 0 && text[name - 1] == ' ') {
+            name--;
+        }
+        name = text.find_last_not_of("abcdefghijklmnopqrstuvwxyz_0123456789", name - 1) + 1;
+        size_t nameLine = std::count(text.begin() + at, text.begin() + name, '\n') + line;
+        size_t nameCharacter = name - (text.rfind('\n', name - 1) + 1);
+        start = Clock::now();
+        server.send(definition(++id, nameLine, nameCharacter));
+        found += !server.response(id)["result"].isNull();
+        definitions.push_back(millisecondsBetween(start, server.received));
+
+        start = Clock::now();
+        server.send(request(++id, "textDocument/documentSymbol", [](Writer& writer) {
+            writer.beginObject().key("textDocument").beginObject().key("uri").value(URI).endObject().endObject();
+        }));
+        Value result = server.response(id)["result"];
+        symbols.push_back(millisecondsBetween(start, server.received));
+        symbolsSize = std::to_string(result.array.size());
+    }
+
+    std::cout << edits.size() << " keystrokes (" << errors << " left a syntax error), " << definitions.size()
+              << " definitions (" << found << " found), " << symbols.size() << " symbol lists of " << symbolsSize << " symbols" << std::endl;
+    report("keystroke to diagnostics", edits);
+    report("definition", definitions);
+    report("document symbols", symbols);
+
+    // a burst: one session typed at once, asking for a definition after every keystroke
+    size_t at = bodies[0];
+    size_t line = std::count(text.begin(), text.begin() + at, '\n');
+    size_t character = at - (text.rfind('\n', at - 1) + 1);
+    size_t published = server.diagnostics;
+    int64_t firstRequest = id + 1;
+    start = Clock::now();
+    for (size_t step = 0; step < typedLength; step++) {
+        server.send(keystroke(++version, line, character, line, character, std::string_view(TYPED + step, 1)));
+        TYPED[step] == '\n' ? (line++, character = 0) : character++;
+        server.send(definition(++id, line, character));
+    }
+    size_t modified = 0;
+    for (int64_t request = firstRequest; request <= id; request++) {
+        modified += server.response(request)["error"]["code"].integer() == CONTENT_MODIFIED;
+    }
+    std::cout << "burst of " << typedLength << " keystrokes with a definition request after each: answered in "
+              << millisecondsSince(start) << " ms, " << modified << " requests dropped as stale, "
+              << server.diagnostics - published << " diagnostics published so far" << std::endl;
+
+    server.send(request(++id, "shutdown", [](Writer& writer) { writer.null(); }));
+    server.response(id);
+    server.send(notification("exit", [](Writer& writer) { writer.null(); }));
+    int status = server.finish();
+    if (status != 0) {
+        std::cerr << "Server exited with " << status << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,135 @@
+{ The algorithms of test-code/sample.pas with the variables it misses declared, repeated for a while }
+
+program algorithms;
+
+  var a, b, i, round, primes: integer;
+      x: array [1..100] of real;
+
+
+  { Calculate greatest common divisor of a and b }
+
+  function gcd (a, b: integer) : integer;
+  begin
+    while a*b <> 0 do
+    begin
+      if a > b then
+        a := a-b
+      else b := b-a
+    end;
+    if a = 0 then
+      gcd := b
+    else gcd := a
+  end;
+
+
+  { Calculate a factorial (a!) }
+
+  function factorial (a: integer) : integer;
+  var k, fact: integer;
+  begin
+    fact := 1;
+    k := 2;
+    while k <= a do
+    begin
+      fact := fact*k;
+      k := k+1
+    end;
+    factorial := fact
+  end;
+
+
+  { Calculate the sum of the first n numbers }
+
+  function sum (n: integer) : integer;
+    var s, k: integer;
+    begin
+      s := 0;
+      k := 1;
+      while k <= n do
+      begin
+        s := s+k;
+        k := k+1
+      end;
+      { verify if the sum is correct }
+      if s <> n*(n+1)/2 then
+        sum := -1
+      else sum := s
+    end;
+
+
+  { Determine if n is a prime number }
+
+  function is_prime (n: integer) : boolean;
+    var k: integer;
+        b: boolean;
+    begin
+      k := 2;
+      b := true;
+      while (k <= n div 2) and b do
+      begin
+        if n div k = n/k then
+          b := false;
+        k := k+1
+      end;
+    is_prime := b
+  end;
+
+
+  { Sort the first n elements of x }
+
+  procedure bubble_sort(n: integer);
+  var i: integer;
+      k: boolean;
+      t: real;
+  begin
+    k := true;
+    while k do
+    begin
+      i := 1;
+      k := false;
+      while i < n do
+      begin
+        if x[i] > x[i+1] then
+        begin
+          t := x[i];
+          x[i] := x[i+1];
+          x[i+1] := t;
+          k := true
+        end;
+        i := i+1
+      end
+    end
+  end;
+
+
+begin
+  round := 0;
+  while round < 20 do
+  begin
+    a := gcd(48 + round, 84);
+    b := factorial(a+19);
+    b := b - sum(1000 + round);
+
+    { count all prime numbers from 2 to 3000 }
+    primes := 0;
+    i := 2;
+    while i <= 3000 do
+    begin
+      if is_prime(i) then
+        primes := primes+1;
+      i := i+1
+    end;
+
+    i := 1;
+    while i <= 100 do
+    begin
+      x[i] := (100-i+1)*3.14;
+      i := i+1
+    end;
+    bubble_sort(100);
+
+    round := round+1
+  end;
+
+  writeln('gcd: ', a, ', factorial - sum: ', b, ', primes: ', primes, ', x[1]: ', x[1], ', x[100]: ', x[100])
+end.
@@ -0,0 +1,49 @@
+{ Small numeric functions of test-code/sample.pas called many times from the main block }
+
+program calls;
+
+  var i, checksum: integer;
+
+
+  { Calculate greatest common divisor of a and b }
+
+  function gcd (a, b: integer) : integer;
+  begin
+    while a*b <> 0 do
+    begin
+      if a > b then
+        a := a-b
+      else b := b-a
+    end;
+    if a = 0 then
+      gcd := b
+    else gcd := a
+  end;
+
+
+  { Calculate a factorial (a!) }
+
+  function factorial (a: integer) : integer;
+  var k, fact: integer;
+  begin
+    fact := 1;
+    k := 2;
+    while k <= a do
+    begin
+      fact := fact*k;
+      k := k+1
+    end;
+    factorial := fact
+  end;
+
+begin
+  checksum := 0;
+  i := 1;
+  while i <= 300000 do
+  begin
+    checksum := checksum + gcd(i - i div 1000 * 1000 + 1, 360) + factorial(i - i div 16 * 16);
+    i := i+1
+  end;
+
+  writeln('checksum: ', checksum)
+end.
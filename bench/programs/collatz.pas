@@ -0,0 +1,35 @@
+{ Longest Collatz chain: integer division and branches }
+
+program collatz;
+
+  var n, longest, start: integer;
+
+  function steps (n: integer) : integer;
+    var k: integer;
+  begin
+    k := 0;
+    while n <> 1 do
+    begin
+      if n - n div 2 * 2 = 0 then
+        n := n div 2
+      else n := 3*n + 1;
+      k := k+1
+    end;
+    steps := k
+  end;
+
+begin
+  longest := 0;
+  n := 1;
+  while n < 100000 do
+  begin
+    if steps(n) > longest then
+    begin
+      longest := steps(n);
+      start := n
+    end;
+    n := n+1
+  end;
+
+  writeln('longest chain below 100000 starts at ', start, ' (', longest, ' steps)')
+end.
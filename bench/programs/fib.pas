@@ -0,0 +1,17 @@
+{ Naive recursive Fibonacci numbers: calls and integer arithmetic }
+
+program fib;
+
+  var n: integer;
+
+  function fib (n: integer) : integer;
+  begin
+    if n < 2 then
+      fib := n
+    else fib := fib(n-1) + fib(n-2)
+  end;
+
+begin
+  n := 32;
+  writeln('fib(', n, ') = ', fib(n))
+end.
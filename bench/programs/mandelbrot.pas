@@ -0,0 +1,40 @@
+{ Points of a 300x200 grid inside the Mandelbrot set: real arithmetic }
+
+program mandelbrot;
+
+  var x, y, inside: integer;
+
+  function iterations (cr, ci: real; limit: integer) : integer;
+    var zr, zi, t: real;
+        k: integer;
+  begin
+    zr := 0;
+    zi := 0;
+    k := 0;
+    while (k < limit) and (zr*zr + zi*zi <= 4) do
+    begin
+      t := zr*zr - zi*zi + cr;
+      zi := 2*zr*zi + ci;
+      zr := t;
+      k := k+1
+    end;
+    iterations := k
+  end;
+
+begin
+  inside := 0;
+  y := 0;
+  while y < 200 do
+  begin
+    x := 0;
+    while x < 300 do
+    begin
+      if iterations(x/100 - 2, y/100 - 1, 200) = 200 then
+        inside := inside+1;
+      x := x+1
+    end;
+    y := y+1
+  end;
+
+  writeln('points inside: ', inside)
+end.
@@ -0,0 +1,40 @@
+{ Sieve of Eratosthenes: array accesses in tight loops }
+
+program sieve;
+
+  var flags: array [2..200000] of boolean;
+      i, k, count, round: integer;
+
+begin
+  round := 0;
+  while round < 10 do
+  begin
+    i := 2;
+    while i <= 200000 do
+    begin
+      flags[i] := true;
+      i := i+1
+    end;
+
+    count := 0;
+    i := 2;
+    while i <= 200000 do
+    begin
+      if flags[i] then
+      begin
+        count := count+1;
+        k := i+i;
+        while k <= 200000 do
+        begin
+          flags[k] := false;
+          k := k+i
+        end
+      end;
+      i := i+1
+    end;
+
+    round := round+1
+  end;
+
+  writeln('primes up to 200000: ', count)
+end.
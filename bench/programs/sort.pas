@@ -0,0 +1,66 @@
+{ Bubble sort of pseudo random reals, checked through an array passed by value }
+
+program sort;
+
+  var values: array [1..2000] of real;
+      seed, i: integer;
+
+  function random () : integer;
+    var t: integer;
+  begin
+    t := seed*75 + 74;
+    seed := t - t div 65537 * 65537;
+    random := seed
+  end;
+
+  procedure bubble_sort(n: integer);
+  var i: integer;
+      swapped: boolean;
+      t: real;
+  begin
+    swapped := true;
+    while swapped do
+    begin
+      i := 1;
+      swapped := false;
+      while i < n do
+      begin
+        if values[i] > values[i+1] then
+        begin
+          t := values[i];
+          values[i] := values[i+1];
+          values[i+1] := t;
+          swapped := true
+        end;
+        i := i+1
+      end;
+      n := n-1
+    end
+  end;
+
+  function is_sorted (a: array [1..2000] of real; n: integer) : boolean;
+    var i: integer;
+  begin
+    is_sorted := true;
+    i := 1;
+    while i < n do
+    begin
+      if a[i] > a[i+1] then
+        is_sorted := false;
+      i := i+1
+    end
+  end;
+
+begin
+  seed := 42;
+  i := 1;
+  while i <= 2000 do
+  begin
+    values[i] := random() / 100;
+    i := i+1
+  end;
+
+  bubble_sort(2000);
+
+  writeln('sorted: ', is_sorted(values, 2000), ', smallest: ', values[1], ', largest: ', values[2000])
+end.
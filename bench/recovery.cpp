@@ -0,0 +1,151 @@
+/* Error recovery on a fuzzed corpus (see `make bench-recovery`): every input is mutated a number of times (words
+   deleted, tokens inserted, lines duplicated), most mutants no longer parse. Each mutant is parsed up to its first
+   error, the way a failing parse used to stop, and with recovery, which reports all of them in one pass. The first
+   error of both has to be the same. Usage: recovery <mutants per file> <file.pas>... */
+
+#include "parser/Parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t SEED = 22;
+static const size_t MAX_MUTATIONS = 4; // per mutant
+static const char* const INSERTED[] = { ";", "end", "begin", ":=", "(", ")", "x", "1", "then", "do", "function", "*", ",", "var" };
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* the text with one to MAX_MUTATIONS random mutations */
+static std::string mutate(std::string text, std::mt19937& random) {
+    size_t mutations = std::uniform_int_distribution<size_t>(1, MAX_MUTATIONS)(random);
+    for (size_t i = 0; i < mutations && !text.empty(); i++) {
+        size_t at = std::uniform_int_distribution<size_t>(0, text.size() - 1)(random);
+        switch (random() % 3) {
+            case 0: { // the words from one space to a later one
+                size_t start = text.rfind(' ', at);
+                start = start == std::string::npos ? 0 : start;
+                size_t end = text.find(' ', std::min(text.size(), start + 1 + random() % 12));
+                text.erase(start, (end == std::string::npos ? text.size() : end) - start);
+            } break;
+            case 1: { // a token between spaces
+                const char* inserted = INSERTED[random() % (sizeof(INSERTED) / sizeof(INSERTED[0]))];
+                text.insert(at, std::string(" ") + inserted + " ");
+            } break;
+            default: { // the line again
+                size_t start = text.rfind('\n', at);
+                start = start == std::string::npos ? 0 : start + 1;
+                size_t end = text.find('\n', at);
+                end = end == std::string::npos ? text.size() : end + 1;
+                text.insert(start, text.substr(start, end - start));
+            }
+        }
+    }
+    return text;
+}
+
+/* the first error (empty if there is none), the way a failing parse stopped before recovery */
+static std::string parseToFirstError(const std::string& text, double& time) {
+    auto start = Clock::now();
+    Parser parser(SourceFile::copy(text));
+    std::string error;
+    try {
+        delete parser.program();
+    } catch (SyntaxException ex) {
+        error = ex.what();
+    }
+    time = millisecondsSince(start);
+    return error;
+}
+
+/* all errors in one pass */
+static std::vector<SyntaxException> parseRecovering(const std::string& text, double& time) {
+    auto start = Clock::now();
+    Parser parser(SourceFile::copy(text));
+    parser.recovering = true;
+    delete parser.program();
+    time = millisecondsSince(start);
+    return parser.errors;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <mutants per file> <file.pas>..." << std::endl;
+        return -1;
+    }
+    size_t mutants = std::stoul(argv[1]);
+
+    std::mt19937 random(SEED);
+    size_t inputs = 0, invalid = 0, errors = 0, mismatches = 0;
+    double firstErrorTime = 0, recoveringTime = 0, rerunTime = 0;
+    double validTime = 0, validRecoveringTime = 0;
+
+    for (int i = 2; i < argc; i++) {
+        std::ifstream file(argv[i]);
+        if (!file) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        std::string original = content.str();
+
+        // the unmutated input, for the cost of recovery on the normal path
+        double time;
+        if (!parseToFirstError(original, time).empty()) {
+            std::cerr << "Skipping " << argv[i] << ", it does not parse as it is" << std::endl;
+            continue;
+        }
+        inputs++;
+        validTime += time;
+        parseRecovering(original, time);
+        validRecoveringTime += time;
+
+        for (size_t m = 0; m < mutants; m++) {
+            std::string text = mutate(original, random);
+
+            double first, recovering;
+            std::string error = parseToFirstError(text, first);
+            std::vector<SyntaxException> all = parseRecovering(text, recovering);
+            firstErrorTime += first;
+            recoveringTime += recovering;
+
+            if (error != (all.empty() ? std::string() : std::string(all[0].what()))) {
+                if (mismatches++ == 0) {
+                    std::cerr << "Mutant " << m << " of " << argv[i] << ": the first error is\n" << error << "\nbut recovery reported\n"
+                              << (all.empty() ? "nothing" : all[0].what()) << std::endl;
+                }
+            }
+            if (!all.empty()) {
+                invalid++;
+                errors += all.size();
+                // one run per error, each stopping at the error that is the first one left by then: about as long
+                // as the part of a recovering pass up to its line
+                size_t lines = std::count(text.begin(), text.end(), '\n') + 1;
+                for (const SyntaxException& ex : all) {
+                    rerunTime += recovering * std::min<size_t>(ex.lineNumber, lines) / lines;
+                }
+            }
+        }
+    }
+
+    size_t total = mutants * inputs;
+    std::cout << total << " mutants, " << invalid << " invalid (" << 100.0 * invalid / total << " %), " << errors
+              << " syntax errors, " << static_cast<double>(errors) / std::max<size_t>(invalid, 1) << " per invalid mutant" << std::endl;
+    std::cout << "up to the first error: " << firstErrorTime << " ms, " << total / firstErrorTime * 1000 << " files/s" << std::endl;
+    std::cout << "all errors with recovery: " << recoveringTime << " ms, " << total / recoveringTime * 1000 << " files/s" << std::endl;
+    std::cout << "all errors with one run per error (estimated): " << rerunTime << " ms, "
+              << rerunTime / recoveringTime << "x the recovering pass" << std::endl;
+    std::cout << "unmutated inputs: " << validTime << " ms without, " << validRecoveringTime << " ms with recovery" << std::endl;
+
+    if (mismatches > 0) {
+        std::cout << mismatches << " mutants report a different first error with recovery" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,115 @@
+/* Cost of resolving every name of a program (see `make bench-resolve`): the best of a few runs of the Resolver
+   over the parsed program, per method and per name it resolved. Built against the current tree it measures the
+   open addressing SymbolTable scopes; with -I on a revision from before them, the std::unordered_map ones.
+   Usage: resolve <file.pas>... */
+
+#include "parser/Parser.h"
+#include "interpreter/Resolver.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static const int RUNS = 5;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* the variable uses and calls the Resolver looks up */
+class NameCounter : public ASTVisitor<NameCounter> {
+public:
+    size_t names = 0;
+
+    void visitProgram(Program* prog) {
+        for (const auto& meth : prog->methods) visit(meth);
+        visit(prog->main);
+    }
+    void visitMethod(Method* meth) { visit(meth->block); }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        names++;
+        if (stmt->arrayIndex != NULL) visit(stmt->arrayIndex);
+        visit(stmt->value);
+    }
+    void visitCall(Stmt::Call* stmt) {
+        names++;
+        for (const auto& argExpr : stmt->arguments) visit(argExpr);
+    }
+    void visitIf(Stmt::If* stmt) {
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) visit(stmt->elseBody);
+    }
+    void visitWhile(Stmt::While* stmt) {
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+    void visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) visit(stmtInside);
+    }
+
+    void visitBinary(Expr::Binary* expr) {
+        visit(expr->left);
+        visit(expr->right);
+    }
+    void visitCall(Expr::Call* expr) {
+        names++;
+        for (const auto& argExpr : expr->arguments) visit(argExpr);
+    }
+    void visitGrouping(Expr::Grouping* expr) { visit(expr->expression); }
+    void visitIdentifier(Expr::Identifier* expr) {
+        names++;
+        if (expr->arrayIndexExpression != NULL) visit(expr->arrayIndexExpression);
+    }
+    void visitLiteral(Expr::Literal*) {}
+    void visitUnary(Expr::Unary* expr) { visit(expr->right); }
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cout << argv[i] << ": skipped, syntax error" << std::endl;
+            continue;
+        }
+
+        NameCounter counter;
+        counter.visit(prog);
+
+        double best = 0;
+        try {
+            for (int run = 0; run < RUNS; run++) {
+                auto start = Clock::now();
+                Resolver resolver(prog);
+                double time = millisecondsSince(start);
+                best = run == 0 || time < best ? time : best;
+            }
+        } catch (SemanticException ex) {
+            std::cout << argv[i] << ": skipped, semantic error: " << ex.what() << std::endl;
+            delete prog;
+            continue;
+        }
+
+        std::cout << argv[i] << ": " << prog->methods.size() << " methods, " << counter.names << " names resolved in "
+                  << best << " ms (" << best * 1e6 / prog->methods.size() << " ns per method, "
+                  << best * 1e6 / counter.names << " ns per name)" << std::endl;
+
+        delete prog;
+    }
+}
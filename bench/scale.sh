@@ -0,0 +1,45 @@
+#!/bin/sh
+# Usage: scale.sh <program.pas> <factor> [unique]
+# Prints the program with all of its functions/procedures repeated <factor> times,
+# which gives arbitrarily large but still parseable inputs. With "unique" every copy
+# after the first renames its methods (and the calls between them) to name_<copy>,
+# so the result still resolves: the main block calls the first copy.
+
+awk -v factor="$2" -v unique="$3" '
+    # text with every whole word name replaced by name_suffix
+    function rename(text, name, suffix,    out, before, after) {
+        out = ""
+        while (match(text, "(^|[^A-Za-z0-9_])" name "([^A-Za-z0-9_]|$)")) {
+            before = substr(text, RSTART, 1) ~ /[A-Za-z0-9_]/ ? 0 : 1
+            after = substr(text, RSTART + RLENGTH - 1, 1) ~ /[A-Za-z0-9_]/ ? 0 : 1
+            out = out substr(text, 1, RSTART - 1 + before) name "_" suffix
+            text = substr(text, RSTART + RLENGTH - after)
+        }
+        return out text
+    }
+
+    /^[ \t]*(function|procedure)[ \t]/ && !inMain { inMethods = 1 }
+    /^begin/                                      { inMain = 1; inMethods = 0 }
+
+    inMethods && match($0, /^[ \t]*(function|procedure)[ \t]+[A-Za-z_][A-Za-z0-9_]*/) {
+        declaration = substr($0, RSTART, RLENGTH)
+        sub(/^[ \t]*(function|procedure)[ \t]+/, "", declaration)
+        names[++count] = declaration
+    }
+
+    inMethods { methods = methods $0 "\n"; next }
+    inMain    { tail = tail $0 "\n"; next }
+              { print }
+
+    END {
+        if (factor > 0) printf "%s", methods
+        for (i = 1; i < factor; i++) {
+            copy = methods
+            if (unique == "unique") {
+                for (n = 1; n <= count; n++) copy = rename(copy, names[n], i)
+            }
+            printf "%s", copy
+        }
+        printf "%s", tail
+    }
+' "$1"
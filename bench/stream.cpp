@@ -0,0 +1,102 @@
+/* Time to first byte, total time and peak memory of AST2Text for a large output: the program is printed again
+   and again until the given amount is reached, either collected in memory and written at the end (buffered) or
+   streamed through an OutputSink (streaming). The output goes into a pipe whose reader notes when the first
+   byte arrives. Run each mode in its own process, the peak RSS covers everything before.
+   Usage: stream <file.pas> buffered|streaming [megabytes] */
+
+#include "parser/Parser.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <sys/resource.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> buffered|streaming [megabytes]" << std::endl;
+        return -1;
+    }
+    bool streaming = strcmp(argv[2], "streaming") == 0;
+    size_t target = (argc > 3 ? atol(argv[3]) : 1024) * 1024 * 1024;
+
+    SourceFile* source = SourceFile::map(argv[1]);
+    if (source == NULL) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return -1;
+    }
+
+    Parser p(source);
+    Program* prog;
+    try {
+        prog = p.program();
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+
+    // size of one rendering, to know how often to print the program
+    size_t programSize;
+    {
+        AST2Text ast2text;
+        ast2text.visit(prog);
+        programSize = ast2text.getResult().size();
+    }
+    size_t repetitions = (target + programSize - 1) / programSize;
+
+    int pipeEnds[2];
+    if (pipe(pipeEnds) != 0) {
+        std::cerr << "Cannot create a pipe" << std::endl;
+        return -1;
+    }
+
+    // the consumer: drains the pipe and notes when the first byte arrived
+    Clock::time_point firstByte;
+    size_t received = 0;
+    std::thread reader([&] {
+        static char chunk[1 << 16];
+        ssize_t length;
+        while ((length = read(pipeEnds[0], chunk, sizeof(chunk))) > 0) {
+            if (received == 0) {
+                firstByte = Clock::now();
+            }
+            received += length;
+        }
+    });
+
+    auto start = Clock::now();
+    {
+        OutputSink output(pipeEnds[1]);
+
+        if (streaming) {
+            AST2Text ast2text(&output);
+            for (size_t i = 0; i < repetitions; i++) {
+                ast2text.visit(prog);
+            }
+        } else {
+            AST2Text ast2text;
+            for (size_t i = 0; i < repetitions; i++) {
+                ast2text.visit(prog);
+            }
+            output << ast2text.getResult();
+        }
+    }
+    close(pipeEnds[1]);
+    reader.join();
+    auto end = Clock::now();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double seconds = millisecondsBetween(start, end) / 1000;
+    std::cout << argv[2] << ": " << received / (1024 * 1024) << " MB, first byte after "
+              << millisecondsBetween(start, firstByte) << " ms, total " << seconds * 1000 << " ms ("
+              << received / (1024.0 * 1024.0) / seconds << " MB/s), peak RSS " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+
+    delete prog;
+}
@@ -0,0 +1,142 @@
+/* Visit throughput of a full traversal that counts the nodes and sums up the lines of all tokens. Built against
+   the current tree it measures ASTVisitor (switch over the kind tag); with -DVIRTUAL_VISITOR against a revision
+   that still had the virtual accept()/visitX() visitors (see `make bench-visit`).
+   Usage: visit <file.pas> [repetitions] */
+
+#include "parser/Parser.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+#ifdef VIRTUAL_VISITOR
+#define COUNTER_BASE Expr::Visitor, public Stmt::Visitor, public Method::Visitor, public Program::Visitor
+#define VISIT(node) (node)->accept(this)
+#else
+#define COUNTER_BASE ASTVisitor<Counter>
+#define VISIT(node) visit(node)
+#endif
+
+class Counter : public COUNTER_BASE {
+public:
+    size_t nodes = 0;
+    size_t lines = 0;
+
+    void visitProgram(Program* prog) {
+        nodes++;
+        for (const auto& meth : prog->methods) VISIT(meth);
+        VISIT(prog->main);
+    }
+    void visitMethod(Method* meth) {
+        nodes++;
+        VISIT(meth->block);
+    }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        nodes++;
+        lines += stmt->identifier.lineNumber;
+        if (stmt->arrayIndex != NULL) VISIT(stmt->arrayIndex);
+        VISIT(stmt->value);
+    }
+    void visitCall(Stmt::Call* stmt) {
+        nodes++;
+        lines += stmt->callee.lineNumber;
+        for (const auto& argument : stmt->arguments) VISIT(argument);
+    }
+    void visitIf(Stmt::If* stmt) {
+        nodes++;
+        VISIT(stmt->condition);
+        VISIT(stmt->thenBody);
+        if (stmt->elseBody != NULL) VISIT(stmt->elseBody);
+    }
+    void visitWhile(Stmt::While* stmt) {
+        nodes++;
+        VISIT(stmt->condition);
+        VISIT(stmt->body);
+    }
+    void visitBlock(Stmt::Block* stmt) {
+        nodes++;
+        for (const auto& statement : stmt->statements) VISIT(statement);
+    }
+
+    void visitBinary(Expr::Binary* expr) {
+        nodes++;
+        lines += expr->op.lineNumber;
+        VISIT(expr->left);
+        VISIT(expr->right);
+    }
+    void visitCall(Expr::Call* expr) {
+        nodes++;
+        lines += expr->callee.lineNumber;
+        for (const auto& argument : expr->arguments) VISIT(argument);
+    }
+    void visitGrouping(Expr::Grouping* expr) {
+        nodes++;
+        VISIT(expr->expression);
+    }
+    void visitIdentifier(Expr::Identifier* expr) {
+        nodes++;
+        lines += expr->token.lineNumber;
+        if (expr->arrayIndexExpression != NULL) VISIT(expr->arrayIndexExpression);
+    }
+    void visitLiteral(Expr::Literal* expr) {
+        nodes++;
+        lines += expr->token.lineNumber;
+    }
+    void visitUnary(Expr::Unary* expr) {
+        nodes++;
+        lines += expr->op.lineNumber;
+        VISIT(expr->right);
+    }
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas> [repetitions]" << std::endl;
+        return -1;
+    }
+    int repetitions = argc > 2 ? atoi(argv[2]) : 10;
+
+    SourceFile* source = SourceFile::map(argv[1]);
+    if (source == NULL) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return -1;
+    }
+
+    Parser p(source);
+    Program* prog;
+    try {
+        prog = p.program();
+    } catch (SyntaxException ex) {
+        std::cerr << "Syntax error: " << ex.what() << std::endl;
+        return -1;
+    }
+
+    double seconds = 0;
+    size_t nodes = 0, lines = 0;
+
+    for (int i = 0; i < repetitions; i++) {
+        auto start = Clock::now();
+        Counter counter;
+#ifdef VIRTUAL_VISITOR
+        prog->accept(&counter);
+#else
+        counter.visit(prog);
+#endif
+        seconds += secondsSince(start);
+
+        nodes = counter.nodes;
+        lines = counter.lines;
+    }
+    seconds /= repetitions;
+
+    std::cout << nodes << " nodes (line sum " << lines << "): " << seconds * 1000 << " ms, "
+              << nodes / seconds / 1e6 << " M nodes/s" << std::endl;
+
+    delete prog;
+}
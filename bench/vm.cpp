@@ -0,0 +1,91 @@
+/* Bytecode VM against the tree-walking interpreter: runs every given program (bench/programs) on both, checks that
+   they print the same, and reports both times, the instructions the VM executed per second and the speedup.
+   Usage: vm <file.pas>... */
+
+#include "parser/Parser.h"
+#include "interpreter/Interpreter.h"
+#include "bytecode/Compiler.h"
+#include "bytecode/VM.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.pas>..." << std::endl;
+        return -1;
+    }
+
+    double interpreterTotal = 0, vmTotal = 0;
+    for (int i = 1; i < argc; i++) {
+        SourceFile* source = SourceFile::map(argv[i]);
+        if (source == NULL) {
+            std::cerr << "Cannot open " << argv[i] << std::endl;
+            return -1;
+        }
+
+        Parser p(source);
+        Program* prog;
+        try {
+            prog = p.program();
+        } catch (SyntaxException ex) {
+            std::cerr << argv[i] << ": syntax error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        try {
+            OutputSink interpreterOutput;
+            auto start = Clock::now();
+            Interpreter interpreter(prog, &interpreterOutput);
+            interpreter.run();
+            double interpreterTime = millisecondsSince(start);
+
+            // compile time counts, as it is part of getting the program to run
+            OutputSink vmOutput;
+            start = Clock::now();
+            std::unique_ptr<Bytecode::Module> module(Bytecode::Compiler(prog).compile());
+            double compileTime = millisecondsSince(start);
+            {
+                Bytecode::VM vm(module.get(), &vmOutput);
+                vm.run();
+            }
+            double vmTime = millisecondsSince(start);
+
+            if (interpreterOutput.result() != vmOutput.result()) {
+                std::cerr << argv[i] << ": the VM printed something else than the interpreter" << std::endl;
+                return -1;
+            }
+
+            // a second run only to count the instructions, the counter is not free
+            OutputSink countOutput;
+            Bytecode::VM counting(module.get(), &countOutput);
+            counting.run<true>();
+            double instructions = counting.executed;
+
+            interpreterTotal += interpreterTime;
+            vmTotal += vmTime;
+            std::cout << argv[i] << ": interpreter " << interpreterTime << " ms, vm " << vmTime << " ms (compiled in "
+                      << compileTime << " ms), " << instructions / 1e6 << " M instructions, "
+                      << instructions / (vmTime - compileTime) / 1e3 << " M instructions/s, "
+                      << interpreterTime / vmTime << "x" << std::endl;
+        } catch (SemanticException ex) {
+            std::cerr << argv[i] << ": semantic error: " << ex.what() << std::endl;
+            return -1;
+        } catch (RuntimeException ex) {
+            std::cerr << argv[i] << ": runtime error: " << ex.what() << std::endl;
+            return -1;
+        }
+
+        delete prog;
+    }
+
+    std::cout << "total: interpreter " << interpreterTotal << " ms, vm " << vmTotal << " ms, "
+              << interpreterTotal / vmTotal << "x" << std::endl;
+}
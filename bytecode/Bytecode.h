@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string_view>
+#include <vector>
+
+#include "../interpreter/Value.h"
+
+namespace Bytecode {
+    struct ArrayStorage;
+
+    /* a register: the instructions know the type of what they operate on, so values carry no tag (booleans are 0/1) */
+    union Slot {
+        int64_t integer;
+        double real;
+        ArrayStorage* array;
+    };
+
+    /* elements of an array [start..start+length-1] */
+    struct ArrayStorage {
+        int64_t start;
+        uint64_t length;
+        Slot elements[];
+
+        /* a zeroed array */
+        static ArrayStorage* create(int64_t start, uint64_t length) {
+            ArrayStorage* array = static_cast<ArrayStorage*>(calloc(1, sizeof(ArrayStorage) + length * sizeof(Slot)));
+            array->start = start;
+            array->length = length;
+            return array;
+        }
+
+        static ArrayStorage* copy(const ArrayStorage* from) {
+            size_t size = sizeof(ArrayStorage) + from->length * sizeof(Slot);
+            ArrayStorage* array = static_cast<ArrayStorage*>(malloc(size));
+            memcpy(array, from, size);
+            return array;
+        }
+    };
+
+    /* how the disassembler shows the operands of an instruction */
+    enum Format : uint8_t {
+        NONE,
+        A,      // rA
+        AB,     // rA, rB
+        ABC,    // rA, rB, rC
+        AK,     // rA, constant D
+        AG,     // rA, global D
+        GB,     // global D, rB
+        J,      // jump to D
+        AJ,     // rA, jump to D
+        ABJ,    // rA, rB, jump to D
+        CALL_,  // rA = function D with the arguments from rB on
+        S       // string D
+    };
+
+    /* every opcode with its operand format; the integer (I) and real (R) variants are chosen by the compiler */
+    #define BYTECODE_OPCODES(X) \
+        X(MOVE, AB)      /* rA = rB */ \
+        X(LOADK, AK)     /* rA = constant D */ \
+        X(GETGLOBAL, AG) /* rA = global D */ \
+        X(SETGLOBAL, GB) /* global D = rB */ \
+        X(ITOR, AB)      /* rA = real(rB) */ \
+        \
+        X(ADDI, ABC) X(SUBI, ABC) X(MULI, ABC) X(DIVI, ABC) X(NEGI, AB) \
+        X(ADDR, ABC) X(SUBR, ABC) X(MULR, ABC) X(DIVR, ABC) X(NEGR, AB) \
+        X(NOT, AB) \
+        \
+        /* rA = rB <op> rC, as 0 or 1 (the I variants compare booleans as well) */ \
+        X(EQI, ABC) X(NEI, ABC) X(LTI, ABC) X(LEI, ABC) X(GTI, ABC) X(GEI, ABC) \
+        X(EQR, ABC) X(NER, ABC) X(LTR, ABC) X(LER, ABC) X(GTR, ABC) X(GER, ABC) \
+        \
+        X(JMP, J) \
+        X(JMPF, AJ) X(JMPT, AJ) /* jump if rA is false / true */ \
+        /* jump if rA <op> rB holds, integers and booleans only */ \
+        X(JEQI, ABJ) X(JNEI, ABJ) X(JLTI, ABJ) X(JLEI, ABJ) X(JGTI, ABJ) X(JGEI, ABJ) \
+        \
+        X(GETELEM, ABC)  /* rA = rB[rC] */ \
+        X(SETELEM, ABC)  /* rA[rB] = rC */ \
+        X(COPYARRAY, AB) /* elements of rA = elements of rB */ \
+        \
+        X(CALL, CALL_)   /* the callee's frame starts at rB (where the arguments are), its result goes to rA */ \
+        X(RET, NONE) \
+        X(HALT, NONE) \
+        \
+        X(WRITEI, A) X(WRITER, A) X(WRITEB, A) X(WRITES, S) X(WRITELN, NONE)
+
+    #define BYTECODE_ENUM(name, format) name,
+    enum Opcode : uint8_t { BYTECODE_OPCODES(BYTECODE_ENUM) OPCODE_COUNT };
+    #undef BYTECODE_ENUM
+
+    #define BYTECODE_NAME(name, format) #name,
+    const char* const OPCODE_NAMES[] = { BYTECODE_OPCODES(BYTECODE_NAME) };
+    #undef BYTECODE_NAME
+
+    #define BYTECODE_FORMAT(name, format) format,
+    const Format OPCODE_FORMATS[] = { BYTECODE_OPCODES(BYTECODE_FORMAT) };
+    #undef BYTECODE_FORMAT
+
+    /* three 16 bit register operands and a 32 bit one for jump targets, constants, globals and functions */
+    struct Instruction {
+        Opcode op;
+        uint16_t a, b, c;
+        int32_t d;
+    };
+
+    /* an array a function allocates on entry (a copy of the argument, for array parameters) */
+    struct ArraySlot {
+        uint16_t slot;
+        int64_t start;
+        uint64_t length;
+    };
+
+    /**
+     * Shared between the VM and native code (see jit/): the depth of the call stack and where the registers end,
+     * so that native calls can check for stack overflows, and the first runtime error with its line.
+     */
+    struct NativeContext {
+        enum Error : uint32_t { NONE, DIVISION_BY_ZERO, STACK_OVERFLOW };
+
+        uint64_t depth;
+        uint64_t maxDepth;
+        Slot* registersEnd;
+        Error error;
+        int32_t line;
+    };
+
+    /* calls the native code of a function whose frame starts at base, returns its result */
+    using NativeEntry = int64_t (*)(Slot* base, NativeContext* context, const void* code);
+
+    /* a compiled method (or the main block) */
+    struct Function {
+        std::string_view name;
+        std::vector<Instruction> code;
+        std::vector<int> lines;        // source line of every instruction, for runtime errors
+
+        uint32_t argumentCount = 0;
+        uint32_t slotCount = 0;        // arguments, declarations and the result, zeroed on entry
+        uint32_t registerCount = 0;    // slots and temporaries
+        uint32_t resultSlot = UNRESOLVED;
+        ValueType resultType = ValueType::INTEGER;
+        std::vector<ArraySlot> arrays;
+
+        const void* native = NULL;     // machine code, if the JIT compiled the function
+    };
+
+    /**
+     * A compiled program: one Function per method (in the order of Program::methods), then the main block, whose
+     * registers start with the globals. String constants point into the program, which has to outlive the module.
+     */
+    struct Module {
+        std::vector<Function> functions;
+        std::vector<Slot> constants;
+        std::vector<ValueType> constantTypes;
+        std::vector<std::string_view> strings;
+
+        NativeEntry enter = NULL;      // set by the JIT, switches from the VM to native code
+
+        size_t mainFunction() const { return functions.size() - 1; }
+    };
+}
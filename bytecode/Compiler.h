@@ -0,0 +1,468 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../parser/AST/Program.h"
+#include "../parser/AST/Visitor.h"
+#include "../parser/SemanticException.h"
+#include "../interpreter/Resolver.h"
+#include "../interpreter/TypeChecker.h"
+#include "Bytecode.h"
+
+namespace Bytecode {
+    /**
+     * Compiles a resolved program to bytecode. The static types the TypeChecker stored on the expressions select
+     * the typed instructions (ADDI or ADDR, ...) and where ITORs go; what does not fit together has thrown a
+     * SemanticException before anything is compiled.
+     *
+     * The registers of a function are its slots (see FrameLayout), followed by temporaries that are handed out
+     * like a stack while compiling an expression. Expressions are compiled into a destination register; local
+     * variables are used in place, without moving them first. Comparisons of integers in conditions become a
+     * single compare-and-jump.
+     */
+    class Compiler : public ASTVisitor<Compiler> {
+    public:
+        Compiler(Program* prog) : prog{prog}, resolver{prog}, types{prog, resolver} {}
+
+        Compiler(const Compiler&) = delete;
+        Compiler& operator=(const Compiler&) = delete;
+
+        /* compiles the whole program, the module belongs to the caller */
+        Module* compile() {
+            std::unique_ptr<Module> compiled(new Module());
+            module = compiled.get();
+
+            for (const auto& value : resolver.constants) {
+                Slot slot;
+                switch (value.type) {
+                    case ValueType::REAL:    slot.real = value.real; break;
+                    case ValueType::BOOLEAN: slot.integer = value.boolean; break;
+                    case ValueType::STRING:
+                        slot.integer = module->strings.size();
+                        module->strings.push_back(*value.string);
+                        break;
+                    default:                 slot.integer = value.integer; break;
+                }
+
+                module->constants.push_back(slot);
+                module->constantTypes.push_back(value.type);
+            }
+
+            visit(prog);
+            return compiled.release();
+        }
+
+        /* --------------- Program ----------------- */
+        void visitProgram(Program* prog) {
+            for (size_t i = 0; i < prog->methods.size(); i++) {
+                methodIndex = i;
+                visit(prog->methods[i]);
+            }
+
+            // main: the globals are the first registers of its frame
+            methodIndex = prog->methods.size();
+            begin(prog->identifier.text(), resolver.globals);
+            visit(prog->main);
+            emit(HALT, 0, 0, 0, 0, 0);
+            end();
+
+        }
+
+
+        /* --------------- Methods ----------------- */
+        void visitMethod(Method* meth) {
+            const FrameLayout& layout = resolver.frames[methodIndex];
+
+            begin(meth->identifier.text(), layout);
+            if (meth->returnType != NULL) {
+                function->resultSlot = layout.resultSlot;
+                function->resultType = elementType(*meth->returnType);
+            }
+
+            visit(meth->block);
+            emit(RET, 0, 0, 0, 0, meth->identifier.lineNumber);
+            end();
+
+        }
+
+        /* --------------- Statements ----------------- */
+        void visitAssignment(Stmt::Assignment* stmt) {
+            int line = stmt->identifier.lineNumber;
+            const Variable::VariableType* type = typeOf(stmt->slot);
+            uint16_t mark = nextRegister;
+
+            if (stmt->arrayIndex != NULL) {
+                uint16_t array = variableRegister(stmt->slot, line);
+                uint16_t index = operand(stmt->arrayIndex, stmt->value);
+                uint16_t value = convertedOperand(stmt->value, elementType(*type), line);
+
+                emit(SETELEM, array, index, value, 0, line);
+            } else if (!isGlobal(stmt->slot) || type->kind == Variable::VariableType::Kind::ARRAY) {
+                // straight into the register of the variable (arrays are copied into the one it refers to)
+                store(stmt->value, variableRegister(stmt->slot, line), *type, false, line);
+            } else {
+                uint16_t value = temporary();
+                store(stmt->value, value, *type, false, line);
+                emit(SETGLOBAL, 0, value, 0, stmt->slot.index, line);
+            }
+
+            nextRegister = mark;
+        }
+
+        void visitCall(Stmt::Call* stmt) {
+            int line = stmt->callee.lineNumber;
+            uint16_t mark = nextRegister;
+
+            if (stmt->target.builtin) {
+                for (const auto& argExpr : stmt->arguments) {
+                    write(argExpr, line);
+                }
+                if (stmt->target.index == Builtin::WRITELN) {
+                    emit(Opcode::WRITELN, 0, 0, 0, 0, line);
+                }
+            } else {
+                call(stmt->target.index, stmt->arguments, temporary(), line);
+            }
+
+            nextRegister = mark;
+        }
+
+        void visitIf(Stmt::If* stmt) {
+            size_t toElse = jumpIfFalse(stmt->condition);
+            visit(stmt->thenBody);
+
+            if (stmt->elseBody != NULL) {
+                size_t toEnd = emit(JMP, 0, 0, 0, 0, 0);
+                patch(toElse);
+                visit(stmt->elseBody);
+                patch(toEnd);
+            } else {
+                patch(toElse);
+            }
+        }
+
+        void visitWhile(Stmt::While* stmt) {
+            int32_t start = function->code.size();
+
+            size_t toEnd = jumpIfFalse(stmt->condition);
+            visit(stmt->body);
+            emit(JMP, 0, 0, 0, start, 0);
+            patch(toEnd);
+
+        }
+
+        void visitBlock(Stmt::Block* stmt) {
+            for (auto const& stmtInside : stmt->statements) {
+                visit(stmtInside);
+            }
+        }
+
+
+        /* --------------- Expressions (into the register target) ---------------- */
+        void visitBinary(Expr::Binary* expr) {
+            uint16_t dest = target;
+            int line = expr->op.lineNumber;
+            TokenType op = expr->op.type;
+            uint16_t mark = nextRegister;
+
+            if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+                // the target may be read by the right operand, so the result is built up in a temporary
+                uint16_t result = temporary();
+                compileInto(expr->left, result);
+
+                size_t skip = emit(op == TokenType::OP_AND ? JMPF : JMPT, result, 0, 0, 0, line);
+                compileInto(expr->right, result);
+                patch(skip);
+
+                emit(MOVE, dest, result, 0, 0, line);
+                nextRegister = mark;
+                return;
+            }
+
+            uint16_t left = operand(expr->left, expr->right);
+            uint16_t right = operand(expr->right);
+
+            bool real = expr->operandType == ValueType::REAL;
+            if (real) {
+                left = toReal(left, expr->left->type, line);
+                right = toReal(right, expr->right->type, line);
+            }
+
+            switch (op) {
+                case TokenType::OP_ADD:           emit(real ? ADDR : ADDI, dest, left, right, 0, line); break;
+                case TokenType::OP_SUB:           emit(real ? SUBR : SUBI, dest, left, right, 0, line); break;
+                case TokenType::OP_MUL:           emit(real ? MULR : MULI, dest, left, right, 0, line); break;
+                case TokenType::OP_INTEGER_DIV:   emit(DIVI, dest, left, right, 0, line); break;
+                case TokenType::OP_EQUALS:        emit(real ? EQR : EQI, dest, left, right, 0, line); break;
+                case TokenType::OP_NOT_EQUALS:    emit(real ? NER : NEI, dest, left, right, 0, line); break;
+                case TokenType::OP_LESS:          emit(real ? LTR : LTI, dest, left, right, 0, line); break;
+                case TokenType::OP_LESS_EQUAL:    emit(real ? LER : LEI, dest, left, right, 0, line); break;
+                case TokenType::OP_GREATER:       emit(real ? GTR : GTI, dest, left, right, 0, line); break;
+                case TokenType::OP_GREATER_EQUAL: emit(real ? GER : GEI, dest, left, right, 0, line); break;
+                default:                          emit(DIVR, dest, left, right, 0, line); break; // OP_DIV
+            }
+
+            nextRegister = mark;
+        }
+
+        void visitCall(Expr::Call* expr) {
+            uint16_t dest = target;
+            uint16_t mark = nextRegister;
+
+            call(expr->target.index, expr->arguments, dest, expr->callee.lineNumber);
+
+            nextRegister = mark;
+        }
+
+        void visitGrouping(Expr::Grouping* expr) {
+            visit(expr->expression);
+        }
+
+        void visitIdentifier(Expr::Identifier* expr) {
+            uint16_t dest = target;
+            int line = expr->token.lineNumber;
+            uint16_t mark = nextRegister;
+
+            if (expr->arrayIndexExpression != NULL) {
+                uint16_t array = variableRegister(expr->slot, line);
+                uint16_t index = operand(expr->arrayIndexExpression);
+                emit(GETELEM, dest, array, index, 0, line);
+
+                nextRegister = mark;
+                return;
+            }
+
+            if (isGlobal(expr->slot)) {
+                emit(GETGLOBAL, dest, 0, 0, expr->slot.index, line);
+            } else {
+                emit(MOVE, dest, expr->slot.index, 0, 0, line);
+            }
+        }
+
+        void visitLiteral(Expr::Literal* expr) {
+            emit(LOADK, target, 0, 0, expr->constant, expr->token.lineNumber);
+        }
+
+        void visitUnary(Expr::Unary* expr) {
+            uint16_t dest = target;
+            int line = expr->op.lineNumber;
+            uint16_t mark = nextRegister;
+
+            uint16_t right = operand(expr->right);
+
+            if (expr->op.type == TokenType::OP_NOT) {
+                emit(NOT, dest, right, 0, 0, line);
+            } else {
+                emit(expr->type == ValueType::REAL ? NEGR : NEGI, dest, right, 0, 0, line);
+            }
+
+            nextRegister = mark;
+        }
+
+    private:
+        Program* prog;
+        Resolver resolver;
+        TypeChecker types;        // leaves the type of every expression on it
+
+        Module* module;
+        Function* function;       // being compiled
+        size_t methodIndex;       // of the function being compiled (main comes after the methods)
+
+        uint16_t target;          // destination register of the expression being compiled
+        uint32_t nextRegister;    // first free temporary
+
+        void begin(std::string_view name, const FrameLayout& layout) {
+            module->functions.emplace_back();
+            function = &module->functions.back();
+
+            function->name = name;
+            function->argumentCount = layout.argumentCount;
+            function->slotCount = layout.slots.size();
+            function->registerCount = layout.slots.size();
+
+            for (uint32_t slot : layout.arraySlots) {
+                const Variable::VariableTypeArray& type = static_cast<const Variable::VariableTypeArray&>(*layout.slots[slot]);
+                int64_t start = Resolver::integer(type.startRange);
+                int64_t stop = Resolver::integer(type.stopRange);
+
+                function->arrays.push_back(ArraySlot{static_cast<uint16_t>(slot), start, stop >= start ? static_cast<uint64_t>(stop - start + 1) : 0});
+            }
+
+            nextRegister = layout.slots.size();
+        }
+
+        void end() {
+            if (function->registerCount > UINT16_MAX) {
+                throw SemanticException("Too many variables and temporaries in", function->name, 0);
+            }
+        }
+
+        size_t emit(Opcode op, uint32_t a, uint32_t b, uint32_t c, int32_t d, int line) {
+            function->code.push_back(Instruction{op, static_cast<uint16_t>(a), static_cast<uint16_t>(b), static_cast<uint16_t>(c), d});
+            function->lines.push_back(line);
+            return function->code.size() - 1;
+        }
+
+        /* lets the jump at instruction go to the next instruction emitted */
+        void patch(size_t instruction) {
+            function->code[instruction].d = function->code.size();
+        }
+
+        uint16_t temporary() {
+            uint32_t reg = nextRegister++;
+            if (nextRegister > function->registerCount) {
+                function->registerCount = nextRegister;
+            }
+            return reg;
+        }
+
+        void compileInto(Expr::Expression* expr, uint16_t reg) {
+            uint16_t saved = target;
+            target = reg;
+            visit(expr);
+            target = saved;
+        }
+
+        /**
+         * Register holding the value of expr: variables in registers as they are, everything else in a new
+         * temporary. If a call evaluated later (in the expression later) might change the variable, it is copied.
+         */
+        uint16_t operand(Expr::Expression* expr, Expr::Expression* later = NULL) {
+            if (expr->kind == Expr::Kind::IDENTIFIER && (later == NULL || !Expr::hasCall(later))) {
+                Expr::Identifier* identifier = static_cast<Expr::Identifier*>(expr);
+
+                if (identifier->arrayIndexExpression == NULL && !isGlobal(identifier->slot)) {
+                    return identifier->slot.index;
+                }
+            }
+
+            uint16_t reg = temporary();
+            compileInto(expr, reg);
+            return reg;
+        }
+
+        /* register holding the value of expr converted to type (for assignments and arguments) */
+        uint16_t convertedOperand(Expr::Expression* expr, ValueType type, int line) {
+            uint16_t reg = operand(expr);
+            return type == ValueType::REAL ? toReal(reg, expr->type, line) : reg;
+        }
+
+        uint16_t toReal(uint16_t reg, ValueType type, int line) {
+            if (type == ValueType::REAL) {
+                return reg;
+            }
+
+            uint16_t real = temporary();
+            emit(ITOR, real, reg, 0, 0, line);
+            return real;
+        }
+
+        /**
+         * Computes expr into the register of a variable of the given declared type. Arrays are copied into the
+         * array the register refers to, unless it is an argument (the callee makes its copy on entry).
+         */
+        void store(Expr::Expression* expr, uint16_t reg, const Variable::VariableType& type, bool argument, int line) {
+            if (type.kind == Variable::VariableType::Kind::ARRAY) {
+                emit(argument ? MOVE : COPYARRAY, reg, operand(expr), 0, 0, line);
+                return;
+            }
+
+            compileInto(expr, reg);
+            if (elementType(type) == ValueType::REAL && expr->type == ValueType::INTEGER) {
+                emit(ITOR, reg, reg, 0, 0, line);
+            }
+        }
+
+        /* the arguments go into consecutive registers, where the frame of the callee begins */
+        void call(uint32_t method, const ArenaVector<Expr::Expression*>& arguments, uint16_t dest, int line) {
+            const FrameLayout& layout = resolver.frames[method];
+            uint32_t base = nextRegister;
+
+            for (size_t i = 0; i < arguments.size(); i++) {
+                temporary();
+            }
+            for (size_t i = 0; i < arguments.size(); i++) {
+                uint32_t mark = nextRegister;
+                store(arguments[i], base + i, *layout.slots[i], true, line);
+                nextRegister = mark;
+            }
+
+            emit(CALL, dest, base, 0, method, line);
+        }
+
+        void write(Expr::Expression* expr, int line) {
+            if (expr->kind == Expr::Kind::LITERAL) {
+                Expr::Literal* literal = static_cast<Expr::Literal*>(expr);
+
+                if (module->constantTypes[literal->constant] == ValueType::STRING) {
+                    emit(WRITES, 0, 0, 0, module->constants[literal->constant].integer, line);
+                    return;
+                }
+            }
+
+            uint16_t reg = operand(expr);
+
+            switch (expr->type) {
+                case ValueType::REAL:    emit(WRITER, reg, 0, 0, 0, line); break;
+                case ValueType::BOOLEAN: emit(WRITEB, reg, 0, 0, 0, line); break;
+                default:                 emit(WRITEI, reg, 0, 0, 0, line); break;
+            }
+        }
+
+        /* emits a jump taken when condition is false, to be patched to where it should go */
+        size_t jumpIfFalse(Expr::Expression* condition) {
+            uint32_t mark = nextRegister;
+            int line = Expr::lineOf(condition);
+
+            if (condition->kind == Expr::Kind::BINARY) {
+                Expr::Binary* binary = static_cast<Expr::Binary*>(condition);
+                TokenType op = binary->op.type;
+
+                if (TokenType::OP_EQUALS <= op && op <= TokenType::OP_GREATER_EQUAL) {
+                    uint16_t left = operand(binary->left, binary->right);
+                    uint16_t right = operand(binary->right);
+
+                    if (binary->operandType != ValueType::REAL) {
+                        static const Opcode inverted[] = { JNEI, JEQI, JGEI, JGTI, JLEI, JLTI };
+                        size_t jump = emit(inverted[op - TokenType::OP_EQUALS], left, right, 0, 0, line);
+
+                        nextRegister = mark;
+                        return jump;
+                    }
+
+                    // reals: the inverted comparison is not the same with NaNs, so compare and test
+                    nextRegister = mark;
+                }
+            }
+
+            uint16_t reg = temporary();
+            compileInto(condition, reg);
+
+            nextRegister = mark;
+            return emit(JMPF, reg, 0, 0, 0, line);
+        }
+
+        /* --------------- Types ----------------- */
+        const Variable::VariableType* typeOf(VariableSlot slot) {
+            return resolver.typeOf(slot, methodIndex);
+        }
+
+        /* globals are registers of main, but have to be fetched from everywhere else */
+        bool isGlobal(VariableSlot slot) {
+            return slot.global && methodIndex < prog->methods.size();
+        }
+
+        /* register holding the array of a variable */
+        uint16_t variableRegister(VariableSlot slot, int line) {
+            if (!isGlobal(slot)) {
+                return slot.index;
+            }
+
+            uint16_t reg = temporary();
+            emit(GETGLOBAL, reg, 0, 0, slot.index, line);
+            return reg;
+        }
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+
+#include "../parser/OutputSink.h"
+#include "Bytecode.h"
+
+namespace Bytecode {
+    /**
+     * Prints a module as text, one function after the other:
+     *
+     *     function gcd: 2 arguments, 3 slots, 6 registers, result in r2
+     *         0  JEQI        r3, r4, -> 7             ; line 17
+     */
+    class Disassembler {
+    public:
+        Disassembler(const Module* module, OutputSink* out) : module{module}, out{*out} {}
+
+        void print() {
+            for (const Function& function : module->functions) {
+                print(function);
+            }
+        }
+
+        void print(const Function& function) {
+            out << "function " << function.name << ": " << function.argumentCount << " arguments, " << function.slotCount
+                << " slots, " << function.registerCount << " registers";
+            if (function.resultSlot != UNRESOLVED) {
+                out << ", result in r" << function.resultSlot;
+            }
+            out << "\n";
+
+            for (size_t i = 0; i < function.code.size(); i++) {
+                instruction(i, function.code[i], function.lines[i]);
+            }
+            out << "\n";
+        }
+
+    private:
+        const Module* module;
+        OutputSink& out;
+
+        void instruction(size_t index, const Instruction& ins, int line) {
+            std::string text = std::to_string(index);
+            text.insert(0, text.size() < 5 ? 5 - text.size() : 0, ' ');
+            text += "  ";
+            text += OPCODE_NAMES[ins.op];
+            pad(text, 19);
+
+            std::string a = "r" + std::to_string(ins.a), b = "r" + std::to_string(ins.b), c = "r" + std::to_string(ins.c);
+            std::string d = std::to_string(ins.d);
+
+            switch (OPCODE_FORMATS[ins.op]) {
+                case NONE:  break;
+                case A:     text += a; break;
+                case AB:    text += a + ", " + b; break;
+                case ABC:   text += a + ", " + b + ", " + c; break;
+                case AK:    text += a + ", " + constant(ins.d); break;
+                case AG:    text += a + ", g" + d; break;
+                case GB:    text += "g" + d + ", " + b; break;
+                case J:     text += "-> " + d; break;
+                case AJ:    text += a + ", -> " + d; break;
+                case ABJ:   text += a + ", " + b + ", -> " + d; break;
+                case CALL_: text += a + " = " + std::string(module->functions[ins.d].name) + "(" + b + "...)"; break;
+                case S:     text += "'" + std::string(module->strings[ins.d]) + "'"; break;
+            }
+
+            if (line > 0) {
+                pad(text, 43);
+                text += " ; line " + std::to_string(line);
+            }
+            out << text << '\n';
+        }
+
+        std::string constant(int32_t index) {
+            Slot value = module->constants[index];
+
+            switch (module->constantTypes[index]) {
+                case ValueType::REAL: {
+                    char digits[32];
+                    snprintf(digits, sizeof(digits), "%g", value.real);
+                    return digits;
+                }
+                case ValueType::BOOLEAN: return value.integer ? "true" : "false";
+                default:                 return std::to_string(value.integer);
+            }
+        }
+
+        static void pad(std::string& text, size_t width) {
+            if (text.size() < width) {
+                text.append(width - text.size(), ' ');
+            }
+        }
+    };
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../parser/OutputSink.h"
+#include "../interpreter/RuntimeException.h"
+#include "Bytecode.h"
+
+namespace Bytecode {
+    /**
+     * Runs a compiled Module. Dispatch is threaded through computed gotos: every handler jumps to the next one
+     * on its own, so each has its own indirect jump for the branch predictor to learn.
+     *
+     * All registers live in one preallocated array. The frame of a callee starts where the caller put the
+     * arguments, so they are in place without copying; the frames of the call stack are preallocated as well.
+     * The registers of main come first, their slots are the globals, which keep their values between runs.
+     * Functions with machine code (see jit/) are called through Module::enter, on the same registers.
+     */
+    class VM {
+    public:
+        static const size_t REGISTER_COUNT = 1 << 20;
+        static const size_t MAX_CALL_DEPTH = 10000;
+
+        uint64_t executed = 0; // instructions, only counted by the COUNT variants of run() and call()
+
+        VM(const Module* module, OutputSink* out)
+            : module{module}, out{*out}, registers{new Slot[REGISTER_COUNT]}, frames{new Frame[MAX_CALL_DEPTH]}
+        {
+            context = NativeContext{0, MAX_CALL_DEPTH, registers.get() + REGISTER_COUNT, NativeContext::NONE, 0};
+
+            const Function& main = module->functions[module->mainFunction()];
+            if (main.registerCount > REGISTER_COUNT) {
+                throw RuntimeException("Too many globals", 0);
+            }
+
+            memset(registers.get(), 0, main.slotCount * sizeof(Slot));
+            for (const ArraySlot& array : main.arrays) {
+                registers[array.slot].array = ArrayStorage::create(array.start, array.length);
+            }
+        }
+
+        ~VM() {
+            leave(module->functions[module->mainFunction()], registers.get());
+        }
+
+        VM(const VM&) = delete;
+        VM& operator=(const VM&) = delete;
+
+        /* runs the main block */
+        template <bool COUNT = false>
+        void run() {
+            const Function& main = module->functions[module->mainFunction()];
+            frameCount = 0;
+            execute<COUNT>(&main, main.code.data(), registers.get());
+        }
+
+        /* calls a function with the given arguments (in registers behind the ones of main), returns its result */
+        template <bool COUNT = false>
+        Slot call(size_t function, const std::vector<Slot>& arguments) {
+            const Function& main = module->functions[module->mainFunction()];
+            Slot* base = registers.get() + main.registerCount;
+
+            // the result goes to the first register, the callee's frame begins behind it
+            for (size_t i = 0; i < arguments.size(); i++) {
+                base[1 + i] = arguments[i];
+            }
+            entry[0] = Instruction{CALL, 0, 1, 0, static_cast<int32_t>(function)};
+            entry[1] = Instruction{HALT, 0, 0, 0, 0};
+
+            frameCount = 0;
+            execute<COUNT>(&entryFunction, entry, base);
+            return base[0];
+        }
+
+    private:
+        struct Frame {
+            const Function* function;
+            const Instruction* pc;    // the CALL to return to
+            Slot* base;
+        };
+
+        const Module* module;
+        OutputSink& out;
+
+        std::unique_ptr<Slot[]> registers;
+        std::unique_ptr<Frame[]> frames;
+        size_t frameCount = 0;
+        NativeContext context;
+
+        // what call() runs: a CALL of the function followed by a HALT
+        Instruction entry[2];
+        Function entryFunction;
+
+        /*
+         * zeroes the declarations (and the result) of a callee, gives it its arrays: array arguments are copies
+         * with the bounds of the parameter (the TypeChecker only demands the same length)
+         */
+        static void enter(const Function& function, Slot* base) {
+            memset(base + function.argumentCount, 0, (function.slotCount - function.argumentCount) * sizeof(Slot));
+
+            for (const ArraySlot& array : function.arrays) {
+                if (array.slot < function.argumentCount) {
+                    base[array.slot].array = ArrayStorage::copy(base[array.slot].array);
+                    base[array.slot].array->start = array.start;
+                } else {
+                    base[array.slot].array = ArrayStorage::create(array.start, array.length);
+                }
+            }
+        }
+
+        static void leave(const Function& function, Slot* base) {
+            for (const ArraySlot& array : function.arrays) {
+                free(base[array.slot].array);
+            }
+        }
+
+        [[noreturn]] void fail(const char* message, const Function* function, const Instruction* pc, Slot* base) {
+            fail(message, function->lines.empty() ? 0 : function->lines[pc - function->code.data()], function, base);
+        }
+
+        /* releases the arrays of all frames that a runtime error unwinds, then throws it */
+        [[noreturn]] void fail(const char* message, int line, const Function* function, Slot* base) {
+            const Function* main = &module->functions[module->mainFunction()];
+
+            while (frameCount > 0) {
+                if (function != main) {
+                    leave(*function, base);
+                }
+
+                Frame& frame = frames[--frameCount];
+                function = frame.function;
+                base = frame.base;
+            }
+
+            throw RuntimeException(message, line);
+        }
+
+        void writeReal(double real) {
+            char digits[32];
+            int length = snprintf(digits, sizeof(digits), "%g", real);
+            out << std::string_view(digits, length);
+        }
+
+        template <bool COUNT>
+        void execute(const Function* function, const Instruction* pc, Slot* base) {
+            #define BYTECODE_LABEL(name, format) &&op_##name,
+            static void* const labels[] = { BYTECODE_OPCODES(BYTECODE_LABEL) };
+            #undef BYTECODE_LABEL
+
+            const Slot* constants = module->constants.data();
+            Slot* globals = registers.get();
+            Slot* registersEnd = registers.get() + REGISTER_COUNT;
+            const Instruction* code = function->code.data();
+
+            #define DISPATCH() do { if (COUNT) executed++; goto *labels[pc->op]; } while (0)
+            #define NEXT() do { pc++; DISPATCH(); } while (0)
+            #define JUMP() do { pc = code + pc->d; DISPATCH(); } while (0)
+            #define R(operand) base[pc->operand]
+            // integers wrap around instead of overflowing
+            #define WRAP(l, op, r) static_cast<int64_t>(static_cast<uint64_t>(l) op static_cast<uint64_t>(r))
+
+            DISPATCH();
+
+            op_MOVE:      R(a) = R(b); NEXT();
+            op_LOADK:     R(a) = constants[pc->d]; NEXT();
+            op_GETGLOBAL: R(a) = globals[pc->d]; NEXT();
+            op_SETGLOBAL: globals[pc->d] = R(b); NEXT();
+            op_ITOR:      R(a).real = R(b).integer; NEXT();
+
+            op_ADDI: R(a).integer = WRAP(R(b).integer, +, R(c).integer); NEXT();
+            op_SUBI: R(a).integer = WRAP(R(b).integer, -, R(c).integer); NEXT();
+            op_MULI: R(a).integer = WRAP(R(b).integer, *, R(c).integer); NEXT();
+            op_DIVI: {
+                int64_t divisor = R(c).integer;
+                if (divisor == 0) {
+                    fail("Division by zero", function, pc, base);
+                }
+                R(a).integer = divisor == -1 ? WRAP(0, -, R(b).integer) : R(b).integer / divisor;
+                NEXT();
+            }
+            op_NEGI: R(a).integer = WRAP(0, -, R(b).integer); NEXT();
+
+            op_ADDR: R(a).real = R(b).real + R(c).real; NEXT();
+            op_SUBR: R(a).real = R(b).real - R(c).real; NEXT();
+            op_MULR: R(a).real = R(b).real * R(c).real; NEXT();
+            op_DIVR: R(a).real = R(b).real / R(c).real; NEXT();
+            op_NEGR: R(a).real = -R(b).real; NEXT();
+
+            op_NOT: R(a).integer = R(b).integer ^ 1; NEXT();
+
+            op_EQI: R(a).integer = R(b).integer == R(c).integer; NEXT();
+            op_NEI: R(a).integer = R(b).integer != R(c).integer; NEXT();
+            op_LTI: R(a).integer = R(b).integer <  R(c).integer; NEXT();
+            op_LEI: R(a).integer = R(b).integer <= R(c).integer; NEXT();
+            op_GTI: R(a).integer = R(b).integer >  R(c).integer; NEXT();
+            op_GEI: R(a).integer = R(b).integer >= R(c).integer; NEXT();
+
+            op_EQR: R(a).integer = R(b).real == R(c).real; NEXT();
+            op_NER: R(a).integer = R(b).real != R(c).real; NEXT();
+            op_LTR: R(a).integer = R(b).real <  R(c).real; NEXT();
+            op_LER: R(a).integer = R(b).real <= R(c).real; NEXT();
+            op_GTR: R(a).integer = R(b).real >  R(c).real; NEXT();
+            op_GER: R(a).integer = R(b).real >= R(c).real; NEXT();
+
+            op_JMP:  JUMP();
+            op_JMPF: if (!R(a).integer) JUMP(); NEXT();
+            op_JMPT: if (R(a).integer) JUMP(); NEXT();
+
+            op_JEQI: if (R(a).integer == R(b).integer) JUMP(); NEXT();
+            op_JNEI: if (R(a).integer != R(b).integer) JUMP(); NEXT();
+            op_JLTI: if (R(a).integer <  R(b).integer) JUMP(); NEXT();
+            op_JLEI: if (R(a).integer <= R(b).integer) JUMP(); NEXT();
+            op_JGTI: if (R(a).integer >  R(b).integer) JUMP(); NEXT();
+            op_JGEI: if (R(a).integer >= R(b).integer) JUMP(); NEXT();
+
+            op_GETELEM: {
+                ArrayStorage* array = R(b).array;
+                uint64_t position = static_cast<uint64_t>(R(c).integer) - static_cast<uint64_t>(array->start);
+                if (position >= array->length) {
+                    fail(("Array index " + std::to_string(R(c).integer) + " out of bounds").c_str(), function, pc, base);
+                }
+                R(a) = array->elements[position];
+                NEXT();
+            }
+            op_SETELEM: {
+                ArrayStorage* array = R(a).array;
+                uint64_t position = static_cast<uint64_t>(R(b).integer) - static_cast<uint64_t>(array->start);
+                if (position >= array->length) {
+                    fail(("Array index " + std::to_string(R(b).integer) + " out of bounds").c_str(), function, pc, base);
+                }
+                array->elements[position] = R(c);
+                NEXT();
+            }
+            op_COPYARRAY: {
+                ArrayStorage* to = R(a).array;
+                memcpy(to->elements, R(b).array->elements, to->length * sizeof(Slot));
+                NEXT();
+            }
+
+            op_CALL: {
+                const Function* callee = &module->functions[pc->d];
+                Slot* calleeBase = base + pc->b;
+
+                if (frameCount == MAX_CALL_DEPTH || calleeBase + callee->registerCount > registersEnd) {
+                    fail("Stack overflow", function, pc, base);
+                }
+
+                if (callee->native != NULL) {
+                    context.depth = frameCount + 1;
+                    int64_t result = module->enter(calleeBase, &context, callee->native);
+
+                    if (context.error != NativeContext::NONE) {
+                        const char* message = context.error == NativeContext::DIVISION_BY_ZERO ? "Division by zero" : "Stack overflow";
+                        context.error = NativeContext::NONE;
+                        fail(message, context.line, function, base);
+                    }
+                    R(a).integer = result;
+                    NEXT();
+                }
+
+                frames[frameCount++] = Frame{function, pc, base};
+                enter(*callee, calleeBase);
+
+                function = callee;
+                code = callee->code.data();
+                base = calleeBase;
+                pc = code;
+                DISPATCH();
+            }
+            op_RET: {
+                Slot result;
+                if (function->resultSlot != UNRESOLVED) {
+                    result = base[function->resultSlot];
+                }
+                leave(*function, base);
+
+                Frame& frame = frames[--frameCount];
+                function = frame.function;
+                code = function->code.data();
+                base = frame.base;
+                pc = frame.pc;
+
+                R(a) = result;
+                NEXT();
+            }
+            op_HALT:
+                return;
+
+            op_WRITEI:  out << static_cast<long>(R(a).integer); NEXT();
+            op_WRITER:  writeReal(R(a).real); NEXT();
+            op_WRITEB:  out << (R(a).integer ? "true" : "false"); NEXT();
+            op_WRITES:  out << module->strings[pc->d]; NEXT();
+            op_WRITELN: out << '\n'; NEXT();
+
+            #undef DISPATCH
+            #undef NEXT
+            #undef JUMP
+            #undef R
+            #undef WRAP
+        }
+    };
+}
@@ -144,4 +144,78 @@ const char* TOKEN_NAMES[] = {
     /* Identifier */
     [TokenType::IDENTIFIER] = "IDENTIFIER"
 
-};
\ No newline at end of file
+};
+
+/* spelling of all tokens that always look the same, so their text never has to be copied from the lexer.
+   Literals and identifiers have no fixed spelling (NULL). */
+const char* TOKEN_SPELLINGS[] = {
+    [0] = NULL,
+
+    /* Keywords */
+    [TokenType::PROGRAM] = "program",
+    [TokenType::FUNCTION] = "function",
+    [TokenType::PROCEDURE] = "procedure",
+
+    [TokenType::BEGIN_] = "begin",
+    [TokenType::END_] = "end",
+
+    [TokenType::IF] = "if",
+    [TokenType::THEN] = "then",
+    [TokenType::ELSE] = "else",
+    [TokenType::WHILE] = "while",
+    [TokenType::DO] = "do",
+
+    [TokenType::VAR] = "var",
+    [TokenType::OF] = "of",
+
+    /* Syntactical symbols */
+    [TokenType::COMMA] = ",",
+    [TokenType::COLON] = ":",
+    [TokenType::SEMICOLON] = ";",
+    [TokenType::DOT] = ".",
+    [TokenType::RANGE_DOTS] = "..",
+
+    [TokenType::BRACKETS_OPEN] = "(",
+    [TokenType::BRACKETS_CLOSING] = ")",
+    [TokenType::SQUARE_OPEN] = "[",
+    [TokenType::SQUARE_CLOSING] = "]",
+
+    /* Data types */
+    [TokenType::INTEGER] = "integer",
+    [TokenType::REAL] = "real",
+    [TokenType::BOOLEAN] = "boolean",
+    [TokenType::ARRAY] = "array",
+
+    /* Operators */
+    [TokenType::OP_ASSIGNMENT] = ":=",
+
+    [TokenType::OP_NOT] = "not",
+
+    [TokenType::OP_EQUALS] = "=",
+    [TokenType::OP_NOT_EQUALS] = "<>",
+    [TokenType::OP_LESS] = "<",
+    [TokenType::OP_LESS_EQUAL] = "<=",
+    [TokenType::OP_GREATER] = ">",
+    [TokenType::OP_GREATER_EQUAL] = ">=",
+
+    [TokenType::OP_ADD] = "+",
+    [TokenType::OP_SUB] = "-",
+    [TokenType::OP_MUL] = "*",
+    [TokenType::OP_DIV] = "/",
+    [TokenType::OP_INTEGER_DIV] = "div",
+
+    [TokenType::OP_AND] = "and",
+    [TokenType::OP_OR] = "or",
+
+    /* Literals */
+    [TokenType::LITERAL_INTEGER] = NULL,
+    [TokenType::LITERAL_REAL] = NULL,
+    [TokenType::LITERAL_STRING] = NULL,
+
+    [TokenType::LITERAL_TRUE] = "true",
+    [TokenType::LITERAL_FALSE] = "false",
+
+    /* Identifier */
+    [TokenType::IDENTIFIER] = NULL
+
+};
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../parser/AST/Program.h"
+#include "../parser/AST/Visitor.h"
+#include "../parser/OutputSink.h"
+#include "Resolver.h"
+#include "RuntimeException.h"
+#include "TypeChecker.h"
+#include "Value.h"
+
+/**
+ * Runs a program by walking its AST. All names are resolved up front (see Resolver), a variable access is an
+ * index into the current frame or the globals. Frames live on a preallocated value stack; the arrays a frame
+ * declares (and arrays passed by value) are allocated on entry and released on return.
+ *
+ * The types are checked before anything runs as well (see TypeChecker), an operator reads the type it works on
+ * from its expression instead of looking at the values: `/` always divides reals, `div` integers, integers turn
+ * into reals where they meet reals. `and`/`or` evaluate their right operand only when it decides the result.
+ * What can only go wrong while running (division by zero, an index out of bounds, too deep recursion) throws a
+ * RuntimeException.
+ */
+class Interpreter : public ASTVisitor<Interpreter, Value> {
+public:
+    static const size_t STACK_SIZE = 1 << 16; // values, arrays are allocated separately
+    static const size_t MAX_CALL_DEPTH = 10000;
+
+    /* resolves and checks the program, throws a SemanticException if it cannot be run; write()/writeln() go to out */
+    Interpreter(Program* prog, OutputSink* out)
+        : prog{prog}, resolver{prog}, types{prog, resolver}, out{*out}, stack(STACK_SIZE)
+    {
+        globals = allocate(resolver.globals, globalValues);
+    }
+
+    ~Interpreter() {
+        release(resolver.globals, globals);
+    }
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    /* runs the main block (the globals keep their values from previous runs) */
+    void run() {
+        frame = stack.data();
+        top = stack.data();
+        visit(prog->main);
+    }
+
+    /* calls a method of the program directly, returns its result (nothing for procedures) */
+    Value call(size_t method, const std::vector<Value>& arguments, int lineNumber = 0) {
+        frame = stack.data();
+        top = stack.data();
+
+        const FrameLayout& layout = resolver.frames[method];
+        Value* callee = enter(layout, lineNumber);
+        for (size_t i = 0; i < arguments.size() && i < layout.argumentCount; i++) {
+            assign(callee[i], arguments[i], lineNumber);
+        }
+
+        return invoke(method, callee);
+    }
+
+    /* --------------- Program ----------------- */
+    Value visitProgram(Program*) {
+        run();
+        return Value();
+    }
+
+
+    /* --------------- Statements ----------------- */
+    Value visitAssignment(Stmt::Assignment* stmt) {
+        Value& target = variable(stmt->slot);
+        int line = stmt->identifier.lineNumber;
+
+        if (stmt->arrayIndex != NULL) {
+            Value& element = elementOf(target, visit(stmt->arrayIndex), line);
+            assign(element, visit(stmt->value), line);
+        } else {
+            assign(target, visit(stmt->value), line);
+        }
+        return Value();
+    }
+
+    Value visitCall(Stmt::Call* stmt) {
+        if (stmt->target.builtin) {
+            write(stmt->arguments, stmt->target.index == WRITELN);
+        } else {
+            callMethod(stmt->target.index, stmt->arguments, stmt->callee.lineNumber);
+        }
+        return Value();
+    }
+
+    Value visitIf(Stmt::If* stmt) {
+        if (condition(stmt->condition)) {
+            visit(stmt->thenBody);
+        } else if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+        return Value();
+    }
+
+    Value visitWhile(Stmt::While* stmt) {
+        while (condition(stmt->condition)) {
+            visit(stmt->body);
+        }
+        return Value();
+    }
+
+    Value visitBlock(Stmt::Block* stmt) {
+        for (auto const& stmtInside : stmt->statements) {
+            visit(stmtInside);
+        }
+        return Value();
+    }
+
+
+    /* --------------- Expressions ---------------- */
+    Value visitBinary(Expr::Binary* expr) {
+        TokenType op = expr->op.type;
+        Value left = visit(expr->left);
+
+        if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+            if (left.boolean == (op == TokenType::OP_OR)) {
+                return left;
+            }
+            return visit(expr->right);
+        }
+
+        Value right = visit(expr->right);
+
+        // the common case first: both operands are integers
+        if (expr->operandType == ValueType::INTEGER) {
+            uint64_t l = left.integer, r = right.integer; // wraps around instead of overflowing
+
+            switch (op) {
+                case TokenType::OP_ADD:           return Value::ofInteger(l + r);
+                case TokenType::OP_SUB:           return Value::ofInteger(l - r);
+                case TokenType::OP_MUL:           return Value::ofInteger(l * r);
+                case TokenType::OP_INTEGER_DIV:   return Value::ofInteger(integerDivision(left.integer, right.integer, expr->op.lineNumber));
+                case TokenType::OP_EQUALS:        return Value::ofBoolean(left.integer == right.integer);
+                case TokenType::OP_NOT_EQUALS:    return Value::ofBoolean(left.integer != right.integer);
+                case TokenType::OP_LESS:          return Value::ofBoolean(left.integer < right.integer);
+                case TokenType::OP_LESS_EQUAL:    return Value::ofBoolean(left.integer <= right.integer);
+                case TokenType::OP_GREATER:       return Value::ofBoolean(left.integer > right.integer);
+                case TokenType::OP_GREATER_EQUAL: return Value::ofBoolean(left.integer >= right.integer);
+                default: break;
+            }
+        } else if (expr->operandType == ValueType::REAL) {
+            double l = toReal(left, expr->left->type), r = toReal(right, expr->right->type);
+
+            switch (op) {
+                case TokenType::OP_ADD:           return Value::ofReal(l + r);
+                case TokenType::OP_SUB:           return Value::ofReal(l - r);
+                case TokenType::OP_MUL:           return Value::ofReal(l * r);
+                case TokenType::OP_DIV:           return Value::ofReal(l / r);
+                case TokenType::OP_EQUALS:        return Value::ofBoolean(l == r);
+                case TokenType::OP_NOT_EQUALS:    return Value::ofBoolean(l != r);
+                case TokenType::OP_LESS:          return Value::ofBoolean(l < r);
+                case TokenType::OP_LESS_EQUAL:    return Value::ofBoolean(l <= r);
+                case TokenType::OP_GREATER:       return Value::ofBoolean(l > r);
+                case TokenType::OP_GREATER_EQUAL: return Value::ofBoolean(l >= r);
+                default: break;
+            }
+        } else {
+            // booleans, false < true
+            switch (op) {
+                case TokenType::OP_EQUALS:        return Value::ofBoolean(left.boolean == right.boolean);
+                case TokenType::OP_NOT_EQUALS:    return Value::ofBoolean(left.boolean != right.boolean);
+                case TokenType::OP_LESS:          return Value::ofBoolean(left.boolean < right.boolean);
+                case TokenType::OP_LESS_EQUAL:    return Value::ofBoolean(left.boolean <= right.boolean);
+                case TokenType::OP_GREATER:       return Value::ofBoolean(left.boolean > right.boolean);
+                case TokenType::OP_GREATER_EQUAL: return Value::ofBoolean(left.boolean >= right.boolean);
+                default: break;
+            }
+        }
+
+        // the TypeChecker lets no other combination through
+        throw RuntimeException(std::string("Operator '") + std::string(expr->op.text()) + "' cannot be applied to " +
+                               typeName(expr->operandType), expr->op.lineNumber);
+    }
+
+    Value visitCall(Expr::Call* expr) {
+        return callMethod(expr->target.index, expr->arguments, expr->callee.lineNumber);
+    }
+
+    Value visitGrouping(Expr::Grouping* expr) {
+        return visit(expr->expression);
+    }
+
+    Value visitIdentifier(Expr::Identifier* expr) {
+        Value& value = variable(expr->slot);
+
+        if (expr->arrayIndexExpression != NULL) {
+            return elementOf(value, visit(expr->arrayIndexExpression), expr->token.lineNumber);
+        }
+        return value;
+    }
+
+    Value visitLiteral(Expr::Literal* expr) {
+        return resolver.constants[expr->constant];
+    }
+
+    Value visitUnary(Expr::Unary* expr) {
+        Value right = visit(expr->right);
+
+        // the TypeChecker allows not on booleans and - on numbers only
+        switch (expr->type) {
+            case ValueType::BOOLEAN: return Value::ofBoolean(!right.boolean);
+            case ValueType::REAL:    return Value::ofReal(-right.real);
+            default:                 return Value::ofInteger(-static_cast<uint64_t>(right.integer));
+        }
+    }
+
+private:
+    Program* prog;
+    Resolver resolver;
+    TypeChecker types; // leaves the type of every expression on it
+    OutputSink& out;
+
+    std::vector<Value> globalValues;
+    Value* globals;
+
+    std::vector<Value> stack;
+    Value* frame = NULL; // slots of the running method
+    Value* top = NULL;   // first free slot behind it
+    size_t depth = 0;
+
+    Value& variable(VariableSlot slot) {
+        return slot.global ? globals[slot.index] : frame[slot.index];
+    }
+
+    bool condition(Expr::Expression* expr) {
+        return visit(expr).boolean; // a boolean, see TypeChecker
+    }
+
+    /* --------------- Calls ----------------- */
+    Value callMethod(uint32_t method, const ArenaVector<Expr::Expression*>& arguments, int lineNumber) {
+        const FrameLayout& layout = resolver.frames[method];
+
+        // reserve the callee's frame first, calls inside the arguments go on top of it
+        Value* callee = enter(layout, lineNumber);
+        for (size_t i = 0; i < layout.argumentCount; i++) {
+            assign(callee[i], visit(arguments[i]), lineNumber);
+        }
+
+        return invoke(method, callee);
+    }
+
+    Value* enter(const FrameLayout& layout, int lineNumber) {
+        if (depth >= MAX_CALL_DEPTH || top + layout.slots.size() > stack.data() + stack.size()) {
+            throw RuntimeException("Stack overflow", lineNumber);
+        }
+
+        Value* callee = top;
+        top += layout.slots.size();
+
+        for (size_t i = 0; i < layout.slots.size(); i++) {
+            callee[i] = Value();
+            callee[i].type = elementType(*layout.slots[i]);
+        }
+        for (uint32_t slot : layout.arraySlots) {
+            callee[slot] = newArray(*layout.slots[slot]);
+        }
+        return callee;
+    }
+
+    Value invoke(uint32_t method, Value* callee) {
+        const FrameLayout& layout = resolver.frames[method];
+
+        Value* callerFrame = frame;
+        frame = callee;
+        depth++;
+
+        visit(prog->methods[method]->block);
+
+        depth--;
+        frame = callerFrame;
+        top = callee;
+
+        Value result = layout.resultSlot != UNRESOLVED ? callee[layout.resultSlot] : Value();
+        for (uint32_t slot : layout.arraySlots) {
+            delete callee[slot].array;
+        }
+        return result;
+    }
+
+    Value* allocate(const FrameLayout& layout, std::vector<Value>& values) {
+        values.assign(layout.slots.size(), Value());
+
+        for (size_t i = 0; i < layout.slots.size(); i++) {
+            values[i].type = elementType(*layout.slots[i]);
+        }
+        for (uint32_t slot : layout.arraySlots) {
+            values[slot] = newArray(*layout.slots[slot]);
+        }
+        return values.data();
+    }
+
+    void release(const FrameLayout& layout, Value* values) {
+        for (uint32_t slot : layout.arraySlots) {
+            delete values[slot].array;
+        }
+    }
+
+    static Value newArray(const Variable::VariableType& type) {
+        const Variable::VariableTypeArray& arrayType = static_cast<const Variable::VariableTypeArray&>(type);
+        return Value::ofArray(new Array(Resolver::integer(arrayType.startRange), Resolver::integer(arrayType.stopRange), elementType(type)));
+    }
+
+    /* --------------- Values ----------------- */
+    /* stores value into target (which has the declared type), integers become reals, arrays are copied */
+    static void assign(Value& target, Value value, int lineNumber) {
+        if (target.type == value.type && value.type != ValueType::ARRAY) {
+            target = value;
+        } else if (target.type == ValueType::REAL && value.type == ValueType::INTEGER) {
+            target.real = value.integer;
+        } else if (target.type == ValueType::ARRAY && value.type == ValueType::ARRAY) {
+            Array* to = target.array;
+            Array* from = value.array;
+
+            if (to->length != from->length || to->elementType != from->elementType) {
+                throw RuntimeException("Arrays of different types", lineNumber);
+            }
+            std::copy(from->elements, from->elements + from->length, to->elements);
+        } else {
+            throw RuntimeException(std::string("Cannot assign ") + typeName(value.type) + " to " + typeName(target.type), lineNumber);
+        }
+    }
+
+    static Value& elementOf(Value& array, Value index, int lineNumber) {
+        uint64_t position = static_cast<uint64_t>(index.integer) - static_cast<uint64_t>(array.array->start);
+        if (position >= array.array->length) {
+            throw RuntimeException("Array index " + std::to_string(index.integer) + " out of bounds", lineNumber);
+        }
+        return array.array->elements[position];
+    }
+
+    static int64_t integerDivision(int64_t left, int64_t right, int lineNumber) {
+        if (right == 0) {
+            throw RuntimeException("Division by zero", lineNumber);
+        }
+        if (right == -1) {
+            return -static_cast<uint64_t>(left); // INT64_MIN div -1 wraps around
+        }
+        return left / right;
+    }
+
+    /* an operand of the given static type as a real */
+    static double toReal(Value value, ValueType type) { return type == ValueType::INTEGER ? value.integer : value.real; }
+
+    /* --------------- Builtins ----------------- */
+    void write(const ArenaVector<Expr::Expression*>& arguments, bool newline) {
+        for (const auto& argExpr : arguments) {
+            Value value = visit(argExpr);
+
+            switch (argExpr->type) {
+                case ValueType::INTEGER: out << value.integer; break;
+                case ValueType::REAL: {
+                    char digits[32];
+                    int length = snprintf(digits, sizeof(digits), "%g", value.real);
+                    out << std::string_view(digits, length);
+                } break;
+                case ValueType::BOOLEAN: out << (value.boolean ? "true" : "false"); break;
+                case ValueType::STRING:  out << *value.string; break;
+                case ValueType::ARRAY:   break; // rejected by the TypeChecker
+            }
+        }
+
+        if (newline) {
+            out << '\n';
+        }
+    }
+};
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <charconv>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../parser/AST/Program.h"
+#include "../parser/AST/Visitor.h"
+#include "../parser/SemanticException.h"
+#include "SymbolTable.h"
+#include "Value.h"
+
+/* functions the interpreter provides itself, called when no method of the program has their name */
+enum Builtin : uint32_t { WRITE, WRITELN };
+
+/**
+ * Layout of the frame of a method (or of the globals): the declared type of every slot. Arguments come first,
+ * in the order of the parameter list, then the local declarations and, for functions, the result.
+ */
+struct FrameLayout {
+    std::vector<const Variable::VariableType*> slots;
+    uint32_t argumentCount = 0;
+    uint32_t resultSlot = UNRESOLVED;  // functions only
+    std::vector<uint32_t> arraySlots;  // slots that need an Array of their own on entry
+};
+
+/**
+ * Resolves every name of a program before it runs: variables (Expr::Identifier, Stmt::Assignment targets) get
+ * their VariableSlot, calls their CallTarget and literals the index of their value in the constant table.
+ * Methods see their own arguments, declarations and result first, then the globals; the main block sees only
+ * the globals. Names that cannot be resolved, and names declared twice in the same scope (two methods, two
+ * variables, or a variable with the name of its function), throw a SemanticException. Every scope is a
+ * SymbolTable, so resolving takes time linear in the size of the program however many methods it has.
+ */
+class Resolver : public ASTVisitor<Resolver> {
+public:
+    std::vector<Value> constants;
+    FrameLayout globals;
+    std::vector<FrameLayout> frames; // one per method, in the order of Program::methods
+
+    Resolver(Program* prog) : prog{prog} {
+        globalNames.reset(prog->declarations.size());
+        for (const auto& declVar : prog->declarations) {
+            declare(globals, globalNames, declVar);
+        }
+
+        methodNames.reset(prog->methods.size());
+        for (uint32_t i = 0; i < prog->methods.size(); i++) {
+            const Token& name = prog->methods[i]->identifier;
+            if (!methodNames.insert(name.symbol, i)) {
+                throw SemanticException("Duplicate declaration of", name.text(), name.lineNumber);
+            }
+        }
+
+        visit(prog);
+    }
+
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    /* --------------- Program ----------------- */
+    void visitProgram(Program* prog) {
+        for (const auto& meth : prog->methods) {
+            visit(meth);
+        }
+
+        currentMethod = NULL;
+        visit(prog->main);
+    }
+
+
+    /* --------------- Methods ----------------- */
+    void visitMethod(Method* meth) {
+        currentMethod = meth;
+        localNames.reset(meth->arguments.size() + meth->declarations.size() + 1);
+
+        frames.emplace_back();
+        FrameLayout& frame = frames.back();
+
+        for (const auto& argVar : meth->arguments) {
+            declare(frame, localNames, argVar);
+        }
+        frame.argumentCount = frame.slots.size();
+
+        for (const auto& declVar : meth->declarations) {
+            declare(frame, localNames, declVar);
+        }
+
+        // the name of a function is the variable its result is assigned to
+        if (meth->returnType != NULL) {
+            if (meth->returnType->kind == Variable::VariableType::Kind::ARRAY) {
+                throw SemanticException("Array result of function", meth->identifier.text(), meth->identifier.lineNumber);
+            }
+
+            frame.resultSlot = frame.slots.size();
+            frame.slots.push_back(meth->returnType);
+            if (!localNames.insert(meth->identifier.symbol, frame.resultSlot)) {
+                throw SemanticException("Duplicate declaration of", meth->identifier.text(), meth->identifier.lineNumber);
+            }
+        }
+
+        visit(meth->block);
+    }
+
+    /* --------------- Statements ----------------- */
+    void visitAssignment(Stmt::Assignment* stmt) {
+        stmt->slot = variable(stmt->identifier, stmt->arrayIndex != NULL);
+
+        if (stmt->arrayIndex != NULL) {
+            visit(stmt->arrayIndex);
+        }
+        visit(stmt->value);
+    }
+
+    void visitCall(Stmt::Call* stmt) {
+        stmt->target = callTarget(stmt->callee, stmt->arguments.size(), false);
+
+        for (const auto& argExpr : stmt->arguments) {
+            visit(argExpr);
+        }
+    }
+
+    void visitIf(Stmt::If* stmt) {
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+
+        if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+    }
+
+    void visitWhile(Stmt::While* stmt) {
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+
+    void visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) {
+            visit(stmtInside);
+        }
+    }
+
+
+    /* --------------- Expressions ---------------- */
+    void visitBinary(Expr::Binary* expr) {
+        visit(expr->left);
+        visit(expr->right);
+    }
+
+    void visitCall(Expr::Call* expr) {
+        expr->target = callTarget(expr->callee, expr->arguments.size(), true);
+
+        for (const auto& argExpr : expr->arguments) {
+            visit(argExpr);
+        }
+    }
+
+    void visitGrouping(Expr::Grouping* expr) {
+        visit(expr->expression);
+    }
+
+    void visitIdentifier(Expr::Identifier* expr) {
+        expr->slot = variable(expr->token, expr->arrayIndexExpression != NULL);
+
+        if (expr->arrayIndexExpression != NULL) {
+            visit(expr->arrayIndexExpression);
+        }
+    }
+
+    void visitLiteral(Expr::Literal* expr) {
+        expr->constant = constants.size();
+        constants.push_back(literal(expr->token));
+    }
+
+    void visitUnary(Expr::Unary* expr) {
+        visit(expr->right);
+    }
+
+    /* the declared type of a resolved variable */
+    const Variable::VariableType* typeOf(VariableSlot slot, size_t method) const {
+        return slot.global ? globals.slots[slot.index] : frames[method].slots[slot.index];
+    }
+
+    /* the integer value of an array bound (or any integer literal) */
+    static int64_t integer(const Token& token) {
+        int64_t value = 0;
+        std::string_view text = token.text();
+
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc()) {
+            throw SemanticException("Integer out of range", text, token.lineNumber);
+        }
+        return value;
+    }
+
+    /* the value of a real literal, too small ones become 0 (or a denormal) like in C, too large ones are rejected */
+    static double real(const Token& token) {
+        std::string text(token.text()); // strtod needs a terminated string
+        errno = 0;
+        double value = strtod(text.c_str(), NULL);
+        if (errno == ERANGE && isinf(value)) {
+            throw SemanticException("Real out of range", token.text(), token.lineNumber);
+        }
+        return value;
+    }
+
+private:
+    Program* prog;
+    Method* currentMethod = NULL;
+
+    SymbolTable globalNames;
+    SymbolTable localNames;  // of the method being resolved
+    SymbolTable methodNames;
+
+    std::deque<std::string_view> strings; // texts of the string constants (without their quotes)
+
+    void declare(FrameLayout& frame, SymbolTable& names, Variable* var) {
+        uint32_t slot = frame.slots.size();
+
+        if (!names.insert(var->name.symbol, slot)) {
+            throw SemanticException("Duplicate declaration of", var->name.text(), var->name.lineNumber);
+        }
+
+        frame.slots.push_back(var->type);
+        if (var->type->kind == Variable::VariableType::Kind::ARRAY) {
+            frame.arraySlots.push_back(slot);
+        }
+    }
+
+    VariableSlot variable(const Token& name, bool indexed) {
+        VariableSlot slot;
+
+        uint32_t local = currentMethod != NULL ? localNames.find(name.symbol) : SymbolTable::NOT_FOUND;
+        if (local != SymbolTable::NOT_FOUND) {
+            slot = VariableSlot(local, false);
+        } else {
+            uint32_t global = globalNames.find(name.symbol);
+            if (global == SymbolTable::NOT_FOUND) {
+                throw SemanticException("Undeclared variable", name.text(), name.lineNumber);
+            }
+            slot = VariableSlot(global, true);
+        }
+
+        if (indexed && typeOf(slot, frames.size() - 1)->kind != Variable::VariableType::Kind::ARRAY) {
+            throw SemanticException("Not an array:", name.text(), name.lineNumber);
+        }
+        return slot;
+    }
+
+    CallTarget callTarget(const Token& callee, size_t argumentCount, bool needsResult) {
+        uint32_t method = methodNames.find(callee.symbol);
+
+        if (method == SymbolTable::NOT_FOUND) {
+            if (callee.text() == "write" || callee.text() == "writeln") {
+                if (needsResult) {
+                    throw SemanticException("Procedure used as a value:", callee.text(), callee.lineNumber);
+                }
+                return CallTarget(callee.text() == "write" ? WRITE : WRITELN, true);
+            }
+
+            throw SemanticException("Undeclared method", callee.text(), callee.lineNumber);
+        }
+
+        Method* meth = prog->methods[method];
+        if (meth->arguments.size() != argumentCount) {
+            throw SemanticException("Wrong number of arguments for", callee.text(), callee.lineNumber);
+        }
+        if (needsResult && meth->returnType == NULL) {
+            throw SemanticException("Procedure used as a value:", callee.text(), callee.lineNumber);
+        }
+
+        return CallTarget(method, false);
+    }
+
+    Value literal(const Token& token) {
+        switch (token.type) {
+            case TokenType::LITERAL_INTEGER: return Value::ofInteger(integer(token));
+            case TokenType::LITERAL_REAL:    return Value::ofReal(real(token));
+            case TokenType::LITERAL_TRUE:    return Value::ofBoolean(true);
+            case TokenType::LITERAL_FALSE:   return Value::ofBoolean(false);
+            default: {
+                std::string_view text = token.text();
+                strings.push_back(text.substr(1, text.size() - 2));
+                return Value::ofString(&strings.back());
+            }
+        }
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <exception>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+/* an error while running a program (division by zero, array index out of bounds, mismatching types, ...) */
+class RuntimeException : public std::exception {
+public:
+    RuntimeException(std::string_view what, int lineNumber)
+    {
+        std::stringstream ss;
+        ss << what << " on line " << lineNumber << "!";
+        message = ss.str();
+    };
+
+    const char* what() const throw() {
+        return message.c_str();
+    }
+
+private:
+    std::string message;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../parser/AST/StringInterner.h"
+
+/**
+ * The names of one scope (the globals, the methods, the locals of a method) with what they resolve to: open
+ * addressing over a single array of {symbol, value} entries, linear probing from a Fibonacci hash of the symbol.
+ * The table is kept at most half full, so a lookup touches one or two entries on average. Empty entries hold
+ * NO_SYMBOL, which no identifier is interned as.
+ */
+class SymbolTable {
+public:
+    static const uint32_t NOT_FOUND = UINT32_MAX;
+
+    SymbolTable() { reset(0); }
+
+    /* empties the table, with room for the given number of names without growing */
+    void reset(size_t expected) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < expected * 2) {
+            capacity *= 2;
+        }
+
+        if (capacity != entries.size()) {
+            entries.assign(capacity, Entry{NO_SYMBOL, 0});
+            setShift(capacity);
+        } else if (count > 0) {
+            std::fill(entries.begin(), entries.end(), Entry{NO_SYMBOL, 0});
+        }
+        count = 0;
+    }
+
+    /* adds the name, unless it is in the table already: returns whether it was added */
+    bool insert(Symbol name, uint32_t value) {
+        if ((count + 1) * 2 > entries.size()) {
+            grow();
+        }
+
+        Entry& entry = entries[probe(name)];
+        if (entry.symbol == name) {
+            return false;
+        }
+        entry = Entry{name, value};
+        count++;
+        return true;
+    }
+
+    /* what the name resolves to, NOT_FOUND if it is not in the table */
+    uint32_t find(Symbol name) const {
+        if (name == NO_SYMBOL) {
+            return NOT_FOUND;
+        }
+        const Entry& entry = entries[probe(name)];
+        return entry.symbol == name ? entry.value : NOT_FOUND;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    static const size_t MIN_CAPACITY = 8;
+
+    struct Entry {
+        Symbol symbol;
+        uint32_t value;
+    };
+
+    std::vector<Entry> entries; // capacity is a power of two
+    size_t count = 0;
+    unsigned shift = 0;         // 64 - log2(capacity): the top bits of the hash are the home index
+
+    void setShift(size_t capacity) {
+        shift = 64;
+        while (capacity > 1) {
+            capacity >>= 1;
+            shift--;
+        }
+    }
+
+    /* the entry holding the name, or the empty one where it belongs */
+    size_t probe(Symbol name) const {
+        size_t mask = entries.size() - 1;
+        size_t index = (name * UINT64_C(0x9E3779B97F4A7C15)) >> shift;
+
+        while (entries[index].symbol != name && entries[index].symbol != NO_SYMBOL) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void grow() {
+        std::vector<Entry> old;
+        old.swap(entries);
+        entries.assign(old.size() * 2, Entry{NO_SYMBOL, 0});
+        setShift(entries.size());
+
+        for (const Entry& entry : old) {
+            if (entry.symbol != NO_SYMBOL) {
+                entries[probe(entry.symbol)] = entry;
+            }
+        }
+    }
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <string>
+
+#include "../parser/AST/Program.h"
+#include "../parser/AST/Visitor.h"
+#include "../parser/SemanticException.h"
+#include "Resolver.h"
+#include "Types.h"
+
+/**
+ * Checks the types of a resolved program in a single walk and stores them on its expressions: Expression::type
+ * for every expression and Binary::operandType, which selects integer or real arithmetic (and makes `/` divide
+ * reals while `div` divides integers), so the back ends that compile by type read them instead of working them
+ * out again. Integers may be assigned, passed and returned (through the name of the function) where reals are
+ * expected; whole arrays only to arrays of the same length and element type, whatever their bounds (every back end
+ * copies the elements in order into the receiving array, which keeps its own bounds). The first mismatch throws a
+ * SemanticException. Every back end runs it first, the interpreter included.
+ */
+class TypeChecker : public ASTVisitor<TypeChecker, ValueType> {
+public:
+    TypeChecker(Program* prog, const Resolver& resolver) : prog{prog}, resolver{resolver} {
+        visit(prog);
+    }
+
+    TypeChecker(const TypeChecker&) = delete;
+    TypeChecker& operator=(const TypeChecker&) = delete;
+
+    /* --------------- Program ----------------- */
+    ValueType visitProgram(Program* prog) {
+        for (size_t i = 0; i < prog->methods.size(); i++) {
+            method = i;
+            visit(prog->methods[i]);
+        }
+
+        method = prog->methods.size();
+        visit(prog->main);
+        return ValueType::INTEGER;
+    }
+
+
+    /* --------------- Methods ----------------- */
+    ValueType visitMethod(Method* meth) {
+        visit(meth->block);
+        return ValueType::INTEGER;
+    }
+
+    /* --------------- Statements ----------------- */
+    ValueType visitAssignment(Stmt::Assignment* stmt) {
+        const Variable::VariableType& type = *resolver.typeOf(stmt->slot, method);
+        int line = stmt->identifier.lineNumber;
+
+        if (stmt->arrayIndex != NULL) {
+            index(stmt->arrayIndex);
+            assignable(stmt->value, elementType(type), line);
+        } else if (type.kind == Variable::VariableType::Kind::ARRAY) {
+            sameArray(stmt->value, type, line);
+        } else {
+            assignable(stmt->value, elementType(type), line);
+        }
+        return ValueType::INTEGER;
+    }
+
+    ValueType visitCall(Stmt::Call* stmt) {
+        int line = stmt->callee.lineNumber;
+
+        if (stmt->target.builtin) {
+            for (const auto& argExpr : stmt->arguments) {
+                write(argExpr, line);
+            }
+        } else {
+            arguments(stmt->target.index, stmt->arguments, line);
+        }
+        return ValueType::INTEGER;
+    }
+
+    ValueType visitIf(Stmt::If* stmt) {
+        condition(stmt->condition);
+        visit(stmt->thenBody);
+
+        if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+        return ValueType::INTEGER;
+    }
+
+    ValueType visitWhile(Stmt::While* stmt) {
+        condition(stmt->condition);
+        visit(stmt->body);
+        return ValueType::INTEGER;
+    }
+
+    ValueType visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) {
+            visit(stmtInside);
+        }
+        return ValueType::INTEGER;
+    }
+
+
+    /* --------------- Expressions (each returns the type it stored) ---------------- */
+    ValueType visitBinary(Expr::Binary* expr) {
+        ValueType left = visit(expr->left);
+        ValueType right = visit(expr->right);
+
+        if (expr->op.type == TokenType::OP_AND || expr->op.type == TokenType::OP_OR) {
+            requireType(left, ValueType::BOOLEAN, expr->op);
+            requireType(right, ValueType::BOOLEAN, expr->op);
+            expr->operandType = ValueType::BOOLEAN;
+        } else {
+            expr->operandType = operandType(left, right, expr->op);
+        }
+        return expr->type = resultType(left, right, expr->op);
+    }
+
+    ValueType visitCall(Expr::Call* expr) {
+        arguments(expr->target.index, expr->arguments, expr->callee.lineNumber);
+
+        // the Resolver made sure it is a function
+        return expr->type = elementType(*prog->methods[expr->target.index]->returnType);
+    }
+
+    ValueType visitGrouping(Expr::Grouping* expr) {
+        return expr->type = visit(expr->expression);
+    }
+
+    ValueType visitIdentifier(Expr::Identifier* expr) {
+        const Variable::VariableType& type = *resolver.typeOf(expr->slot, method);
+
+        if (expr->arrayIndexExpression != NULL) {
+            index(expr->arrayIndexExpression);
+            return expr->type = elementType(type);
+        }
+        return expr->type = type.kind == Variable::VariableType::Kind::ARRAY ? ValueType::ARRAY : elementType(type);
+    }
+
+    ValueType visitLiteral(Expr::Literal* expr) {
+        ValueType type = resolver.constants[expr->constant].type;
+        if (type == ValueType::STRING) {
+            throw SemanticException("String outside of write()/writeln():", expr->token.text(), expr->token.lineNumber);
+        }
+        return expr->type = type;
+    }
+
+    ValueType visitUnary(Expr::Unary* expr) {
+        ValueType type = visit(expr->right);
+
+        bool number = type == ValueType::INTEGER || type == ValueType::REAL;
+        if (!(expr->op.type == TokenType::OP_NOT && type == ValueType::BOOLEAN) && !(expr->op.type == TokenType::OP_SUB && number)) {
+            throw operandError(expr->op, type);
+        }
+        return expr->type = type;
+    }
+
+private:
+    Program* prog;
+    const Resolver& resolver;
+    size_t method;   // index of the method being checked, methods.size() for the main block
+
+    void index(Expr::Expression* expr) {
+        ValueType type = visit(expr);
+        if (type != ValueType::INTEGER) {
+            throw SemanticException(std::string("Array index is ") + typeName(type) + " instead of integer on line " +
+                                    std::to_string(Expr::lineOf(expr)) + "!");
+        }
+    }
+
+    void condition(Expr::Expression* expr) {
+        ValueType type = visit(expr);
+        if (type != ValueType::BOOLEAN) {
+            throw SemanticException(std::string("Condition is ") + typeName(type) + " instead of boolean on line " +
+                                    std::to_string(Expr::lineOf(expr)) + "!");
+        }
+    }
+
+    /* a value for a variable (or argument) of type, integers become reals */
+    void assignable(Expr::Expression* expr, ValueType type, int line) {
+        ValueType actual = visit(expr);
+        if (actual != type && !(actual == ValueType::INTEGER && type == ValueType::REAL)) {
+            throw assignError(actual, type, line);
+        }
+    }
+
+    /* arrays can only be assigned (or passed) to arrays of the same length and element type, the bounds may differ */
+    void sameArray(Expr::Expression* expr, const Variable::VariableType& type, int line) {
+        ValueType actual = visit(expr);
+        if (actual != ValueType::ARRAY || expr->kind != Expr::Kind::IDENTIFIER) {
+            throw assignError(actual, ValueType::ARRAY, line);
+        }
+
+        const Variable::VariableTypeArray& to = static_cast<const Variable::VariableTypeArray&>(type);
+        const Variable::VariableTypeArray& from = static_cast<const Variable::VariableTypeArray&>(
+            *resolver.typeOf(static_cast<Expr::Identifier*>(expr)->slot, method));
+        if (Resolver::integer(to.stopRange) - Resolver::integer(to.startRange) != Resolver::integer(from.stopRange) - Resolver::integer(from.startRange) ||
+            elementType(to) != elementType(from)) {
+            throw SemanticException("Arrays of different types on line " + std::to_string(line) + "!");
+        }
+    }
+
+    void arguments(uint32_t target, const ArenaVector<Expr::Expression*>& arguments, int line) {
+        const FrameLayout& callee = resolver.frames[target];
+
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const Variable::VariableType& type = *callee.slots[i];
+            if (type.kind == Variable::VariableType::Kind::ARRAY) {
+                sameArray(arguments[i], type, line);
+            } else {
+                assignable(arguments[i], elementType(type), line);
+            }
+        }
+    }
+
+    /* an argument of write()/writeln(): strings are fine here, arrays are not */
+    void write(Expr::Expression* expr, int line) {
+        if (expr->kind == Expr::Kind::LITERAL && resolver.constants[static_cast<Expr::Literal*>(expr)->constant].type == ValueType::STRING) {
+            expr->type = ValueType::STRING;
+            return;
+        }
+
+        if (visit(expr) == ValueType::ARRAY) {
+            throw SemanticException("Cannot write an array on line " + std::to_string(line) + "!");
+        }
+    }
+};
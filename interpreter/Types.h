@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+#include "../parser/AST/Token.h"
+#include "../parser/SemanticException.h"
+#include "Value.h"
+
+/* The typing rules, checked before a program runs or is translated (see TypeChecker) */
+
+inline SemanticException operandError(const Token& op, ValueType operand) {
+    return SemanticException(std::string("Operator '") + std::string(op.text()) + "' cannot be applied to " + typeName(operand) +
+                             " on line " + std::to_string(op.lineNumber) + "!");
+}
+
+inline SemanticException assignError(ValueType from, ValueType to, int line) {
+    return SemanticException(std::string("Cannot assign ") + typeName(from) + " to " + typeName(to) + " on line " + std::to_string(line) + "!");
+}
+
+/* the type both operands of a binary operator (other than and/or) are brought to */
+inline ValueType operandType(ValueType left, ValueType right, const Token& op) {
+    bool comparison = TokenType::OP_EQUALS <= op.type && op.type <= TokenType::OP_GREATER_EQUAL;
+    bool leftNumber = left == ValueType::INTEGER || left == ValueType::REAL;
+    bool rightNumber = right == ValueType::INTEGER || right == ValueType::REAL;
+
+    if (op.type == TokenType::OP_INTEGER_DIV) {
+        if (left != ValueType::INTEGER || right != ValueType::INTEGER) {
+            throw operandError(op, left != ValueType::INTEGER ? left : right);
+        }
+        return ValueType::INTEGER;
+    }
+    if (leftNumber && rightNumber) {
+        return left == ValueType::INTEGER && right == ValueType::INTEGER && op.type != TokenType::OP_DIV ? ValueType::INTEGER : ValueType::REAL;
+    }
+    if (comparison && left == ValueType::BOOLEAN && right == ValueType::BOOLEAN) {
+        return ValueType::BOOLEAN;
+    }
+    throw operandError(op, leftNumber ? right : left);
+}
+
+inline void requireType(ValueType actual, ValueType expected, const Token& op) {
+    if (actual != expected) {
+        throw operandError(op, actual);
+    }
+}
+
+/* the type of the result of a binary operator */
+inline ValueType resultType(ValueType left, ValueType right, const Token& op) {
+    if (op.type == TokenType::OP_AND || op.type == TokenType::OP_OR) {
+        requireType(left, ValueType::BOOLEAN, op);
+        requireType(right, ValueType::BOOLEAN, op);
+        return ValueType::BOOLEAN;
+    }
+
+    ValueType type = operandType(left, right, op);
+    return TokenType::OP_EQUALS <= op.type && op.type <= TokenType::OP_GREATER_EQUAL ? ValueType::BOOLEAN : type;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string_view>
+
+#include "../parser/AST/Slots.h"
+#include "../parser/AST/Variable.h"
+
+struct Array;
+
+/**
+ * A run time value, tagged with its type. Integers are 64 bits wide and wrap around on overflow. Arrays are
+ * referenced, the Array itself belongs to the frame (or the globals) that declared it; strings only occur as
+ * literal arguments of write()/writeln() and point to their constant.
+ */
+struct Value {
+    ValueType type;
+    union {
+        int64_t integer;
+        double real;
+        bool boolean;
+        Array* array;
+        const std::string_view* string;
+    };
+
+    Value() : type{ValueType::INTEGER}, integer{0} {}
+
+    static Value ofInteger(int64_t integer) { Value v; v.integer = integer; return v; }
+    static Value ofReal(double real) { Value v; v.type = ValueType::REAL; v.real = real; return v; }
+    static Value ofBoolean(bool boolean) { Value v; v.type = ValueType::BOOLEAN; v.boolean = boolean; return v; }
+    static Value ofArray(Array* array) { Value v; v.type = ValueType::ARRAY; v.array = array; return v; }
+    static Value ofString(const std::string_view* string) { Value v; v.type = ValueType::STRING; v.string = string; return v; }
+};
+
+/* elements of an array [start..stop], all of the same type */
+struct Array {
+    Array(int64_t start, int64_t stop, ValueType elementType)
+        : start{start}, length{stop >= start ? static_cast<size_t>(stop - start + 1) : 0}, elementType{elementType},
+          elements{new Value[length]}
+    {
+        for (size_t i = 0; i < length; i++) {
+            elements[i].type = elementType;
+        }
+    }
+
+    ~Array() { delete[] elements; }
+
+    Array(const Array&) = delete;
+    Array& operator=(const Array&) = delete;
+
+    int64_t start;
+    size_t length;
+    ValueType elementType;
+    Value* elements; // zero values until assigned
+};
+
+inline const char* typeName(ValueType type) {
+    switch (type) {
+        case ValueType::INTEGER: return "integer";
+        case ValueType::REAL:    return "real";
+        case ValueType::BOOLEAN: return "boolean";
+        case ValueType::ARRAY:   return "array";
+        case ValueType::STRING:  return "string";
+    }
+    return "?";
+}
+
+/* type of the values of a simple type, or of the elements of an array type */
+inline ValueType elementType(const Variable::VariableType& type) {
+    switch (type.typeName.type) {
+        case TokenType::REAL:    return ValueType::REAL;
+        case TokenType::BOOLEAN: return ValueType::BOOLEAN;
+        default:                 return ValueType::INTEGER;
+    }
+}
@@ -0,0 +1,555 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../parser/AST/Program.h"
+#include "../parser/AST/Visitor.h"
+#include "../parser/SemanticException.h"
+#include "../interpreter/Resolver.h"
+#include "../interpreter/TypeChecker.h"
+#include "IR.h"
+
+namespace IR {
+    /**
+     * Lowers a resolved program to SSA form, with the algorithm of Braun et al. ("Simple and Efficient
+     * Construction of Static Single Assignment Form"): the current value of every local variable is tracked per
+     * block while lowering, a read in a block with several predecessors places a phi, and blocks whose
+     * predecessors are not all known yet (loop headers) are sealed once they are. Phis that turn out to
+     * choose between one value only are removed again.
+     *
+     * Local scalars (arguments, declarations, the result) are SSA values, every assignment a COPY the passes
+     * can propagate. Globals can change in every call, so they are loaded and stored (LOADG/STOREG) where the
+     * program uses them, arrays are referenced through ARRAY. The types come from the TypeChecker, which also
+     * decides where ITORs go; and/or evaluate their right operand in a block of its own.
+     */
+    class Builder : public ASTVisitor<Builder, Instruction*> {
+    public:
+        Builder(Program* prog) : prog{prog}, resolver{prog}, types{prog, resolver} {}
+
+        Builder(const Builder&) = delete;
+        Builder& operator=(const Builder&) = delete;
+
+        /* lowers the whole program, the module belongs to the caller */
+        Module* build() {
+            std::unique_ptr<Module> built(new Module());
+            module = built.get();
+
+            for (const auto& var : prog->declarations) {
+                module->globalNames.push_back(var->name.text());
+            }
+
+            visit(prog);
+            return built.release();
+        }
+
+        /* --------------- Program ----------------- */
+        Instruction* visitProgram(Program* prog) {
+            for (size_t i = 0; i < prog->methods.size(); i++) {
+                methodIndex = i;
+                visit(prog->methods[i]);
+            }
+
+            // main: all of its variables are globals
+            methodIndex = prog->methods.size();
+            begin(prog->identifier.text(), resolver.globals, module->globalNames);
+            function->main = true;
+
+            visit(prog->main);
+            end(NULL);
+            return NULL;
+        }
+
+
+        /* --------------- Methods ----------------- */
+        Instruction* visitMethod(Method* meth) {
+            const FrameLayout& layout = resolver.frames[methodIndex];
+
+            std::vector<std::string_view> names;
+            for (const auto& var : meth->arguments) names.push_back(var->name.text());
+            for (const auto& var : meth->declarations) names.push_back(var->name.text());
+            if (meth->returnType != NULL) names.push_back(meth->identifier.text());
+
+            begin(meth->identifier.text(), layout, names);
+            function->argumentCount = layout.argumentCount;
+            if (meth->returnType != NULL) {
+                function->function = true;
+                function->resultType = elementType(*meth->returnType);
+            }
+
+            for (uint32_t i = 0; i < layout.argumentCount; i++) {
+                if (layout.slots[i]->kind == Variable::VariableType::Kind::SIMPLE) {
+                    Instruction* param = emit(PARAM, elementType(*layout.slots[i]), {}, meth->identifier.lineNumber);
+                    param->immediate = i;
+                    param->variable = i;
+                    writeVariable(i, current, param);
+                }
+            }
+
+            visit(meth->block);
+            end(meth->returnType != NULL ? readVariable(layout.resultSlot, current) : NULL);
+            return NULL;
+        }
+
+        /* --------------- Statements ----------------- */
+        Instruction* visitAssignment(Stmt::Assignment* stmt) {
+            int line = stmt->identifier.lineNumber;
+            const Variable::VariableType* type = typeOf(stmt->slot);
+
+            if (stmt->arrayIndex != NULL) {
+                Instruction* array = arrayOf(stmt->slot, line);
+                Instruction* index = visit(stmt->arrayIndex);
+                Instruction* value = converted(stmt->value, elementType(*type), line);
+                emit(SETELEM, ValueType::INTEGER, {array, index, value}, line)->value = false;
+            } else if (type->kind == Variable::VariableType::Kind::ARRAY) {
+                Instruction* to = arrayOf(stmt->slot, line);
+                Instruction* from = visit(stmt->value);
+                emit(COPYARRAY, ValueType::INTEGER, {to, from}, line)->value = false;
+            } else {
+                Instruction* value = converted(stmt->value, elementType(*type), line);
+
+                if (stmt->slot.global) {
+                    Instruction* store = emit(STOREG, value->type, {value}, line);
+                    store->immediate = stmt->slot.index;
+                    store->value = false;
+                } else {
+                    Instruction* copy = emit(COPY, value->type, {value}, line);
+                    copy->variable = stmt->slot.index;
+                    writeVariable(stmt->slot.index, current, copy);
+                }
+            }
+            return NULL;
+        }
+
+        Instruction* visitCall(Stmt::Call* stmt) {
+            int line = stmt->callee.lineNumber;
+
+            if (stmt->target.builtin) {
+                for (const auto& argExpr : stmt->arguments) {
+                    write(argExpr, line);
+                }
+                if (stmt->target.index == Builtin::WRITELN) {
+                    emit(WRITELN, ValueType::INTEGER, {}, line)->value = false;
+                }
+            } else {
+                call(stmt->target.index, stmt->arguments, line);
+            }
+            return NULL;
+        }
+
+        Instruction* visitIf(Stmt::If* stmt) {
+            Instruction* condition = visit(stmt->condition);
+            Block* thenBlock = newBlock();
+            Block* elseBlock = stmt->elseBody != NULL ? newBlock() : NULL;
+            Block* join = newBlock();
+
+            branch(condition, thenBlock, elseBlock != NULL ? elseBlock : join);
+
+            seal(thenBlock);
+            current = thenBlock;
+            visit(stmt->thenBody);
+            jump(join);
+
+            if (elseBlock != NULL) {
+                seal(elseBlock);
+                current = elseBlock;
+                visit(stmt->elseBody);
+                jump(join);
+            }
+
+            seal(join);
+            current = join;
+            return NULL;
+        }
+
+        Instruction* visitWhile(Stmt::While* stmt) {
+            // the header is sealed once the back edge from the end of the body is known
+            Block* header = newBlock();
+            jump(header);
+            current = header;
+
+            Instruction* condition = visit(stmt->condition);
+            Block* body = newBlock();
+            Block* exit = newBlock();
+            branch(condition, body, exit);
+
+            seal(body);
+            current = body;
+            visit(stmt->body);
+            jump(header);
+            seal(header);
+
+            seal(exit);
+            current = exit;
+            return NULL;
+        }
+
+        Instruction* visitBlock(Stmt::Block* stmt) {
+            for (auto const& stmtInside : stmt->statements) {
+                visit(stmtInside);
+            }
+            return NULL;
+        }
+
+
+        /* --------------- Expressions (each returns the instruction computing its value) ---------------- */
+        Instruction* visitBinary(Expr::Binary* expr) {
+            int line = expr->op.lineNumber;
+            TokenType op = expr->op.type;
+
+            if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+                Instruction* left = visit(expr->left);
+
+                // left decides alone when it is false (and) or true (or), otherwise right does
+                Block* rightBlock = newBlock();
+                Block* join = newBlock();
+                if (op == TokenType::OP_AND) {
+                    branch(left, rightBlock, join);
+                } else {
+                    branch(left, join, rightBlock);
+                }
+
+                seal(rightBlock);
+                current = rightBlock;
+                Instruction* right = visit(expr->right);
+                jump(join);
+
+                seal(join);
+                current = join;
+                Instruction* phi = newPhi(join, ValueType::BOOLEAN, UINT32_MAX);
+                phi->operands = {left, right};
+                return tryRemoveTrivialPhi(phi);
+            }
+
+            Instruction* left = visit(expr->left);
+            Instruction* right = visit(expr->right);
+
+            if (expr->operandType == ValueType::REAL) {
+                left = toReal(left, line);
+                right = toReal(right, line);
+            }
+
+            Opcode opcode;
+            switch (op) {
+                case TokenType::OP_ADD:           opcode = ADD; break;
+                case TokenType::OP_SUB:           opcode = SUB; break;
+                case TokenType::OP_MUL:           opcode = MUL; break;
+                case TokenType::OP_INTEGER_DIV:   opcode = DIV; break;
+                case TokenType::OP_EQUALS:        opcode = EQ; break;
+                case TokenType::OP_NOT_EQUALS:    opcode = NE; break;
+                case TokenType::OP_LESS:          opcode = LT; break;
+                case TokenType::OP_LESS_EQUAL:    opcode = LE; break;
+                case TokenType::OP_GREATER:       opcode = GT; break;
+                case TokenType::OP_GREATER_EQUAL: opcode = GE; break;
+                default:                          opcode = RDIV; break; // OP_DIV
+            }
+            return emit(opcode, expr->type, {left, right}, line);
+        }
+
+        Instruction* visitCall(Expr::Call* expr) {
+            return call(expr->target.index, expr->arguments, expr->callee.lineNumber);
+        }
+
+        Instruction* visitGrouping(Expr::Grouping* expr) {
+            return visit(expr->expression);
+        }
+
+        Instruction* visitIdentifier(Expr::Identifier* expr) {
+            int line = expr->token.lineNumber;
+            const Variable::VariableType* type = typeOf(expr->slot);
+
+            if (expr->arrayIndexExpression != NULL) {
+                Instruction* array = arrayOf(expr->slot, line);
+                Instruction* index = visit(expr->arrayIndexExpression);
+                return emit(GETELEM, elementType(*type), {array, index}, line);
+            }
+            if (type->kind == Variable::VariableType::Kind::ARRAY) {
+                return arrayOf(expr->slot, line);
+            }
+
+            if (expr->slot.global) {
+                Instruction* load = emit(LOADG, elementType(*type), {}, line);
+                load->immediate = expr->slot.index;
+                return load;
+            }
+            return readVariable(expr->slot.index, current);
+        }
+
+        Instruction* visitLiteral(Expr::Literal* expr) {
+            const Value& value = resolver.constants[expr->constant];
+            Instruction* constant = emit(CONST, value.type, {}, expr->token.lineNumber);
+            switch (value.type) {
+                case ValueType::REAL:    constant->real = value.real; break;
+                case ValueType::BOOLEAN: constant->immediate = value.boolean; break;
+                default:                 constant->immediate = value.integer; break;
+            }
+            return constant;
+        }
+
+        Instruction* visitUnary(Expr::Unary* expr) {
+            Instruction* right = visit(expr->right);
+            return emit(expr->op.type == TokenType::OP_NOT ? NOT : NEG, expr->type, {right}, expr->op.lineNumber);
+        }
+
+    private:
+        Program* prog;
+        Resolver resolver;
+        TypeChecker types;        // leaves the type of every expression on it
+
+        Module* module;
+        Function* function;       // being built
+        size_t methodIndex;       // of the function being built (main comes after the methods)
+        const FrameLayout* layout;
+        Block* current;           // where instructions go
+
+        // state of the SSA construction, by block id
+        std::vector<std::unordered_map<uint32_t, Instruction*>> definitions; // current value of each local slot
+        std::vector<std::vector<Instruction*>> incompletePhis;                // placed before the block was sealed
+        std::vector<bool> sealed;
+
+        void begin(std::string_view name, const FrameLayout& frame, const std::vector<std::string_view>& names) {
+            module->functions.emplace_back(new Function());
+            function = module->functions.back().get();
+            function->name = name;
+            function->slotNames = names;
+            layout = &frame;
+
+            definitions.clear();
+            incompletePhis.clear();
+            sealed.clear();
+
+            current = newBlock();
+            seal(current);
+        }
+
+        void end(Instruction* result) {
+            Instruction* ret = emit(RETURN, result != NULL ? result->type : ValueType::INTEGER, {}, 0);
+            ret->value = false;
+            if (result != NULL) {
+                ret->operands.push_back(result);
+            }
+
+            removeTrivialPhis();
+            function->redirectOperands();
+        }
+
+        Block* newBlock() {
+            definitions.emplace_back();
+            incompletePhis.emplace_back();
+            sealed.push_back(false);
+            return function->newBlock();
+        }
+
+        Instruction* emit(Opcode op, ValueType type, std::initializer_list<Instruction*> operands, int line) {
+            Instruction* instruction = function->newInstruction(op);
+            instruction->type = type;
+            instruction->operands = operands;
+            instruction->line = line;
+            instruction->block = current;
+
+            current->instructions.push_back(instruction);
+            return instruction;
+        }
+
+        void jump(Block* target) {
+            Instruction* instruction = emit(JUMP, ValueType::INTEGER, {}, 0);
+            instruction->value = false;
+            instruction->targets = {target};
+            target->predecessors.push_back(current);
+        }
+
+        void branch(Instruction* condition, Block* ifTrue, Block* ifFalse) {
+            Instruction* instruction = emit(BRANCH, ValueType::INTEGER, {condition}, 0);
+            instruction->value = false;
+            instruction->targets = {ifTrue, ifFalse};
+            ifTrue->predecessors.push_back(current);
+            ifFalse->predecessors.push_back(current);
+        }
+
+        /* --------------- SSA construction ----------------- */
+        void writeVariable(uint32_t slot, Block* block, Instruction* value) {
+            definitions[block->id][slot] = value;
+        }
+
+        Instruction* readVariable(uint32_t slot, Block* block) {
+            auto found = definitions[block->id].find(slot);
+            if (found != definitions[block->id].end()) {
+                return Function::resolve(found->second);
+            }
+
+            Instruction* value;
+            if (!sealed[block->id]) {
+                // not all predecessors are known, the phi gets its operands when they are
+                value = newPhi(block, variableType(slot), slot);
+                incompletePhis[block->id].push_back(value);
+            } else if (block->predecessors.empty()) {
+                value = zero(slot); // read before the first assignment
+            } else if (block->predecessors.size() == 1) {
+                value = readVariable(slot, block->predecessors[0]);
+            } else {
+                // the phi is the value while its operands are read, which breaks cycles through loops
+                Instruction* phi = newPhi(block, variableType(slot), slot);
+                writeVariable(slot, block, phi);
+                value = addPhiOperands(phi);
+            }
+
+            writeVariable(slot, block, value);
+            return value;
+        }
+
+        Instruction* addPhiOperands(Instruction* phi) {
+            for (Block* predecessor : phi->block->predecessors) {
+                phi->operands.push_back(readVariable(phi->variable, predecessor));
+            }
+            return tryRemoveTrivialPhi(phi);
+        }
+
+        /* a phi choosing between itself and one other value only is that value */
+        Instruction* tryRemoveTrivialPhi(Instruction* phi) {
+            Instruction* same = NULL;
+            for (Instruction* operand : phi->operands) {
+                operand = Function::resolve(operand);
+                if (operand == same || operand == phi) {
+                    continue;
+                }
+                if (same != NULL) {
+                    return phi;
+                }
+                same = operand;
+            }
+
+            if (same == NULL) {
+                same = zero(phi->variable); // only reachable through itself
+            }
+
+            phi->replacement = same;
+            std::vector<Instruction*>& instructions = phi->block->instructions;
+            instructions.erase(std::find(instructions.begin(), instructions.end(), phi));
+            return same;
+        }
+
+        /* removing a phi can make phis that used it trivial, until none is left */
+        void removeTrivialPhis() {
+            for (bool changed = true; changed; ) {
+                changed = false;
+
+                for (const auto& block : function->blocks) {
+                    std::vector<Instruction*> phis;
+                    for (Instruction* instruction : block->instructions) {
+                        if (instruction->op != PHI) break;
+                        phis.push_back(instruction);
+                    }
+
+                    for (Instruction* phi : phis) {
+                        changed |= tryRemoveTrivialPhi(phi) != phi;
+                    }
+                }
+            }
+        }
+
+        void seal(Block* block) {
+            for (Instruction* phi : incompletePhis[block->id]) {
+                addPhiOperands(phi);
+            }
+            incompletePhis[block->id].clear();
+            sealed[block->id] = true;
+        }
+
+        /* a phi at the start of block, behind the other phis */
+        Instruction* newPhi(Block* block, ValueType type, uint32_t slot) {
+            Instruction* phi = function->newInstruction(PHI);
+            phi->type = type;
+            phi->block = block;
+            phi->variable = slot;
+
+            auto position = block->instructions.begin();
+            while (position != block->instructions.end() && (*position)->op == PHI) {
+                position++;
+            }
+            block->instructions.insert(position, phi);
+            return phi;
+        }
+
+        /* the value of a local before its first assignment, in the entry block behind the parameters */
+        Instruction* zero(uint32_t slot) {
+            Block* entry = function->blocks[0].get();
+
+            Instruction* constant = function->newInstruction(CONST);
+            constant->type = variableType(slot);
+            constant->block = entry;
+
+            auto position = entry->instructions.begin();
+            while (position != entry->instructions.end() && (*position)->op == PARAM) {
+                position++;
+            }
+            entry->instructions.insert(position, constant);
+            return constant;
+        }
+
+        /* --------------- Values ----------------- */
+        Instruction* toReal(Instruction* value, int line) {
+            return value->type == ValueType::REAL ? value : emit(ITOR, ValueType::REAL, {value}, line);
+        }
+
+        /* the value of expr converted to type (for assignments and arguments) */
+        Instruction* converted(Expr::Expression* expr, ValueType type, int line) {
+            Instruction* value = visit(expr);
+            return type == ValueType::REAL ? toReal(value, line) : value;
+        }
+
+        Instruction* arrayOf(VariableSlot slot, int line) {
+            Instruction* array = emit(ARRAY, ValueType::ARRAY, {}, line);
+            array->immediate = slot.index;
+            array->global = slot.global;
+            return array;
+        }
+
+        Instruction* call(uint32_t method, const ArenaVector<Expr::Expression*>& arguments, int line) {
+            const FrameLayout& callee = resolver.frames[method];
+
+            std::vector<Instruction*> values;
+            for (size_t i = 0; i < arguments.size(); i++) {
+                const Variable::VariableType& type = *callee.slots[i];
+                values.push_back(type.kind == Variable::VariableType::Kind::ARRAY
+                    ? visit(arguments[i])
+                    : converted(arguments[i], elementType(type), line));
+            }
+
+            const Variable::VariableType* returnType = prog->methods[method]->returnType;
+            Instruction* instruction = emit(CALL, returnType != NULL ? elementType(*returnType) : ValueType::INTEGER, {}, line);
+            instruction->operands = std::move(values);
+            instruction->immediate = method;
+            instruction->value = returnType != NULL;
+            return instruction;
+        }
+
+        void write(Expr::Expression* expr, int line) {
+            if (expr->kind == Expr::Kind::LITERAL) {
+                const Value& value = resolver.constants[static_cast<Expr::Literal*>(expr)->constant];
+
+                if (value.type == ValueType::STRING) {
+                    Instruction* instruction = emit(WRITES, ValueType::STRING, {}, line);
+                    instruction->immediate = module->strings.size();
+                    instruction->value = false;
+                    module->strings.push_back(*value.string);
+                    return;
+                }
+            }
+
+            Instruction* value = visit(expr);
+            emit(WRITE, value->type, {value}, line)->value = false;
+        }
+
+        /* --------------- Types ----------------- */
+        const Variable::VariableType* typeOf(VariableSlot slot) {
+            return resolver.typeOf(slot, methodIndex);
+        }
+
+        ValueType variableType(uint32_t slot) {
+            return elementType(*layout->slots[slot]);
+        }
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+
+#include "IR.h"
+
+namespace IR {
+    /**
+     * The dominator tree of a function, by the iterative algorithm of Cooper, Harvey and Kennedy ("A Simple,
+     * Fast Dominance Algorithm"): immediate dominators are intersected along the reverse postorder until nothing
+     * changes, which takes two or three rounds on the structured control flow Pascal has. The traversals keep
+     * their own stacks, so large functions do not run out of call stack.
+     */
+    struct Dominators {
+        std::vector<Block*> order;                 // reverse postorder of the reachable blocks, entry first
+        std::vector<Block*> immediate;             // dominator of every block (by id), NULL for the entry and unreachable ones
+        std::vector<std::vector<Block*>> children; // in the dominator tree, by id
+
+        Dominators(const Function& function)
+            : immediate(function.blocks.size(), NULL), children(function.blocks.size()),
+              position(function.blocks.size(), UNREACHED)
+        {
+            postorder(function.blocks[0].get());
+            order.assign(postorderBlocks.rbegin(), postorderBlocks.rend());
+            for (size_t i = 0; i < order.size(); i++) {
+                position[order[i]->id] = i;
+            }
+
+            Block* entry = order[0];
+            immediate[entry->id] = entry;
+
+            for (bool changed = true; changed; ) {
+                changed = false;
+
+                for (size_t i = 1; i < order.size(); i++) {
+                    Block* block = order[i];
+                    Block* dominator = NULL;
+
+                    for (Block* predecessor : block->predecessors) {
+                        if (immediate[predecessor->id] == NULL) {
+                            continue; // not processed yet (or unreachable)
+                        }
+                        dominator = dominator == NULL ? predecessor : intersect(predecessor, dominator);
+                    }
+
+                    if (immediate[block->id] != dominator) {
+                        immediate[block->id] = dominator;
+                        changed = true;
+                    }
+                }
+            }
+
+            immediate[entry->id] = NULL;
+            for (size_t i = 1; i < order.size(); i++) {
+                children[immediate[order[i]->id]->id].push_back(order[i]);
+            }
+        }
+
+        bool reachable(const Block* block) const { return position[block->id] != UNREACHED; }
+
+        /* whether every path from the entry to b passes a (a block dominates itself) */
+        bool dominates(const Block* a, const Block* b) const {
+            while (b != NULL && b != a) {
+                b = immediate[b->id];
+            }
+            return b == a;
+        }
+
+    private:
+        static constexpr size_t UNREACHED = SIZE_MAX;
+
+        std::vector<size_t> position; // in order, by id
+        std::vector<Block*> postorderBlocks;
+
+        void postorder(Block* entry) {
+            std::vector<bool> visited(position.size(), false);
+            std::vector<std::pair<Block*, size_t>> stack; // block and the next successor to visit
+
+            visited[entry->id] = true;
+            stack.emplace_back(entry, 0);
+
+            while (!stack.empty()) {
+                auto& [block, next] = stack.back();
+                const std::vector<Block*>& successors = block->successors();
+
+                if (next < successors.size()) {
+                    Block* successor = successors[next++];
+                    if (!visited[successor->id]) {
+                        visited[successor->id] = true;
+                        stack.emplace_back(successor, 0);
+                    }
+                } else {
+                    postorderBlocks.push_back(block);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        Block* intersect(Block* a, Block* b) const {
+            while (a != b) {
+                while (position[a->id] > position[b->id]) a = immediate[a->id];
+                while (position[b->id] > position[a->id]) b = immediate[b->id];
+            }
+            return a;
+        }
+    };
+}
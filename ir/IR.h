@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "../interpreter/Value.h"
+
+namespace IR {
+    /* what the passes may do with an instruction */
+    enum Effect : uint8_t {
+        NONE = 0,      // has to stay where it is: writes memory, calls, traps or ends a block
+        REMOVABLE = 1, // may be deleted when its value is unused
+        MERGEABLE = 2, // may be replaced by an identical instruction that dominates it
+        PURE = REMOVABLE | MERGEABLE
+    };
+
+    /* every opcode with what the passes may do with it; the typed variants are chosen by the type of the operands */
+    #define IR_OPCODES(X) \
+        X(CONST, PURE)          /* integer/boolean immediate, or real */ \
+        X(PARAM, PURE)          /* argument number immediate */ \
+        X(PHI, REMOVABLE)       /* one operand per predecessor of the block, in their order */ \
+        X(COPY, PURE)           /* the operand, as the new value of a variable */ \
+        X(ITOR, PURE)           /* integer operand converted to real */ \
+        \
+        X(ADD, PURE) X(SUB, PURE) X(MUL, PURE) X(NEG, PURE) \
+        X(DIV, MERGEABLE)       /* integer division, traps on zero */ \
+        X(RDIV, PURE)           /* real division */ \
+        X(NOT, PURE) \
+        X(EQ, PURE) X(NE, PURE) X(LT, PURE) X(LE, PURE) X(GT, PURE) X(GE, PURE) \
+        \
+        X(ARRAY, PURE)          /* reference to the array variable in slot immediate (a global one if global) */ \
+        X(LOADG, REMOVABLE)     /* global immediate, calls may change it */ \
+        X(STOREG, NONE)         /* global immediate = operand */ \
+        X(GETELEM, NONE)        /* array[index], traps out of bounds */ \
+        X(SETELEM, NONE)        /* array[index] = value */ \
+        X(COPYARRAY, NONE)      /* elements of the first array = elements of the second */ \
+        \
+        X(CALL, NONE)           /* method immediate with the operands as arguments */ \
+        X(WRITE, NONE) X(WRITES, NONE) /* the operand / string immediate */ \
+        X(WRITELN, NONE) \
+        \
+        X(JUMP, NONE)           /* to the first target */ \
+        X(BRANCH, NONE)         /* to the first target if the operand is true, the second if not */ \
+        X(RETURN, NONE)         /* with the operand as result, if there is one */
+
+    #define IR_ENUM(name, effect) name,
+    enum Opcode : uint8_t { IR_OPCODES(IR_ENUM) OPCODE_COUNT };
+    #undef IR_ENUM
+
+    #define IR_NAME(name, effect) #name,
+    const char* const OPCODE_NAMES[] = { IR_OPCODES(IR_NAME) };
+    #undef IR_NAME
+
+    #define IR_EFFECT(name, effect) effect,
+    const Effect OPCODE_EFFECTS[] = { IR_OPCODES(IR_EFFECT) };
+    #undef IR_EFFECT
+
+    struct Block;
+
+    /**
+     * An instruction, which is the value it computes as well (SSA: every value is assigned exactly once, by
+     * the instruction that computes it). Instructions that compute nothing have value unset.
+     */
+    struct Instruction {
+        Opcode op;
+        ValueType type = ValueType::INTEGER;
+        bool value = true;
+        bool global = false;                // ARRAY: of a global
+        int64_t immediate = 0;
+        double real = 0;                    // CONST of a real
+        std::vector<Instruction*> operands;
+        std::vector<Block*> targets;        // JUMP, BRANCH
+        Block* block = NULL;
+        uint32_t variable = UINT32_MAX;     // the slot it is the new value of (COPY, PHI), for the dump
+        int line = 0;
+
+        Instruction* replacement = NULL;    // set when a pass replaced it, until the operands are redirected
+        bool marked = false;                // scratch flag of the pass running
+
+        Instruction(Opcode op) : op{op} {}
+
+        bool isTerminator() const { return op == JUMP || op == BRANCH || op == RETURN; }
+    };
+
+    /* a basic block: instructions without a jump in between, the last one is a JUMP, BRANCH or RETURN */
+    struct Block {
+        uint32_t id;
+        std::vector<Instruction*> instructions;
+        std::vector<Block*> predecessors;
+
+        Block(uint32_t id) : id{id} {}
+
+        Instruction* terminator() const { return instructions.empty() ? NULL : instructions.back(); }
+
+        const std::vector<Block*>& successors() const { return terminator()->targets; }
+    };
+
+    /* a method (or the main block) in SSA form, blocks[0] is the entry */
+    struct Function {
+        std::string_view name;
+        std::vector<std::string_view> slotNames; // of the frame (see FrameLayout), the globals for main
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<std::unique_ptr<Instruction>> instructions; // all ever created, including removed ones
+        uint32_t argumentCount = 0;
+        bool main = false;
+        bool function = false;                   // returns a value, of resultType
+        ValueType resultType = ValueType::INTEGER;
+
+        Block* newBlock() {
+            blocks.emplace_back(new Block(blocks.size()));
+            return blocks.back().get();
+        }
+
+        Instruction* newInstruction(Opcode op) {
+            instructions.emplace_back(new Instruction(op));
+            return instructions.back().get();
+        }
+
+        /* the instructions still in blocks */
+        size_t size() const {
+            size_t count = 0;
+            for (const auto& block : blocks) {
+                count += block->instructions.size();
+            }
+            return count;
+        }
+
+        /* redirects every operand to what replaced it, after a pass replaced instructions */
+        void redirectOperands() {
+            for (const auto& block : blocks) {
+                for (Instruction* instruction : block->instructions) {
+                    for (Instruction*& operand : instruction->operands) {
+                        operand = resolve(operand);
+                    }
+                }
+            }
+        }
+
+        /* what an instruction stands for now, following its chain of replacements */
+        static Instruction* resolve(Instruction* instruction) {
+            while (instruction->replacement != NULL) {
+                instruction = instruction->replacement;
+            }
+            return instruction;
+        }
+    };
+
+    /* the methods of a program in their order, main last */
+    struct Module {
+        std::vector<std::unique_ptr<Function>> functions;
+        std::vector<std::string_view> globalNames;
+        std::vector<std::string_view> strings;   // of WRITES
+
+        size_t size() const {
+            size_t count = 0;
+            for (const auto& function : functions) {
+                count += function->size();
+            }
+            return count;
+        }
+    };
+}
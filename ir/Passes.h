@@ -0,0 +1,269 @@
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IR.h"
+#include "Dominators.h"
+#include "Verifier.h"
+
+namespace IR {
+    /* removes the instructions a pass replaced from their blocks and redirects their uses */
+    inline void removeReplaced(Function& function) {
+        for (const auto& block : function.blocks) {
+            std::vector<Instruction*>& instructions = block->instructions;
+            instructions.erase(std::remove_if(instructions.begin(), instructions.end(),
+                                              [](Instruction* instruction) { return instruction->replacement != NULL; }),
+                               instructions.end());
+        }
+        function.redirectOperands();
+    }
+
+    /**
+     * Copy propagation: every use of a COPY uses what it copies instead. A phi all of whose operands are the
+     * same value (or the phi itself) then is that value as well, which is repeated until nothing changes.
+     */
+    inline void propagateCopies(Function& function) {
+        for (bool changed = true; changed; ) {
+            changed = false;
+
+            for (const auto& block : function.blocks) {
+                for (Instruction* instruction : block->instructions) {
+                    if (instruction->replacement != NULL) {
+                        continue;
+                    }
+
+                    if (instruction->op == COPY) {
+                        instruction->replacement = Function::resolve(instruction->operands[0]);
+                        changed = true;
+                    } else if (instruction->op == PHI) {
+                        Instruction* same = NULL;
+                        bool trivial = true;
+
+                        for (Instruction* operand : instruction->operands) {
+                            operand = Function::resolve(operand);
+                            if (operand == instruction || operand == same) continue;
+                            if (same != NULL) {
+                                trivial = false;
+                                break;
+                            }
+                            same = operand;
+                        }
+
+                        if (trivial && same != NULL) {
+                            instruction->replacement = same;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        removeReplaced(function);
+    }
+
+    /**
+     * Common subexpression elimination over the dominator tree: an instruction that may be merged (see
+     * Effect) and computes the same as one in a dominating block, or before it in its own, is replaced by that
+     * one. The table of what is available is scoped: entries of a subtree are dropped when the walk leaves it.
+     * Operands of commutative operators are ordered, so a + b and b + a are found as the same.
+     */
+    inline void eliminateCommonSubexpressions(Function& function) {
+        // instructions that may be merged have two operands at most
+        struct Key {
+            Opcode op;
+            ValueType type;
+            bool global;
+            int64_t immediate;
+            uint64_t real; // the bits, so that 0.0 and -0.0 stay apart
+            Instruction* operands[2];
+
+            bool operator==(const Key& other) const {
+                return op == other.op && type == other.type && global == other.global && immediate == other.immediate &&
+                       real == other.real && operands[0] == other.operands[0] && operands[1] == other.operands[1];
+            }
+        };
+        struct KeyHash {
+            size_t operator()(const Key& key) const {
+                size_t hash = std::hash<int64_t>()(key.immediate) ^ (std::hash<uint64_t>()(key.real) << 1);
+                hash = hash * 31 + (key.op << 8 | static_cast<uint8_t>(key.type) << 1 | key.global);
+                hash = hash * 31 + std::hash<Instruction*>()(key.operands[0]);
+                return hash * 31 + std::hash<Instruction*>()(key.operands[1]);
+            }
+        };
+
+        Dominators dominators(function);
+        std::unordered_map<Key, Instruction*, KeyHash> available;
+        std::vector<Key> added;                       // entries in the order they were made available
+        std::vector<std::pair<Block*, size_t>> stack; // block of the walk and the size of added when it was entered
+
+        stack.emplace_back(function.blocks[0].get(), 0);
+        while (!stack.empty()) {
+            auto [block, mark] = stack.back();
+            stack.pop_back();
+
+            if (block == NULL) {
+                // leaving a subtree
+                while (added.size() > mark) {
+                    available.erase(added.back());
+                    added.pop_back();
+                }
+                continue;
+            }
+
+            mark = added.size();
+            for (Instruction* instruction : block->instructions) {
+                if (!(OPCODE_EFFECTS[instruction->op] & MERGEABLE)) {
+                    continue;
+                }
+
+                Key key{instruction->op, instruction->type, instruction->global, instruction->immediate, 0, {NULL, NULL}};
+                memcpy(&key.real, &instruction->real, sizeof(key.real));
+                for (size_t i = 0; i < instruction->operands.size(); i++) {
+                    key.operands[i] = Function::resolve(instruction->operands[i]);
+                }
+                if ((instruction->op == ADD || instruction->op == MUL || instruction->op == EQ || instruction->op == NE) &&
+                    key.operands[1] < key.operands[0]) {
+                    std::swap(key.operands[0], key.operands[1]);
+                }
+
+                auto found = available.find(key);
+                if (found != available.end()) {
+                    instruction->replacement = found->second;
+                } else {
+                    available.emplace(key, instruction);
+                    added.push_back(key);
+                }
+            }
+
+            stack.emplace_back(static_cast<Block*>(NULL), mark);
+            for (Block* child : dominators.children[block->id]) {
+                stack.emplace_back(child, 0);
+            }
+        }
+
+        removeReplaced(function);
+    }
+
+    /**
+     * Dead code elimination (mark and sweep): instructions that have to stay (see Effect) are live, as is
+     * everything they use, transitively; all others are removed. Cycles of phis that only feed each other die
+     * together, which a count of uses would not find.
+     */
+    inline void eliminateDeadCode(Function& function) {
+        std::vector<Instruction*> worklist;
+
+        for (const auto& block : function.blocks) {
+            for (Instruction* instruction : block->instructions) {
+                instruction->marked = !(OPCODE_EFFECTS[instruction->op] & REMOVABLE);
+                if (instruction->marked) {
+                    worklist.push_back(instruction);
+                }
+            }
+        }
+
+        while (!worklist.empty()) {
+            Instruction* instruction = worklist.back();
+            worklist.pop_back();
+
+            for (Instruction* operand : instruction->operands) {
+                if (!operand->marked) {
+                    operand->marked = true;
+                    worklist.push_back(operand);
+                }
+            }
+        }
+
+        for (const auto& block : function.blocks) {
+            std::vector<Instruction*>& instructions = block->instructions;
+            instructions.erase(std::remove_if(instructions.begin(), instructions.end(),
+                                              [](Instruction* instruction) { return !instruction->marked; }),
+                               instructions.end());
+        }
+    }
+
+    /**
+     * Runs passes over every function of a module, in the order they were added, and measures each: the time
+     * it took over the whole module and the instructions before and after it. With verify set the module is
+     * checked after every pass (see Verifier.h), a pass that breaks it throws a std::logic_error naming it.
+     */
+    class PassManager {
+    public:
+        struct Pass {
+            const char* name;
+            std::function<void(Function&)> run;
+        };
+
+        struct Timing {
+            const char* name;
+            double milliseconds;
+            size_t before, after; // instructions
+        };
+
+        bool verify = false;
+        std::vector<Timing> timings; // of every pass run, in order
+
+        void add(const char* name, std::function<void(Function&)> run) {
+            passes.push_back(Pass{name, std::move(run)});
+        }
+
+        /* copy propagation, then CSE (which finds more with the copies gone), then DCE for what both left unused */
+        static PassManager standard() {
+            PassManager manager;
+            manager.add("copy-propagation", propagateCopies);
+            manager.add("cse", eliminateCommonSubexpressions);
+            manager.add("dce", eliminateDeadCode);
+            return manager;
+        }
+
+        void run(Module& module) {
+            if (verify) {
+                check(module, "the builder");
+            }
+
+            for (const Pass& pass : passes) {
+                size_t before = module.size();
+                auto start = std::chrono::steady_clock::now();
+
+                for (const auto& function : module.functions) {
+                    pass.run(*function);
+                }
+
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                timings.push_back(Timing{pass.name, milliseconds, before, module.size()});
+
+                if (verify) {
+                    check(module, pass.name);
+                }
+            }
+        }
+
+        /* one line per pass run: name, time, instructions before -> after */
+        void report(std::ostream& out) const {
+            for (const Timing& timing : timings) {
+                out << "pass " << timing.name << ": " << timing.milliseconds << " ms, " << timing.before << " -> "
+                    << timing.after << " instructions" << std::endl;
+            }
+        }
+
+    private:
+        std::vector<Pass> passes;
+
+        static void check(const Module& module, const std::string& after) {
+            for (const auto& function : module.functions) {
+                std::string error = IR::verify(*function);
+                if (!error.empty()) {
+                    throw std::logic_error("Invalid IR after " + after + " in " + std::string(function->name) + ": " + error);
+                }
+            }
+        }
+    };
+}
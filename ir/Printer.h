@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "../parser/OutputSink.h"
+#include "IR.h"
+
+namespace IR {
+    /**
+     * Prints a module as text, one function after the other, values numbered in the order they are printed:
+     *
+     *     function gcd(a, b): integer
+     *     b1: <- b0, b3
+     *         v2: integer = phi v0 b0, v7 b3         ; a
+     *         v4: boolean = ne v2, v3
+     *         branch v4, b2, b4
+     */
+    class Printer {
+    public:
+        Printer(const Module* module, OutputSink* out) : module{module}, out{*out} {}
+
+        void print() {
+            for (const auto& function : module->functions) {
+                print(*function);
+            }
+        }
+
+        void print(const Function& function) {
+            numbers.clear();
+            for (const auto& block : function.blocks) {
+                for (const Instruction* instruction : block->instructions) {
+                    if (instruction->value) {
+                        numbers.emplace(instruction, numbers.size());
+                    }
+                }
+            }
+
+            if (function.main) {
+                out << "program " << function.name << "\n";
+            } else {
+                out << "function " << function.name << "(";
+                for (size_t i = 0; i < function.argumentCount; i++) {
+                    out << (i > 0 ? ", " : "") << function.slotNames[i];
+                }
+                out << ")";
+                if (function.function) {
+                    out << ": " << typeName(function.resultType);
+                }
+                out << "\n";
+            }
+
+            for (const auto& block : function.blocks) {
+                std::string header = "b" + std::to_string(block->id) + ":";
+                for (size_t i = 0; i < block->predecessors.size(); i++) {
+                    header += (i == 0 ? " <- b" : ", b") + std::to_string(block->predecessors[i]->id);
+                }
+                out << header << "\n";
+
+                for (const Instruction* instruction : block->instructions) {
+                    line(function, instruction);
+                }
+            }
+            out << "\n";
+        }
+
+    private:
+        const Module* module;
+        OutputSink& out;
+        std::unordered_map<const Instruction*, size_t> numbers;
+
+        void line(const Function& function, const Instruction* instruction) {
+            std::string text = "    ";
+            if (instruction->value) {
+                text += value(instruction) + ": " + typeName(instruction->type) + " = ";
+            }
+
+            std::string name = OPCODE_NAMES[instruction->op];
+            for (char& c : name) c = tolower(c);
+            text += name;
+
+            switch (instruction->op) {
+                case CONST:   text += " " + constant(instruction); break;
+                case PARAM:   text += " " + std::to_string(instruction->immediate); break;
+                case ARRAY:   text += " " + variable(function, instruction->immediate, instruction->global); break;
+                case LOADG:   text += " " + variable(function, instruction->immediate, true); break;
+                case STOREG:  text += " " + variable(function, instruction->immediate, true) + ", " + value(instruction->operands[0]); break;
+                case WRITES:  text += " '" + std::string(module->strings[instruction->immediate]) + "'"; break;
+                case CALL:    text += " " + std::string(module->functions[instruction->immediate]->name) + "(" + operands(instruction) + ")"; break;
+                case PHI:
+                    for (size_t i = 0; i < instruction->operands.size(); i++) {
+                        text += (i == 0 ? " " : ", ") + value(instruction->operands[i]) + " b" + std::to_string(instruction->block->predecessors[i]->id);
+                    }
+                    break;
+                default:
+                    if (!instruction->operands.empty()) {
+                        text += " " + operands(instruction);
+                    }
+                    for (size_t i = 0; i < instruction->targets.size(); i++) {
+                        text += (i == 0 && instruction->operands.empty() ? " b" : ", b") + std::to_string(instruction->targets[i]->id);
+                    }
+            }
+
+            if (instruction->variable != UINT32_MAX) {
+                pad(text, 47);
+                text += " ; " + std::string(function.slotNames[instruction->variable]);
+            }
+            out << text << '\n';
+        }
+
+        std::string value(const Instruction* instruction) {
+            auto number = numbers.find(instruction);
+            return number != numbers.end() ? "v" + std::to_string(number->second) : "v?";
+        }
+
+        std::string operands(const Instruction* instruction) {
+            std::string text;
+            for (size_t i = 0; i < instruction->operands.size(); i++) {
+                text += (i > 0 ? ", " : "") + value(instruction->operands[i]);
+            }
+            return text;
+        }
+
+        std::string constant(const Instruction* instruction) {
+            switch (instruction->type) {
+                case ValueType::REAL: {
+                    char digits[32];
+                    snprintf(digits, sizeof(digits), "%.17g", instruction->real);
+                    return digits;
+                }
+                case ValueType::BOOLEAN: return instruction->immediate ? "true" : "false";
+                default:                 return std::to_string(instruction->immediate);
+            }
+        }
+
+        std::string variable(const Function& function, int64_t slot, bool global) {
+            return std::string(global ? module->globalNames[slot] : function.slotNames[slot]);
+        }
+
+        static void pad(std::string& text, size_t width) {
+            if (text.size() < width) {
+                text.append(width - text.size(), ' ');
+            }
+        }
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "IR.h"
+#include "Dominators.h"
+
+namespace IR {
+    /**
+     * Checks the invariants every pass relies on: each block ends with its only terminator, phis come first
+     * and have one operand per predecessor, the predecessors match the jumps, and every operand is still in
+     * the function and defined where it dominates its use (for a phi operand: the end of its predecessor).
+     * Returns what is wrong, or an empty string.
+     */
+    inline std::string verify(const Function& function) {
+        Dominators dominators(function);
+        std::unordered_map<const Instruction*, size_t> positions; // of every instruction in its block
+
+        for (const auto& block : function.blocks) {
+            for (size_t i = 0; i < block->instructions.size(); i++) {
+                positions[block->instructions[i]] = i;
+            }
+        }
+
+        auto name = [](const Instruction* instruction) {
+            return std::string(OPCODE_NAMES[instruction->op]) + " in b" + std::to_string(instruction->block->id);
+        };
+
+        for (const auto& block : function.blocks) {
+            std::string where = "b" + std::to_string(block->id);
+            if (block->instructions.empty() || !block->terminator()->isTerminator()) {
+                return where + " does not end with a jump or return";
+            }
+
+            size_t edges = 0;
+            for (const auto& other : function.blocks) {
+                for (Block* successor : other->instructions.back()->targets) {
+                    edges += successor == block.get() && std::count(block->predecessors.begin(), block->predecessors.end(), other.get()) > 0;
+                }
+            }
+            if (edges != block->predecessors.size()) {
+                return where + " has predecessors that do not jump to it";
+            }
+
+            bool phis = true;
+            for (size_t i = 0; i < block->instructions.size(); i++) {
+                const Instruction* instruction = block->instructions[i];
+
+                if (instruction->block != block.get()) {
+                    return name(instruction) + " belongs to another block";
+                }
+                if (instruction->isTerminator() != (i + 1 == block->instructions.size())) {
+                    return name(instruction) + " is out of place";
+                }
+                if (instruction->op == PHI) {
+                    if (!phis) {
+                        return name(instruction) + " comes after other instructions";
+                    }
+                    if (instruction->operands.size() != block->predecessors.size()) {
+                        return name(instruction) + " does not have one operand per predecessor";
+                    }
+                } else {
+                    phis = false;
+                }
+
+                if (!dominators.reachable(block.get())) {
+                    continue;
+                }
+
+                for (size_t j = 0; j < instruction->operands.size(); j++) {
+                    const Instruction* operand = instruction->operands[j];
+                    auto position = positions.find(operand);
+
+                    if (position == positions.end()) {
+                        return name(instruction) + " uses an instruction that was removed";
+                    }
+                    if (!operand->value) {
+                        return name(instruction) + " uses an instruction without a value";
+                    }
+
+                    bool dominated = instruction->op == PHI
+                        ? dominators.dominates(operand->block, block->predecessors[j])
+                        : operand->block == block.get() ? position->second < i : dominators.dominates(operand->block, block.get());
+                    if (!dominated) {
+                        return name(instruction) + " uses " + name(operand) + ", which does not dominate it";
+                    }
+                }
+            }
+        }
+        return "";
+    }
+}
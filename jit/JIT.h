@@ -0,0 +1,426 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../bytecode/Bytecode.h"
+#include "X64Emitter.h"
+
+namespace JIT {
+    using namespace Bytecode;
+
+    /* mmap'd memory for generated code: filled while writable, then switched to read and execute only */
+    class ExecutableMemory {
+    public:
+        ExecutableMemory(const std::vector<uint8_t>& code) {
+            size_t page = sysconf(_SC_PAGESIZE);
+            size = (code.size() + page - 1) / page * page;
+
+            void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED) {
+                return;
+            }
+
+            memcpy(mapped, code.data(), code.size());
+            if (mprotect(mapped, size, PROT_READ | PROT_EXEC) != 0) {
+                munmap(mapped, size);
+                return;
+            }
+            memory = static_cast<uint8_t*>(mapped);
+        }
+
+        ~ExecutableMemory() {
+            if (memory != NULL) {
+                munmap(memory, size);
+            }
+        }
+
+        ExecutableMemory(const ExecutableMemory&) = delete;
+        ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+        /* NULL if the memory could not be mapped */
+        const uint8_t* address() const { return memory; }
+
+    private:
+        uint8_t* memory = NULL;
+        size_t size = 0;
+    };
+
+    /**
+     * Translates the functions of a bytecode module to x86-64 code. It takes functions that only do integer and
+     * boolean arithmetic, branches and calls among themselves (gcd, factorial, fib, ...); everything else (reals,
+     * arrays, globals, output) stays on the VM, which calls into the native code through Module::enter.
+     *
+     * The four most used registers of a function live in callee-saved machine registers (RBX, RBP, R12, R13),
+     * the others in the VM's register array, addressed through R14. R15 points to the NativeContext for the
+     * whole time native code runs. Calls work like in the VM: the caller stores the arguments where the callee's
+     * frame begins and passes that address in RDI, the result comes back in RAX. Runtime errors are stored in
+     * the context and every function returns right away once it is set.
+     *
+     * The code and the module belong together: the functions point into memory owned by the compiler.
+     */
+    class Compiler {
+    public:
+        static const size_t HOST_REGISTER_COUNT = 4;
+
+        Compiler(Module* module) : module{module} {}
+
+        Compiler(const Compiler&) = delete;
+        Compiler& operator=(const Compiler&) = delete;
+
+        /* compiles what it can, returns the number of native functions (none on other platforms than x86-64) */
+        size_t compile() {
+#if defined(__x86_64__)
+            size_t count = module->mainFunction();
+            std::vector<bool> native(count);
+            for (size_t i = 0; i < count; i++) {
+                native[i] = supported(module->functions[i]);
+            }
+
+            // native code can only call native code: drop callers of what stays on the VM until nothing changes
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (size_t i = 0; i < count; i++) {
+                    for (const Instruction& ins : module->functions[i].code) {
+                        if (native[i] && ins.op == CALL && !native[ins.d]) {
+                            native[i] = false;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            X64Emitter emitter;
+            size_t entry = trampoline(emitter);
+
+            std::vector<size_t> offsets(count);
+            calls.clear();
+            size_t compiled = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (native[i]) {
+                    offsets[i] = function(emitter, module->functions[i]);
+                    compiled++;
+                }
+            }
+            for (const auto& call : calls) {
+                emitter.patch(call.first, offsets[call.second]);
+            }
+
+            if (compiled == 0) {
+                return 0;
+            }
+
+            memory.reset(new ExecutableMemory(emitter.code));
+            const uint8_t* address = memory->address();
+            if (address == NULL) {
+                return 0;
+            }
+
+            module->enter = reinterpret_cast<NativeEntry>(const_cast<uint8_t*>(address + entry));
+            for (size_t i = 0; i < count; i++) {
+                if (native[i]) {
+                    module->functions[i].native = address + offsets[i];
+                }
+            }
+            return compiled;
+#else
+            return 0;
+#endif
+        }
+
+    private:
+        Module* module;
+        std::unique_ptr<ExecutableMemory> memory;
+
+        std::vector<std::pair<size_t, size_t>> calls;   // displacement of a call and the function it calls
+
+        // where each register of the function being compiled lives: a machine register or RSP (the VM's array)
+        std::vector<Register> registers;
+
+        static constexpr Register HOST_REGISTERS[HOST_REGISTER_COUNT] = {RBX, RBP, R12, R13};
+
+        static bool supported(const Function& function) {
+            if (!function.arrays.empty()) {
+                return false;
+            }
+
+            for (const Instruction& ins : function.code) {
+                switch (ins.op) {
+                    case MOVE: case LOADK:
+                    case ADDI: case SUBI: case MULI: case DIVI: case NEGI: case NOT:
+                    case EQI: case NEI: case LTI: case LEI: case GTI: case GEI:
+                    case JMP: case JMPF: case JMPT:
+                    case JEQI: case JNEI: case JLTI: case JLEI: case JGTI: case JGEI:
+                    case CALL: case RET:
+                        break;
+                    default:
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        /* int64_t enter(Slot* base, NativeContext* context, const void* code), saving what native code uses */
+        static size_t trampoline(X64Emitter& x) {
+            size_t start = x.size();
+            const Register saved[] = {RBX, RBP, R12, R13, R14, R15};
+
+            for (Register reg : saved) {
+                x.push(reg);
+            }
+            x.mov(Operand::of(R15), Operand::of(RSI));
+            x.callRegister(RDX);
+            for (size_t i = sizeof(saved) / sizeof(saved[0]); i-- > 0;) {
+                x.pop(saved[i]);
+            }
+            x.ret();
+
+            return start;
+        }
+
+        /* the most used registers get a machine register */
+        void allocate(const Function& function) {
+            std::vector<size_t> uses(function.registerCount);
+            for (const Instruction& ins : function.code) {
+                switch (OPCODE_FORMATS[ins.op]) {
+                    case ABC:   uses[ins.c]++; // fall through
+                    case AB:
+                    case ABJ:   uses[ins.b]++; // fall through
+                    case A:
+                    case AK:
+                    case AJ:
+                    case CALL_: uses[ins.a]++; break;
+                    default: break;
+                }
+            }
+
+            std::vector<uint16_t> order(function.registerCount);
+            for (size_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](uint16_t a, uint16_t b) { return uses[a] > uses[b]; });
+
+            registers.assign(function.registerCount, RSP);
+            for (size_t i = 0; i < order.size() && i < HOST_REGISTER_COUNT && uses[order[i]] > 0; i++) {
+                registers[order[i]] = HOST_REGISTERS[i];
+            }
+        }
+
+        bool inRegister(uint16_t reg) const { return registers[reg] != RSP; }
+
+        Operand location(uint16_t reg) const {
+            return inRegister(reg) ? Operand::of(registers[reg]) : Operand::at(R14, reg * sizeof(Slot));
+        }
+
+        static Operand context(size_t offset) { return Operand::at(R15, static_cast<int32_t>(offset)); }
+
+        /* a register holding the value of reg, RAX unless it lives in one */
+        Register load(X64Emitter& x, uint16_t reg) {
+            if (inRegister(reg)) {
+                return registers[reg];
+            }
+            x.mov(Operand::of(RAX), location(reg));
+            return RAX;
+        }
+
+        /* rA = rB <op> rC, computed in the register of rA if it has one (and rC is not overwritten by that) */
+        template <typename Operation>
+        void arithmetic(X64Emitter& x, const Instruction& ins, Operation operation) {
+            Register dest = inRegister(ins.a) && ins.a != ins.c ? registers[ins.a] : RAX;
+            if (ins.a != ins.b || dest == RAX) {
+                x.mov(Operand::of(dest), location(ins.b));
+            }
+            operation(dest, location(ins.c));
+            if (dest == RAX) {
+                x.mov(location(ins.a), Operand::of(RAX));
+            }
+        }
+
+        static Condition condition(Opcode op) {
+            switch (op) {
+                case EQI: case JEQI: return EQUAL;
+                case NEI: case JNEI: return NOT_EQUAL;
+                case LTI: case JLTI: return LESS;
+                case LEI: case JLEI: return LESS_EQUAL;
+                case GTI: case JGTI: return GREATER;
+                default:             return GREATER_EQUAL;
+            }
+        }
+
+        /* compiles a function, returns its offset */
+        size_t function(X64Emitter& x, const Function& function) {
+            allocate(function);
+
+            std::vector<Register> saved;
+            for (Register reg : HOST_REGISTERS) {
+                if (std::find(registers.begin(), registers.end(), reg) != registers.end()) {
+                    saved.push_back(reg);
+                }
+            }
+            saved.push_back(R14);
+
+            size_t start = x.size();
+            for (Register reg : saved) {
+                x.push(reg);
+            }
+            x.mov(Operand::of(R14), Operand::of(RDI));
+
+            // declarations and the result start at zero, the arguments come in through the VM's registers
+            for (uint32_t reg = function.argumentCount; reg < function.slotCount; reg++) {
+                x.mov(location(reg), 0);
+            }
+            for (uint32_t reg = 0; reg < function.argumentCount; reg++) {
+                if (inRegister(reg)) {
+                    x.mov(location(reg), Operand::at(R14, reg * sizeof(Slot)));
+                }
+            }
+
+            std::vector<size_t> labels(function.code.size());
+            std::vector<std::pair<size_t, size_t>> jumps;       // displacement and target instruction
+            std::vector<std::pair<size_t, int>> divisions;      // jump to the division by zero error, line
+            std::vector<std::pair<size_t, int>> overflows;      // jump to the stack overflow error, line
+            std::vector<size_t> exits;                          // jumps to the epilogue
+
+            for (size_t i = 0; i < function.code.size(); i++) {
+                const Instruction& ins = function.code[i];
+                labels[i] = x.size();
+
+                switch (ins.op) {
+                    case MOVE:
+                        if (ins.a != ins.b) {
+                            x.mov(location(ins.a), location(ins.b));
+                        }
+                        break;
+                    case LOADK:
+                        x.mov(location(ins.a), module->constants[ins.d].integer);
+                        break;
+
+                    case ADDI: arithmetic(x, ins, [&](Register r, Operand o) { x.add(r, o); }); break;
+                    case SUBI: arithmetic(x, ins, [&](Register r, Operand o) { x.sub(r, o); }); break;
+                    case MULI: arithmetic(x, ins, [&](Register r, Operand o) { x.imul(r, o); }); break;
+                    case DIVI: {
+                        x.mov(Operand::of(RAX), location(ins.b));
+                        x.mov(Operand::of(RCX), location(ins.c));
+                        x.test(RCX, RCX);
+                        divisions.emplace_back(x.jump(EQUAL), function.lines[i]);
+
+                        // idiv traps on the one quotient that overflows, the VM wraps it around
+                        x.cmp(Operand::of(RCX), -1);
+                        size_t divide = x.jump(NOT_EQUAL);
+                        x.neg(Operand::of(RAX));
+                        size_t done = x.jmp();
+                        x.patch(divide, x.size());
+                        x.cqo();
+                        x.idiv(Operand::of(RCX));
+                        x.patch(done, x.size());
+
+                        x.mov(location(ins.a), Operand::of(RAX));
+                    } break;
+                    case NEGI:
+                        x.mov(Operand::of(RAX), location(ins.b));
+                        x.neg(Operand::of(RAX));
+                        x.mov(location(ins.a), Operand::of(RAX));
+                        break;
+                    case NOT:
+                        x.mov(Operand::of(RAX), location(ins.b));
+                        x.xorImmediate(RAX, 1);
+                        x.mov(location(ins.a), Operand::of(RAX));
+                        break;
+
+                    case EQI: case NEI: case LTI: case LEI: case GTI: case GEI:
+                        x.cmp(load(x, ins.b), location(ins.c));
+                        x.set(condition(ins.op), RAX);
+                        x.mov(location(ins.a), Operand::of(RAX));
+                        break;
+
+                    case JMP:
+                        jumps.emplace_back(x.jmp(), ins.d);
+                        break;
+                    case JMPF:
+                    case JMPT:
+                        if (inRegister(ins.a)) {
+                            x.test(registers[ins.a], registers[ins.a]);
+                        } else {
+                            x.cmp(location(ins.a), 0);
+                        }
+                        jumps.emplace_back(x.jump(ins.op == JMPF ? EQUAL : NOT_EQUAL), ins.d);
+                        break;
+                    case JEQI: case JNEI: case JLTI: case JLEI: case JGTI: case JGEI:
+                        x.cmp(load(x, ins.a), location(ins.b));
+                        jumps.emplace_back(x.jump(condition(ins.op)), ins.d);
+                        break;
+
+                    case CALL: {
+                        const Function& callee = module->functions[ins.d];
+                        for (uint32_t k = 0; k < callee.argumentCount; k++) {
+                            if (inRegister(ins.b + k)) {
+                                x.mov(Operand::at(R14, (ins.b + k) * sizeof(Slot)), location(ins.b + k));
+                            }
+                        }
+
+                        // the same limits as in the VM
+                        x.mov(Operand::of(RAX), context(offsetof(NativeContext, depth)));
+                        x.cmp(RAX, context(offsetof(NativeContext, maxDepth)));
+                        overflows.emplace_back(x.jump(GREATER_EQUAL), function.lines[i]);
+                        x.lea(RAX, R14, (ins.b + callee.registerCount) * sizeof(Slot));
+                        x.cmp(RAX, context(offsetof(NativeContext, registersEnd)));
+                        overflows.emplace_back(x.jump(ABOVE), function.lines[i]);
+
+                        x.inc(context(offsetof(NativeContext, depth)));
+                        x.lea(RDI, R14, ins.b * sizeof(Slot));
+                        calls.emplace_back(x.call(), ins.d);
+                        x.dec(context(offsetof(NativeContext, depth)));
+
+                        x.cmp32(context(offsetof(NativeContext, error)), 0);
+                        exits.push_back(x.jump(NOT_EQUAL));
+                        x.mov(location(ins.a), Operand::of(RAX));
+                    } break;
+
+                    case RET:
+                        if (function.resultSlot != UNRESOLVED) {
+                            x.mov(Operand::of(RAX), location(function.resultSlot));
+                        } else {
+                            x.mov(Operand::of(RAX), 0);
+                        }
+                        exits.push_back(x.jmp());
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+
+            // runtime errors: record the first one and return
+            auto error = [&](const std::vector<std::pair<size_t, int>>& sites, NativeContext::Error kind) {
+                for (const auto& site : sites) {
+                    x.patch(site.first, x.size());
+                    x.mov32(context(offsetof(NativeContext, error)), kind);
+                    x.mov32(context(offsetof(NativeContext, line)), site.second);
+                    exits.push_back(x.jmp());
+                }
+            };
+            error(divisions, NativeContext::DIVISION_BY_ZERO);
+            error(overflows, NativeContext::STACK_OVERFLOW);
+
+            for (size_t exit : exits) {
+                x.patch(exit, x.size());
+            }
+            for (size_t i = saved.size(); i-- > 0;) {
+                x.pop(saved[i]);
+            }
+            x.ret();
+
+            for (const auto& jump : jumps) {
+                x.patch(jump.first, labels[jump.second]);
+            }
+            return start;
+        }
+    };
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+namespace JIT {
+    enum Register : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+    /* condition codes, the low nibble of Jcc/SETcc */
+    enum Condition : uint8_t { ABOVE = 0x7, EQUAL = 0x4, NOT_EQUAL = 0x5, LESS = 0xC, GREATER_EQUAL = 0xD, LESS_EQUAL = 0xE, GREATER = 0xF };
+
+    /* a 64 bit operand: a register, or the qword at base + displacement */
+    struct Operand {
+        bool memory;
+        Register reg;
+        int32_t displacement;
+
+        static Operand of(Register reg) { return Operand{false, reg, 0}; }
+        static Operand at(Register base, int32_t displacement) { return Operand{true, base, displacement}; }
+    };
+
+    /**
+     * Appends x86-64 machine code to a byte vector, only the handful of instructions the JIT needs. Memory
+     * operands are always [base + displacement] with a base other than RSP/R12 (which would need a SIB byte).
+     * Jumps are emitted with 32 bit displacements and patched once their target is known.
+     */
+    class X64Emitter {
+    public:
+        std::vector<uint8_t> code;
+
+        size_t size() const { return code.size(); }
+
+        /* ---- moves ---- */
+
+        void mov(Operand to, Operand from) {
+            if (to.memory && from.memory) {
+                mov(Operand::of(RAX), from);
+                from = Operand::of(RAX);
+            }
+            if (to.memory || !from.memory) {
+                instruction(0x89, from.reg, to);     // mov r/m64, r64
+            } else {
+                instruction(0x8B, to.reg, from);     // mov r64, r/m64
+            }
+        }
+
+        void mov(Operand to, int64_t value) {
+            if (!to.memory) {
+                if (value == 0) {
+                    instruction(0x33, to.reg, to);   // xor r64, r64
+                } else if (value == static_cast<int32_t>(value)) {
+                    instruction(0xC7, 0, to);        // mov r/m64, imm32 (sign extended)
+                    imm32(value);
+                } else {
+                    rex(true, 0, to.reg);
+                    byte(0xB8 + (to.reg & 7));       // mov r64, imm64
+                    imm64(value);
+                }
+                return;
+            }
+
+            if (value == static_cast<int32_t>(value)) {
+                instruction(0xC7, 0, to);
+                imm32(value);
+            } else {
+                mov(Operand::of(RAX), value);
+                mov(to, Operand::of(RAX));
+            }
+        }
+
+        /* lea reg, [base + displacement] */
+        void lea(Register reg, Register base, int32_t displacement) {
+            instruction(0x8D, reg, Operand::at(base, displacement));
+        }
+
+        /* ---- arithmetic, reg = reg <op> r/m64 ---- */
+
+        void add(Register reg, Operand from)  { instruction(0x03, reg, from); }
+        void sub(Register reg, Operand from)  { instruction(0x2B, reg, from); }
+        void imul(Register reg, Operand from) { instruction2(0x0F, 0xAF, reg, from); }
+        void cmp(Register reg, Operand with)  { instruction(0x3B, reg, with); }
+        void test(Register a, Register b)     { instruction(0x85, b, Operand::of(a)); }
+
+        void cmp(Operand operand, int8_t value) { instruction(0x83, 7, operand); byte(value); }
+        void xorImmediate(Register reg, int8_t value) { instruction(0x83, 6, Operand::of(reg)); byte(value); }
+
+        void neg(Operand operand)  { instruction(0xF7, 3, operand); }
+        void idiv(Operand divisor) { instruction(0xF7, 7, divisor); }
+        void cqo()                 { byte(0x48); byte(0x99); }
+
+        void inc(Operand operand)  { instruction(0xFF, 0, operand); }
+        void dec(Operand operand)  { instruction(0xFF, 1, operand); }
+
+        /* mov dword [base + displacement], imm32 */
+        void mov32(Operand to, int32_t value) {
+            rex(false, 0, to.reg);
+            byte(0xC7);
+            modrm(0, to);
+            imm32(value);
+        }
+
+        /* cmp dword [base + displacement], imm8 */
+        void cmp32(Operand operand, int8_t value) {
+            rex(false, 0, operand.reg);
+            byte(0x83);
+            modrm(7, operand);
+            byte(value);
+        }
+
+        /* reg = condition ? 1 : 0 */
+        void set(Condition condition, Register reg) {
+            rex(false, 0, reg, true);
+            byte(0x0F); byte(0x90 + condition); byte(0xC0 + (reg & 7));     // setcc r8
+            rex(false, reg, reg, true);
+            byte(0x0F); byte(0xB6); byte(0xC0 + ((reg & 7) << 3) + (reg & 7));  // movzx r32, r8
+        }
+
+        /* ---- control flow, returning the position of the displacement for patch() ---- */
+
+        size_t jmp()                    { byte(0xE9); return displacement(); }
+        size_t jump(Condition condition) { byte(0x0F); byte(0x80 + condition); return displacement(); }
+        size_t call()                   { byte(0xE8); return displacement(); }
+
+        /* points the displacement at position to the given target offset */
+        void patch(size_t position, size_t target) {
+            int32_t relative = static_cast<int32_t>(target - (position + 4));
+            memcpy(&code[position], &relative, 4);
+        }
+
+        void callRegister(Register reg) {
+            rex(false, 0, reg);
+            byte(0xFF); byte(0xD0 + (reg & 7));
+        }
+
+        void push(Register reg) { rex(false, 0, reg); byte(0x50 + (reg & 7)); }
+        void pop(Register reg)  { rex(false, 0, reg); byte(0x58 + (reg & 7)); }
+        void ret()              { byte(0xC3); }
+
+    private:
+        void byte(uint8_t value) { code.push_back(value); }
+
+        void imm32(int64_t value) {
+            int32_t v = static_cast<int32_t>(value);
+            code.insert(code.end(), reinterpret_cast<uint8_t*>(&v), reinterpret_cast<uint8_t*>(&v) + 4);
+        }
+
+        void imm64(int64_t value) {
+            code.insert(code.end(), reinterpret_cast<uint8_t*>(&value), reinterpret_cast<uint8_t*>(&value) + 8);
+        }
+
+        size_t displacement() {
+            size_t position = code.size();
+            imm32(0);
+            return position;
+        }
+
+        /* the REX prefix, left out when nothing needs it; byteRegisters forces it so that SIL/DIL are addressable */
+        void rex(bool wide, uint8_t reg, uint8_t rm, bool byteRegisters = false) {
+            uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+            if (prefix != 0x40 || (byteRegisters && (rm >= 4 || reg >= 4))) {
+                byte(prefix);
+            }
+        }
+
+        void modrm(uint8_t reg, Operand operand) {
+            if (!operand.memory) {
+                byte(0xC0 | ((reg & 7) << 3) | (operand.reg & 7));
+            } else if (operand.displacement == static_cast<int8_t>(operand.displacement)) {
+                byte(0x40 | ((reg & 7) << 3) | (operand.reg & 7));
+                byte(static_cast<uint8_t>(operand.displacement));
+            } else {
+                byte(0x80 | ((reg & 7) << 3) | (operand.reg & 7));
+                imm32(operand.displacement);
+            }
+        }
+
+        /* a 64 bit instruction with a ModRM byte, reg being a register or an opcode extension */
+        void instruction(uint8_t opcode, uint8_t reg, Operand operand) {
+            rex(true, reg, operand.reg);
+            byte(opcode);
+            modrm(reg, operand);
+        }
+
+        void instruction2(uint8_t escape, uint8_t opcode, uint8_t reg, Operand operand) {
+            rex(true, reg, operand.reg);
+            byte(escape);
+            byte(opcode);
+            modrm(reg, operand);
+        }
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "Lexer.h"
+#include "lex.yy.c"
+
+/**
+ * Lexer using the (reentrant) scanner generated from pascal.l.
+ */
+class FlexScanner : public Lexer {
+public:
+    /* reads the input through flex's own buffering */
+    FlexScanner(FILE* input) {
+        yylex_init_extra(0, &scanner);
+        yyset_in(input, scanner);
+    }
+
+    /* scans the buffer in place, it has to be followed by two zero bytes */
+    FlexScanner(char* buffer, size_t size) {
+        yylex_init_extra(0, &scanner);
+        yy_scan_buffer(buffer, size + 2, scanner);
+        yyset_lineno(1, scanner); // not initialized by yy_scan_buffer
+    }
+
+    ~FlexScanner() {
+        yylex_destroy(scanner);
+    }
+
+    FlexScanner(const FlexScanner&) = delete;
+    FlexScanner& operator=(const FlexScanner&) = delete;
+
+    TokenType next() {
+        TokenType type = static_cast<TokenType>(yylex(scanner));
+
+        text = yyget_text(scanner);
+        length = yyget_leng(scanner);
+        offset = yyget_extra(scanner) - length; // yyextra is the offset behind the last match
+        lineNumber = yyget_lineno(scanner);
+
+        return type;
+    }
+
+private:
+    yyscan_t scanner;
+};
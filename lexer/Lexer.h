@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../common/token-enum.h"
+
+/**
+ * Source of tokens for the parser. After next() the public fields describe the token that was just scanned.
+ */
+class Lexer {
+public:
+    virtual ~Lexer() = default;
+
+    /* scans the next token, returns 0 at the end of the input */
+    virtual TokenType next() = 0;
+
+    const char* text = NULL; // text of the last token, for streams only valid until the next call
+    unsigned int length = 0;
+    unsigned int offset = 0; // byte offset of the last token in the input
+    int lineNumber = 1;      // line the last token ends on
+};
+
+/* lexer implementations to choose from at runtime */
+enum class LexerKind {
+    FLEX,
+    SIMD
+};
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <array>
+#include <iostream>
+#include <string_view>
+
+#include "Lexer.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* the few vector operations the lexer needs, on 32 (AVX2), 16 (SSE2) or 1 (no SIMD) bytes at once */
+namespace simd {
+#if defined(__AVX2__)
+    typedef __m256i Vector;
+    const unsigned int WIDTH = 32;
+
+    inline Vector load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    inline Vector equal(Vector v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); }
+    inline Vector greater(Vector v, char c) { return _mm256_cmpgt_epi8(v, _mm256_set1_epi8(c)); }
+    inline Vector less(Vector v, char c) { return _mm256_cmpgt_epi8(_mm256_set1_epi8(c), v); }
+    inline Vector both(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+    inline Vector either(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+    inline Vector setBits(Vector v, char bits) { return _mm256_or_si256(v, _mm256_set1_epi8(bits)); }
+    inline uint32_t mask(Vector v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+#elif defined(__SSE2__)
+    typedef __m128i Vector;
+    const unsigned int WIDTH = 16;
+
+    inline Vector load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline Vector equal(Vector v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+    inline Vector greater(Vector v, char c) { return _mm_cmpgt_epi8(v, _mm_set1_epi8(c)); }
+    inline Vector less(Vector v, char c) { return _mm_cmplt_epi8(v, _mm_set1_epi8(c)); }
+    inline Vector both(Vector a, Vector b) { return _mm_and_si128(a, b); }
+    inline Vector either(Vector a, Vector b) { return _mm_or_si128(a, b); }
+    inline Vector setBits(Vector v, char bits) { return _mm_or_si128(v, _mm_set1_epi8(bits)); }
+    inline uint32_t mask(Vector v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+#else
+    typedef signed char Vector; // all ones for "true", like the vector compares
+    const unsigned int WIDTH = 1;
+
+    inline Vector load(const char* p) { return *p; }
+    inline Vector equal(Vector v, char c) { return v == c ? -1 : 0; }
+    inline Vector greater(Vector v, char c) { return v > c ? -1 : 0; }
+    inline Vector less(Vector v, char c) { return v < c ? -1 : 0; }
+    inline Vector both(Vector a, Vector b) { return a & b; }
+    inline Vector either(Vector a, Vector b) { return a | b; }
+    inline Vector setBits(Vector v, char bits) { return v | bits; }
+    inline uint32_t mask(Vector v) { return v & 1; }
+#endif
+
+    const uint32_t ALL = WIDTH == 32 ? 0xFFFFFFFFu : (1u << WIDTH) - 1;
+
+    /* bytes within [low, high], compares are signed, so bytes >= 0x80 never match a range of ASCII characters */
+    inline Vector inRange(Vector v, char low, char high) { return both(greater(v, low - 1), less(v, high + 1)); }
+
+    /* mask of the first n bits */
+    inline uint32_t firstBits(unsigned int n) { return n >= 32 ? 0xFFFFFFFFu : (1u << n) - 1; }
+}
+
+
+/* keywords are recognized with a perfect hash over their first and last character and their length */
+namespace keywords {
+    struct Keyword {
+        const char* text;
+        size_t length;
+        TokenType type;
+    };
+
+    const size_t TABLE_SIZE = 32;
+
+    /* collision free for the keywords below */
+    constexpr size_t hash(const char* text, size_t length) {
+        return (static_cast<unsigned char>(text[0]) * 3 + static_cast<unsigned char>(text[length - 1]) + length * 2) % TABLE_SIZE;
+    }
+
+    constexpr std::array<Keyword, TABLE_SIZE> buildTable() {
+        const Keyword keywords[] = {
+            {"program", 7, TokenType::PROGRAM}, {"function", 8, TokenType::FUNCTION}, {"procedure", 9, TokenType::PROCEDURE},
+            {"begin", 5, TokenType::BEGIN_}, {"end", 3, TokenType::END_},
+            {"while", 5, TokenType::WHILE}, {"do", 2, TokenType::DO},
+            {"if", 2, TokenType::IF}, {"then", 4, TokenType::THEN}, {"else", 4, TokenType::ELSE},
+            {"var", 3, TokenType::VAR}, {"of", 2, TokenType::OF},
+            {"integer", 7, TokenType::INTEGER}, {"real", 4, TokenType::REAL}, {"boolean", 7, TokenType::BOOLEAN}, {"array", 5, TokenType::ARRAY},
+            {"not", 3, TokenType::OP_NOT}, {"div", 3, TokenType::OP_INTEGER_DIV}, {"and", 3, TokenType::OP_AND}, {"or", 2, TokenType::OP_OR},
+            {"true", 4, TokenType::LITERAL_TRUE}, {"false", 5, TokenType::LITERAL_FALSE},
+        };
+
+        std::array<Keyword, TABLE_SIZE> table = {};
+        for (const auto& keyword : keywords) {
+            size_t index = hash(keyword.text, keyword.length);
+            if (table[index].text != NULL) {
+                throw "keyword hash collision"; // fails the compilation
+            }
+            table[index] = keyword;
+        }
+
+        return table;
+    }
+
+    constexpr std::array<Keyword, TABLE_SIZE> TABLE = buildTable();
+
+    /* keyword type of the word or IDENTIFIER */
+    inline TokenType lookup(const char* text, size_t length) {
+        const Keyword& candidate = TABLE[hash(text, length)];
+
+        if (candidate.length == length && memcmp(candidate.text, text, length) == 0) {
+            return candidate.type;
+        }
+        return TokenType::IDENTIFIER;
+    }
+}
+
+
+/**
+ * Hand-written lexer producing the same tokens (types, texts, offsets, line numbers and error messages) as the
+ * flex scanner from pascal.l. Runs of whitespace, identifier characters and digits as well as the ends of
+ * comments and strings are found a whole vector at a time.
+ *
+ * Works in place on a buffer that has to be followed by at least PADDING zero bytes, since vectors are loaded
+ * without checking the end of the input (zeros end every run).
+ */
+class SimdLexer : public Lexer {
+public:
+    static const size_t PADDING = 64;
+
+    SimdLexer(const char* buffer, size_t size) : start{buffer}, position{buffer}, end{buffer + size} {}
+
+    TokenType next() {
+        while (true) {
+            position = skipWhitespace(position);
+
+            const char* tokenStart = position;
+            if (tokenStart >= end) {
+                return finish(tokenStart, 0, static_cast<TokenType>(0));
+            }
+
+            char c = *tokenStart;
+
+            // identifiers and keywords
+            if (isLetter(c)) {
+                const char* stop = skipIdentifier(tokenStart + 1);
+                return finish(tokenStart, stop - tokenStart, keywords::lookup(tokenStart, stop - tokenStart));
+            }
+
+            // numbers (or identifiers wrongly starting with a digit)
+            if (c >= '0' && c <= '9') {
+                TokenType type;
+                size_t numberLength = scanNumber(tokenStart, type);
+                size_t identifierLength = skipIdentifier(tokenStart + 1) - tokenStart;
+
+                // the longest match wins like in flex, numbers win ties as their rules come first
+                if (identifierLength > numberLength) {
+                    position = tokenStart + identifierLength;
+                    std::cerr << "ERROR: not allowed identifier  \"" << std::string_view(tokenStart, identifierLength) << "\" on line "
+                              << lineNumber << " (identifiers starting with digits are not allowed)" << std::endl;
+                    continue;
+                }
+
+                return finish(tokenStart, numberLength, type);
+            }
+
+            switch (c) {
+                // comments, if they are closed
+                case '{': {
+                    const char* closing = find(tokenStart + 1, '}');
+                    if (closing != NULL) {
+                        position = closing + 1;
+                        continue;
+                    }
+                } break;
+
+                // strings, if they are closed
+                case '\'': {
+                    const char* closing = find(tokenStart + 1, '\'');
+                    if (closing != NULL) {
+                        return finish(tokenStart, closing + 1 - tokenStart, TokenType::LITERAL_STRING);
+                    }
+                } break;
+
+                case ',': return finish(tokenStart, 1, TokenType::COMMA);
+                case ';': return finish(tokenStart, 1, TokenType::SEMICOLON);
+                case '(': return finish(tokenStart, 1, TokenType::BRACKETS_OPEN);
+                case ')': return finish(tokenStart, 1, TokenType::BRACKETS_CLOSING);
+                case '[': return finish(tokenStart, 1, TokenType::SQUARE_OPEN);
+                case ']': return finish(tokenStart, 1, TokenType::SQUARE_CLOSING);
+                case '=': return finish(tokenStart, 1, TokenType::OP_EQUALS);
+                case '+': return finish(tokenStart, 1, TokenType::OP_ADD);
+                case '-': return finish(tokenStart, 1, TokenType::OP_SUB);
+                case '*': return finish(tokenStart, 1, TokenType::OP_MUL);
+                case '/': return finish(tokenStart, 1, TokenType::OP_DIV);
+
+                case ':': return tokenStart[1] == '=' ? finish(tokenStart, 2, TokenType::OP_ASSIGNMENT) : finish(tokenStart, 1, TokenType::COLON);
+                case '.': return tokenStart[1] == '.' ? finish(tokenStart, 2, TokenType::RANGE_DOTS) : finish(tokenStart, 1, TokenType::DOT);
+                case '>': return tokenStart[1] == '=' ? finish(tokenStart, 2, TokenType::OP_GREATER_EQUAL) : finish(tokenStart, 1, TokenType::OP_GREATER);
+                case '<':
+                    if (tokenStart[1] == '>') return finish(tokenStart, 2, TokenType::OP_NOT_EQUALS);
+                    if (tokenStart[1] == '=') return finish(tokenStart, 2, TokenType::OP_LESS_EQUAL);
+                    return finish(tokenStart, 1, TokenType::OP_LESS);
+            }
+
+            // everything else that was not recognized yet, must be erroneous
+            position = tokenStart + 1;
+            std::cerr << "ERROR: reading symbol \"" << std::string(tokenStart, 1).c_str() << "\" on line " << lineNumber << std::endl; // a zero byte prints as "" like in flex
+        }
+    }
+
+private:
+    const char* start;
+    const char* position; // next character to scan
+    const char* end;
+
+    TokenType finish(const char* tokenStart, size_t tokenLength, TokenType type) {
+        text = tokenStart;
+        length = tokenLength;
+        offset = tokenStart - start;
+        position = tokenStart + tokenLength;
+
+        return type;
+    }
+
+    static bool isLetter(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    /* --------------- Character runs ----------------- */
+    const char* skipWhitespace(const char* p) {
+        while (true) {
+            simd::Vector v = simd::load(p);
+            simd::Vector newlines = simd::equal(v, '\n');
+            uint32_t whitespace = simd::mask(simd::either(newlines, simd::either(simd::equal(v, ' '), simd::equal(v, '\t'))));
+
+            if (whitespace == simd::ALL) {
+                lineNumber += __builtin_popcount(simd::mask(newlines));
+                p += simd::WIDTH;
+                continue;
+            }
+
+            unsigned int run = __builtin_ctz(~whitespace);
+            lineNumber += __builtin_popcount(simd::mask(newlines) & simd::firstBits(run));
+            return p + run;
+        }
+    }
+
+    /* skips [a-zA-Z0-9_]* */
+    static const char* skipIdentifier(const char* p) {
+        while (true) {
+            simd::Vector v = simd::load(p);
+            simd::Vector letters = simd::inRange(simd::setBits(v, 0x20), 'a', 'z'); // lower and upper case at once
+            simd::Vector digits = simd::inRange(v, '0', '9');
+            uint32_t identifier = simd::mask(simd::either(simd::either(letters, digits), simd::equal(v, '_')));
+
+            if (identifier != simd::ALL) {
+                return p + __builtin_ctz(~identifier);
+            }
+            p += simd::WIDTH;
+        }
+    }
+
+    static const char* skipDigits(const char* p) {
+        while (true) {
+            uint32_t digits = simd::mask(simd::inRange(simd::load(p), '0', '9'));
+
+            if (digits != simd::ALL) {
+                return p + __builtin_ctz(~digits);
+            }
+            p += simd::WIDTH;
+        }
+    }
+
+    /* finds the next c before the end of the input (counting the lines up to it), NULL if there is none */
+    const char* find(const char* p, char c) {
+        int lines = 0;
+
+        while (p < end) {
+            simd::Vector v = simd::load(p);
+            uint32_t found = simd::mask(simd::equal(v, c));
+            uint32_t newlines = simd::mask(simd::equal(v, '\n'));
+
+            if (found != 0) {
+                unsigned int index = __builtin_ctz(found);
+                if (p + index >= end) {
+                    break;
+                }
+
+                lineNumber += lines + __builtin_popcount(newlines & simd::firstBits(index));
+                return p + index;
+            }
+
+            lines += __builtin_popcount(newlines);
+            p += simd::WIDTH;
+        }
+
+        return NULL;
+    }
+
+    /* length of the integer or real literal starting at p */
+    static size_t scanNumber(const char* p, TokenType& type) {
+        const char* stop = skipDigits(p);
+        type = TokenType::LITERAL_INTEGER;
+
+        if (stop[0] == '.' && stop[1] >= '0' && stop[1] <= '9') {
+            stop = skipDigits(stop + 1);
+            type = TokenType::LITERAL_REAL;
+        }
+
+        return stop - p;
+    }
+};
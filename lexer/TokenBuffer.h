@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Lexer.h"
+
+/**
+ * Complete token stream of an input as a structure of arrays, so the parser can walk it by index instead of
+ * calling the lexer for every token. Texts are kept as offsets into the source: a buffer stays valid for every
+ * copy or mapping of the same source and can be cached and parsed any number of times. The last entry is
+ * always the end of the input (type 0).
+ */
+class TokenBuffer {
+public:
+    /* scans the whole input of the lexer */
+    TokenBuffer(Lexer& lexer) {
+        TokenType type;
+
+        do {
+            type = lexer.next();
+
+            types.push_back(type);
+            offsets.push_back(lexer.offset);
+            lengths.push_back(lexer.length);
+            lines.push_back(lexer.lineNumber);
+        } while (type != 0);
+    }
+
+    size_t size() const { return types.size(); }
+
+    std::vector<uint8_t> types;    // TokenType of every token
+    std::vector<uint32_t> offsets; // byte offset of every token in the source
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> lines;   // line every token ends on
+};
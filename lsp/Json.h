@@ -0,0 +1,332 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* just enough JSON for the language server protocol: a parsed tree for the messages that come in, a writer for the ones going out */
+namespace LSP::Json {
+    class ParseError : public std::runtime_error {
+    public:
+        ParseError(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    class Value {
+    public:
+        enum class Type : uint8_t { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = Type::NUL;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<Value> array;
+        std::vector<std::pair<std::string, Value>> object; // in the order of the text, messages have few members
+
+        /* the member with the given key, null if there is none (or this is no object) */
+        const Value& operator[](std::string_view key) const {
+            for (const auto& member : object) {
+                if (member.first == key) {
+                    return member.second;
+                }
+            }
+            return null();
+        }
+
+        bool isNull() const { return type == Type::NUL; }
+        int64_t integer() const { return static_cast<int64_t>(number); }
+
+        static const Value& null() {
+            static const Value value;
+            return value;
+        }
+    };
+
+    /* recursive descent over the text, throws a ParseError at the first mistake */
+    class Parser {
+    public:
+        static Value parse(std::string_view text) {
+            Parser parser(text);
+            Value value = parser.value();
+            parser.skipWhitespace();
+            if (parser.position != text.size()) {
+                parser.fail("end of input");
+            }
+            return value;
+        }
+
+    private:
+        std::string_view text;
+        size_t position = 0;
+
+        Parser(std::string_view text) : text{text} {}
+
+        [[noreturn]] void fail(const char* expected) {
+            throw ParseError(std::string("Expected ") + expected + " at offset " + std::to_string(position));
+        }
+
+        void skipWhitespace() {
+            while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+                position++;
+            }
+        }
+
+        bool consume(std::string_view word) {
+            if (text.substr(position, word.size()) == word) {
+                position += word.size();
+                return true;
+            }
+            return false;
+        }
+
+        Value value() {
+            skipWhitespace();
+            if (position == text.size()) {
+                fail("a value");
+            }
+
+            Value result;
+            char c = text[position];
+            if (c == '{') {
+                result.type = Value::Type::OBJECT;
+                position++;
+                skipWhitespace();
+                if (consume("}")) {
+                    return result;
+                }
+                do {
+                    skipWhitespace();
+                    if (position == text.size() || text[position] != '"') {
+                        fail("a member name");
+                    }
+                    std::string key = string();
+                    skipWhitespace();
+                    if (!consume(":")) {
+                        fail("':'");
+                    }
+                    result.object.emplace_back(std::move(key), value());
+                    skipWhitespace();
+                } while (consume(","));
+                if (!consume("}")) {
+                    fail("'}'");
+                }
+            } else if (c == '[') {
+                result.type = Value::Type::ARRAY;
+                position++;
+                skipWhitespace();
+                if (consume("]")) {
+                    return result;
+                }
+                do {
+                    result.array.push_back(value());
+                    skipWhitespace();
+                } while (consume(","));
+                if (!consume("]")) {
+                    fail("']'");
+                }
+            } else if (c == '"') {
+                result.type = Value::Type::STRING;
+                result.string = string();
+            } else if (consume("true")) {
+                result.type = Value::Type::BOOLEAN;
+                result.boolean = true;
+            } else if (consume("false")) {
+                result.type = Value::Type::BOOLEAN;
+            } else if (consume("null")) {
+                result.type = Value::Type::NUL;
+            } else {
+                // strtod needs a terminated string, numbers are short
+                size_t length = 0;
+                while (position + length < text.size() && length < 32 && strchr("+-0123456789.eE", text[position + length]) != NULL) {
+                    length++;
+                }
+                std::string digits(text.substr(position, length));
+                char* end;
+                result.number = strtod(digits.c_str(), &end);
+                if (length == 0 || end != digits.c_str() + length) {
+                    fail("a value");
+                }
+                result.type = Value::Type::NUMBER;
+                position += length;
+            }
+            return result;
+        }
+
+        /* a string literal, position is on its opening quote */
+        std::string string() {
+            std::string result;
+            position++;
+            while (position < text.size() && text[position] != '"') {
+                char c = text[position++];
+                if (c != '\\') {
+                    result += c;
+                    continue;
+                }
+                if (position == text.size()) {
+                    break;
+                }
+
+                char escaped = text[position++];
+                switch (escaped) {
+                    case 'n': result += '\n'; break;
+                    case 't': result += '\t'; break;
+                    case 'r': result += '\r'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'u': unicode(result); break;
+                    default:  result += escaped; break; // " \ /
+                }
+            }
+            if (!consume("\"")) {
+                fail("'\"'");
+            }
+            return result;
+        }
+
+        /* \uXXXX (and its low surrogate), appended as UTF-8 */
+        void unicode(std::string& result) {
+            uint32_t code = hex4();
+            if (code >= 0xD800 && code < 0xDC00 && consume("\\u")) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (hex4() - 0xDC00);
+            }
+
+            if (code < 0x80) {
+                result += static_cast<char>(code);
+            } else if (code < 0x800) {
+                result += static_cast<char>(0xC0 | (code >> 6));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                result += static_cast<char>(0xE0 | (code >> 12));
+                result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                result += static_cast<char>(0xF0 | (code >> 18));
+                result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        uint32_t hex4() {
+            if (position + 4 > text.size()) {
+                fail("four hex digits");
+            }
+            uint32_t code = 0;
+            for (int i = 0; i < 4; i++) {
+                char c = text[position++];
+                code <<= 4;
+                if (c >= '0' && c <= '9') code |= c - '0';
+                else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+                else fail("a hex digit");
+            }
+            return code;
+        }
+    };
+
+    /**
+     * Appends JSON text to a string, inserting the commas between members and elements itself:
+     *
+     *     writer.beginObject().key("id").value(1).key("result").null().endObject();
+     */
+    class Writer {
+    public:
+        std::string out;
+
+        Writer& beginObject() { separate(); out += '{'; first.push_back(true); return *this; }
+        Writer& endObject() { out += '}'; first.pop_back(); return *this; }
+        Writer& beginArray() { separate(); out += '['; first.push_back(true); return *this; }
+        Writer& endArray() { out += ']'; first.pop_back(); return *this; }
+
+        Writer& key(std::string_view name) {
+            separate();
+            quote(name);
+            out += ':';
+            afterKey = true;
+            return *this;
+        }
+
+        Writer& value(std::string_view text) { separate(); quote(text); return *this; }
+        Writer& value(const char* text) { return value(std::string_view(text)); }
+        Writer& value(int64_t number) { separate(); out += std::to_string(number); return *this; }
+        Writer& value(int number) { return value(static_cast<int64_t>(number)); }
+        Writer& value(size_t number) { return value(static_cast<int64_t>(number)); }
+        Writer& value(bool boolean) { separate(); out += boolean ? "true" : "false"; return *this; }
+        Writer& null() { separate(); out += "null"; return *this; }
+
+        /* a parsed value as it was (request ids are numbers or strings) */
+        Writer& value(const Value& value) {
+            switch (value.type) {
+                case Value::Type::NUL:     return null();
+                case Value::Type::BOOLEAN: return this->value(value.boolean);
+                case Value::Type::NUMBER:
+                    separate();
+                    out += value.number == static_cast<double>(value.integer()) ? std::to_string(value.integer()) : std::to_string(value.number);
+                    return *this;
+                case Value::Type::STRING:  return this->value(std::string_view(value.string));
+                case Value::Type::ARRAY:
+                    beginArray();
+                    for (const Value& element : value.array) {
+                        this->value(element);
+                    }
+                    return endArray();
+                case Value::Type::OBJECT:
+                    beginObject();
+                    for (const auto& member : value.object) {
+                        key(member.first).value(member.second);
+                    }
+                    return endObject();
+            }
+            return *this;
+        }
+
+    private:
+        std::vector<bool> first; // per open object or array: nothing was written into it yet
+        bool afterKey = false;
+
+        void separate() {
+            if (afterKey) {
+                afterKey = false;
+            } else if (!first.empty()) {
+                if (!first.back()) {
+                    out += ',';
+                }
+                first.back() = false;
+            }
+        }
+
+        void quote(std::string_view text) {
+            static const char* const HEX = "0123456789abcdef";
+            out += '"';
+            size_t plain = 0; // characters before the first one that needs escaping are appended at once
+            while (plain < text.size() && text[plain] != '"' && text[plain] != '\\' && static_cast<unsigned char>(text[plain]) >= 0x20) {
+                plain++;
+            }
+            out.append(text.data(), plain);
+
+            for (char c : text.substr(plain)) {
+                switch (c) {
+                    case '"':  out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\r': out += "\\r"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            out += "\\u00";
+                            out += HEX[c >> 4];
+                            out += HEX[c & 0xF];
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+        }
+    };
+}
@@ -0,0 +1,468 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../parser/Document.h"
+#include "../parser/OutputSink.h"
+#include "Json.h"
+
+namespace LSP {
+    /* error codes of the protocol */
+    const int PARSE_ERROR = -32700;
+    const int METHOD_NOT_FOUND = -32601;
+    const int INVALID_PARAMS = -32602;
+    const int REQUEST_CANCELLED = -32800;
+    const int CONTENT_MODIFIED = -32801;
+
+    /* symbol kinds of the protocol */
+    const int SYMBOL_FUNCTION = 12;
+    const int SYMBOL_VARIABLE = 13;
+
+    /**
+     * Language server (`pascal-parser --lsp`): JSON-RPC messages with a Content-Length header on stdin and stdout.
+     * Every open file is a Document, which keeps its program in memory and reparses only the method an edit is
+     * in (edits arrive as ranges). Document symbols, go to definition and diagnostics (every syntax error, see
+     * Document::errors) are answered from that program, nothing is parsed per request.
+     *
+     * The main thread only reads messages and queues them, a worker thread handles them in order, so requests can
+     * be cancelled while they wait: $/cancelRequest drops a queued request, a request about a document with edits
+     * queued behind it is answered with ContentModified (its positions are out of date) and diagnostics are only
+     * published for the last of several queued edits.
+     *
+     * Positions count lines from 0 and characters in bytes (Pascal sources are ASCII).
+     */
+    class Server {
+    public:
+        Server(FILE* input, int output, LexerKind lexerKind = LexerKind::FLEX)
+            : input{input}, output{output}, lexerKind{lexerKind}
+        {}
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        /* serves until exit (or the end of the input), returns the exit code */
+        int run() {
+            std::thread worker([this] { work(); });
+
+            std::string body;
+            while (readMessage(body)) {
+                Message message;
+                try {
+                    message.content = Json::Parser::parse(body);
+                } catch (Json::ParseError ex) {
+                    Json::Writer error;
+                    send(errorResponse(error, Json::Value::null(), PARSE_ERROR, ex.what()));
+                    continue;
+                }
+                message.method = message.content["method"].string;
+                message.uri = message.content["params"]["textDocument"]["uri"].string;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (message.method == "$/cancelRequest") {
+                    cancelled.insert(idText(message.content["params"]["id"]));
+                    continue;
+                }
+                if (message.method == "textDocument/didChange") {
+                    pendingChanges[message.uri]++;
+                }
+                bool exit = message.method == "exit";
+                queue.push_back(std::move(message));
+                available.notify_one();
+
+                // the worker stops at it, after everything queued before (a shutdown in particular)
+                if (exit) {
+                    break;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closing = true;
+            }
+            available.notify_one();
+            worker.join();
+
+            return exited && shutdown ? 0 : 1;
+        }
+
+    private:
+        struct Message {
+            Json::Value content;
+            std::string method;
+            std::string uri; // of the document the message is about, if any
+        };
+
+        struct OpenDocument {
+            std::unique_ptr<Document> document; // its errors are the diagnostics
+            int64_t version = 0;
+        };
+
+        FILE* input;
+        OutputSink output;
+        std::mutex outputMutex;
+        LexerKind lexerKind;
+
+        // shared by the reading thread and the worker
+        std::mutex mutex;
+        std::condition_variable available;
+        std::deque<Message> queue;
+        std::unordered_map<std::string, size_t> pendingChanges; // queued edits per document
+        std::unordered_set<std::string> cancelled;              // ids of requests cancelled before they were handled
+        bool closing = false; // nothing more will be queued
+
+        // the worker's own (read by run() once it has joined the worker)
+        std::unordered_map<std::string, OpenDocument> documents;
+        bool shutdown = false;
+        bool exited = false;
+        std::stringstream detail; // of a symbol, reused
+
+        /* ---------------- Transport ---------------- */
+
+        /* the body of the next message, false at the end of the input */
+        bool readMessage(std::string& body) {
+            char line[256];
+            long length = -1;
+            while (fgets(line, sizeof(line), input) != NULL) {
+                if (strcmp(line, "\r\n") == 0 || strcmp(line, "\n") == 0) {
+                    if (length < 0) {
+                        continue; // no header yet
+                    }
+                    body.resize(length);
+                    return fread(&body[0], 1, length, input) == static_cast<size_t>(length);
+                }
+                if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                    length = strtol(line + 15, NULL, 10);
+                }
+            }
+            return false;
+        }
+
+        void send(const std::string& body) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            output << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+            output.flush();
+        }
+
+        static std::string idText(const Json::Value& id) {
+            Json::Writer writer;
+            writer.value(id);
+            return writer.out;
+        }
+
+        /* a writer with the response to the request up to its result, which the caller writes (and closes) */
+        static Json::Writer& response(Json::Writer& writer, const Json::Value& id) {
+            return writer.beginObject().key("jsonrpc").value("2.0").key("id").value(id).key("result");
+        }
+
+        static const std::string& errorResponse(Json::Writer& writer, const Json::Value& id, int code, std::string_view message) {
+            writer.beginObject().key("jsonrpc").value("2.0").key("id").value(id)
+                  .key("error").beginObject().key("code").value(code).key("message").value(message).endObject()
+                  .endObject();
+            return writer.out;
+        }
+
+        /* ---------------- Worker ---------------- */
+
+        void work() {
+            while (true) {
+                Message message;
+                bool stale = false;
+                bool dropped = false;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    available.wait(lock, [this] { return closing || !queue.empty(); });
+                    // at the end of the input whatever came before it is still answered
+                    if (queue.empty()) {
+                        return;
+                    }
+
+                    message = std::move(queue.front());
+                    queue.pop_front();
+                    if (message.method == "exit") {
+                        exited = true;
+                        return;
+                    }
+
+                    auto pending = pendingChanges.find(message.uri);
+                    if (pending != pendingChanges.end()) {
+                        if (message.method == "textDocument/didChange") {
+                            pending->second--;
+                        }
+                        stale = pending->second > 0;
+                    }
+                    if (!message.content["id"].isNull()) {
+                        dropped = cancelled.erase(idText(message.content["id"])) > 0;
+                    }
+                }
+
+                handle(message, stale, dropped);
+            }
+        }
+
+        void handle(const Message& message, bool stale, bool dropped) {
+            const Json::Value& id = message.content["id"];
+            const Json::Value& params = message.content["params"];
+            bool request = !id.isNull();
+            Json::Writer writer;
+
+            if (request && dropped) {
+                send(errorResponse(writer, id, REQUEST_CANCELLED, "Request cancelled"));
+            } else if (message.method == "initialize") {
+                response(writer, id).beginObject()
+                    .key("capabilities").beginObject()
+                        .key("textDocumentSync").beginObject().key("openClose").value(true).key("change").value(2).endObject()
+                        .key("documentSymbolProvider").value(true)
+                        .key("definitionProvider").value(true)
+                    .endObject()
+                    .key("serverInfo").beginObject().key("name").value("pascal-parser").endObject()
+                .endObject().endObject();
+                send(writer.out);
+            } else if (message.method == "shutdown") {
+                shutdown = true;
+                send(response(writer, id).null().endObject().out);
+            } else if (message.method == "textDocument/didOpen") {
+                open(message.uri, params["textDocument"]);
+            } else if (message.method == "textDocument/didChange") {
+                change(message.uri, params, stale);
+            } else if (message.method == "textDocument/didClose") {
+                documents.erase(message.uri);
+                OpenDocument closed;
+                publishDiagnostics(message.uri, closed);
+            } else if (message.method == "textDocument/documentSymbol" || message.method == "textDocument/definition") {
+                auto found = documents.find(message.uri);
+                if (found == documents.end()) {
+                    send(errorResponse(writer, id, INVALID_PARAMS, "Unknown document " + message.uri));
+                } else if (stale) {
+                    send(errorResponse(writer, id, CONTENT_MODIFIED, "Document changed"));
+                } else if (message.method == "textDocument/documentSymbol") {
+                    symbols(response(writer, id), *found->second.document);
+                    send(writer.endObject().out);
+                } else {
+                    definition(response(writer, id), message.uri, *found->second.document, params["position"]);
+                    send(writer.endObject().out);
+                }
+            } else if (request) {
+                send(errorResponse(writer, id, METHOD_NOT_FOUND, "Unknown method " + message.method));
+            }
+        }
+
+        /* ---------------- Documents ---------------- */
+
+        void open(const std::string& uri, const Json::Value& textDocument) {
+            OpenDocument& opened = documents[uri];
+            opened.document.reset(new Document(textDocument["text"].string, lexerKind));
+            opened.version = textDocument["version"].integer();
+
+            try {
+                opened.document->parse();
+            } catch (SyntaxException) {
+                // published below, with all others
+            }
+            publishDiagnostics(uri, opened);
+        }
+
+        void change(const std::string& uri, const Json::Value& params, bool stale) {
+            auto found = documents.find(uri);
+            if (found == documents.end()) {
+                return;
+            }
+            OpenDocument& changed = found->second;
+            Document& document = *changed.document;
+            changed.version = params["textDocument"]["version"].integer();
+
+            for (const Json::Value& change : params["contentChanges"].array) {
+                const Json::Value& range = change["range"];
+                try {
+                    if (range.isNull()) {
+                        document.edit(0, document.size(), change["text"].string);
+                    } else {
+                        size_t start = offsetAt(document, range["start"]);
+                        size_t end = std::max(start, offsetAt(document, range["end"]));
+                        document.edit(start, end - start, change["text"].string);
+                    }
+                } catch (SyntaxException) {
+                    // published below, with all others
+                }
+            }
+
+            // the next edit is queued already, it publishes the diagnostics of its version
+            if (!stale) {
+                publishDiagnostics(uri, changed);
+            }
+        }
+
+        void publishDiagnostics(const std::string& uri, OpenDocument& document) {
+            Json::Writer writer;
+            writer.beginObject().key("jsonrpc").value("2.0").key("method").value("textDocument/publishDiagnostics")
+                  .key("params").beginObject().key("uri").value(uri);
+            if (document.document != NULL) {
+                writer.key("version").value(document.version);
+            }
+            writer.key("diagnostics").beginArray();
+
+            if (document.document != NULL) {
+                Document& text = *document.document;
+                for (const SyntaxException& error : text.errors) {
+                    // the whole line, syntax errors only know theirs
+                    int line = std::max(error.lineNumber, 1);
+                    size_t start = text.offsetAt(line, 0);
+                    size_t end = text.offsetAt(line, SIZE_MAX);
+
+                    writer.beginObject().key("range");
+                    range(writer, line, 0, line, end - start);
+                    writer.key("severity").value(1).key("source").value("pascal-parser").key("message").value(error.what())
+                          .endObject();
+                }
+            }
+
+            writer.endArray().endObject().endObject();
+            send(writer.out);
+        }
+
+        static size_t offsetAt(const Document& document, const Json::Value& position) {
+            return document.offsetAt(position["line"].integer() + 1, position["character"].integer());
+        }
+
+        /* ---------------- Requests ---------------- */
+
+        /* the global variables, then every method with its arguments and local variables */
+        void symbols(Json::Writer& writer, Document& document) {
+            Program* prog = document.program();
+            writer.beginArray();
+            if (prog == NULL) {
+                writer.endArray();
+                return;
+            }
+
+            for (Variable* variable : prog->declarations) {
+                variableSymbol(writer, document, variable, Document::NONE);
+            }
+
+            for (size_t i = 0; i < prog->methods.size(); i++) {
+                Method* meth = prog->methods[i];
+                size_t start = document.methodStart(i);
+                size_t end = document.methodStart(i + 1); // up to the next method (or the main block)
+
+                detail.str("");
+                if (meth->returnType != NULL) {
+                    detail << "function: " << *meth->returnType;
+                } else {
+                    detail << "procedure";
+                }
+
+                writer.beginObject().key("name").value(meth->identifier.text()).key("detail").value(detail.str())
+                      .key("kind").value(SYMBOL_FUNCTION).key("range");
+                range(writer, document.lineOf(start), document.columnOf(start), document.lineOf(end), document.columnOf(end));
+                writer.key("selectionRange");
+                tokenRange(writer, document, meth->identifier, i);
+
+                writer.key("children").beginArray();
+                for (Variable* variable : meth->arguments) {
+                    variableSymbol(writer, document, variable, i);
+                }
+                for (Variable* variable : meth->declarations) {
+                    variableSymbol(writer, document, variable, i);
+                }
+                writer.endArray().endObject();
+            }
+            writer.endArray();
+        }
+
+        void variableSymbol(Json::Writer& writer, const Document& document, Variable* variable, size_t method) {
+            detail.str("");
+            detail << *variable->type;
+
+            writer.beginObject().key("name").value(variable->name.text()).key("detail").value(detail.str())
+                  .key("kind").value(SYMBOL_VARIABLE).key("range");
+            tokenRange(writer, document, variable->name, method);
+            writer.key("selectionRange");
+            tokenRange(writer, document, variable->name, method);
+            writer.endObject();
+        }
+
+        /* the declaration of the name at the position: a local variable or argument of the method it is in, a global or a method */
+        void definition(Json::Writer& writer, const std::string& uri, Document& document, const Json::Value& position) {
+            Program* prog = document.program();
+            size_t offset = offsetAt(document, position);
+
+            size_t start = offset;
+            size_t end = offset;
+            while (start > 0 && Document::isWord(document.at(start - 1))) {
+                start--;
+            }
+            while (end < document.size() && Document::isWord(document.at(end))) {
+                end++;
+            }
+
+            std::string name;
+            for (size_t i = start; i < end; i++) {
+                name += document.at(i);
+            }
+
+            if (prog == NULL || name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+                writer.null();
+                return;
+            }
+
+            size_t method = document.methodAt(offset);
+            if (method != Document::NONE && method < prog->methods.size()) {
+                Method* meth = prog->methods[method];
+                for (const ArenaVector<Variable*>* variables : {&meth->arguments, &meth->declarations}) {
+                    for (Variable* variable : *variables) {
+                        if (variable->name.text() == name) {
+                            location(writer, uri, document, variable->name, method);
+                            return;
+                        }
+                    }
+                }
+            }
+
+            for (Variable* variable : prog->declarations) {
+                if (variable->name.text() == name) {
+                    location(writer, uri, document, variable->name, Document::NONE);
+                    return;
+                }
+            }
+
+            for (size_t i = 0; i < prog->methods.size(); i++) {
+                if (prog->methods[i]->identifier.text() == name) {
+                    location(writer, uri, document, prog->methods[i]->identifier, i);
+                    return;
+                }
+            }
+
+            writer.null();
+        }
+
+        void location(Json::Writer& writer, const std::string& uri, const Document& document, const Token& token, size_t method) {
+            writer.beginObject().key("uri").value(uri).key("range");
+            tokenRange(writer, document, token, method);
+            writer.endObject();
+        }
+
+        void tokenRange(Json::Writer& writer, const Document& document, const Token& token, size_t method) {
+            size_t column = document.columnOf(document.offsetOf(token, method));
+            range(writer, token.lineNumber, column, token.lineNumber, column + token.length);
+        }
+
+        /* lines as the parser counts them, from 1 */
+        static void range(Json::Writer& writer, int startLine, size_t startColumn, int endLine, size_t endColumn) {
+            writer.beginObject()
+                  .key("start").beginObject().key("line").value(startLine - 1).key("character").value(startColumn).endObject()
+                  .key("end").beginObject().key("line").value(endLine - 1).key("character").value(endColumn).endObject()
+                  .endObject();
+        }
+    };
+}
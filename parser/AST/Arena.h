@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * Bump allocator holding all nodes of one AST. Nodes are carved out of large chunks and are never freed
+ * one by one; deleting the arena releases every chunk at once, so no destructor of a node is ever run.
+ * Everything placed into the arena must therefore not own memory outside of it (see ArenaVector).
+ */
+class Arena {
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    Arena(size_t chunkSize = DEFAULT_CHUNK_SIZE) : chunkSize{chunkSize} {}
+    ~Arena() {
+        for (auto& chunk : chunks) {
+            free(chunk);
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+
+        if (current == NULL || offset + size > capacity) {
+            newChunk(size);
+            offset = 0; // chunks returned by malloc are aligned for every type
+        }
+
+        used = offset + size;
+        return current + offset;
+    }
+
+    /* constructs a node inside the arena */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /* number of bytes reserved from the system (for statistics) */
+    size_t reservedBytes() const { return reserved; }
+
+private:
+    size_t chunkSize;
+    std::vector<char*> chunks;
+
+    char* current = NULL;
+    size_t capacity = 0; // size of the current chunk
+    size_t used = 0;     // bytes used in the current chunk
+    size_t reserved = 0;
+
+    void newChunk(size_t minimumSize) {
+        // oversized requests get a chunk of their own
+        size_t size = minimumSize > chunkSize ? minimumSize : chunkSize;
+
+        current = static_cast<char*>(malloc(size));
+        if (current == NULL) {
+            throw std::bad_alloc();
+        }
+
+        chunks.push_back(current);
+        capacity = size;
+        used = 0;
+        reserved += size;
+    }
+};
+
+
+/**
+ * Allocator that lets standard containers live inside an arena. Deallocation is a no-op, the memory is
+ * handed back when the arena is deleted.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena* arena) : arena{arena} {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena{other.arena} {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    Arena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
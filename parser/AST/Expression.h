@@ -1,35 +1,27 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <vector>
 
 
+#include "Arena.h"
+#include "Slots.h"
 #include "Token.h"
 #include "../../common/token-enum.h"
 
 namespace Expr {
-    /* forward declarations */
-    class Binary; class Call; class Grouping;
-    class Identifier; class Literal; class Unary;
+    /* tag of the concrete expression class, ASTVisitor dispatches on it with a switch (there are no virtual calls) */
+    enum class Kind : uint8_t { BINARY, CALL, GROUPING, IDENTIFIER, LITERAL, UNARY };
 
-    /* expression visitor */
-    class Visitor {
-    public:
-        virtual ~Visitor() = default;
-
-        virtual void visitBinary(Binary* expr) {};
-        virtual void visitCall(Call* expr) {};
-        virtual void visitGrouping(Grouping* expr) {};
-        virtual void visitIdentifier(Identifier* expr) {};
-        virtual void visitLiteral(Literal* expr) {};
-        virtual void visitUnary(Unary* expr) {};
-    };
-
-    /* Base class for all expressions */
+    /* Base class for all expressions (allocated in the arena of their program, never deleted on their own) */
     class Expression {
     public:
-        virtual ~Expression() = default;
-        virtual void accept(Visitor* visitor) = 0;
+        Expression(Kind kind) : kind{kind} {}
+
+        Kind kind;
+        ValueType type = ValueType::INTEGER; // set by the TypeChecker, ARRAY for a whole array
     };
     
 
@@ -37,79 +29,86 @@ namespace Expr {
     class Binary : public Expression {
     public:
         Binary(Expression* left, Token op, Expression* right) 
-            : left{left}, op{op}, right{right}
+            : Expression(Kind::BINARY), left{left}, op{op}, right{right}
         {}
-        ~Binary() {
-            delete left;
-            delete right;
-        }
 
+        ValueType operandType = ValueType::INTEGER; // set by the TypeChecker: both operands are converted to it
         Expression* left;
         Token op;
         Expression* right;
-
-        void accept(Visitor* visitor) { visitor->visitBinary(this); }
     };
 
     class Call : public Expression {
     public:
-        Call(Token callee, std::vector<Expression*> arguments)
-            : callee{callee}, arguments{arguments}
+        Call(Token callee, ArenaVector<Expression*> arguments)
+            : Expression(Kind::CALL), callee{callee}, arguments{std::move(arguments)}
         {}
-        ~Call() {
-            for (auto& arg : arguments) {
-                delete arg;
-            }
-        }
 
+        CallTarget target; // set by the Resolver
         Token callee;
-        std::vector<Expression*> arguments;
-
-        void accept(Visitor* visitor) { visitor->visitCall(this); }
+        ArenaVector<Expression*> arguments;
     };
 
     class Grouping : public Expression {
     public:
-        Grouping(Expression* expression) : expression{expression} {}
-        ~Grouping() { delete expression; }
+        Grouping(Expression* expression) : Expression(Kind::GROUPING), expression{expression} {}
         
         Expression* expression;
-
-        void accept(Visitor* visitor) { visitor->visitGrouping(this); }
     };
 
     class Identifier : public Expression {
     public:
         Identifier(Token token, Expression* arrayIndexExpression) 
-            : token{token}, arrayIndexExpression{arrayIndexExpression} {}
-        ~Identifier() { delete arrayIndexExpression; }
+            : Expression(Kind::IDENTIFIER), token{token}, arrayIndexExpression{arrayIndexExpression} {}
 
+        VariableSlot slot; // set by the Resolver
         Token token;
         Expression* arrayIndexExpression;
-
-        void accept(Visitor* visitor) { visitor->visitIdentifier(this); }
     };
 
     class Literal : public Expression {
     public:
-        Literal(Token token) : token{token} {}
-        ~Literal() { }
-        
-        Token token;
+        Literal(Token token) : Expression(Kind::LITERAL), token{token} {}
 
-        void accept(Visitor* visitor) { visitor->visitLiteral(this); }
+        uint32_t constant = UNRESOLVED; // index into the constants of the Resolver
+        Token token;
     };
 
     class Unary : public Expression {
     public:
-        Unary(Token op, Expression* right) : op{op}, right{right} {}
-        ~Unary() { delete right; }
+        Unary(Token op, Expression* right) : Expression(Kind::UNARY), op{op}, right{right} {}
 
         Token op;
         Expression* right;
-
-        void accept(Visitor* visitor) { visitor->visitUnary(this); }
     };
 
+    /* a line for errors about a whole expression: the line of its first token */
+    inline int lineOf(Expression* expr) {
+        switch (expr->kind) {
+            case Kind::BINARY:     return lineOf(static_cast<Binary*>(expr)->left);
+            case Kind::CALL:       return static_cast<Call*>(expr)->callee.lineNumber;
+            case Kind::GROUPING:   return lineOf(static_cast<Grouping*>(expr)->expression);
+            case Kind::IDENTIFIER: return static_cast<Identifier*>(expr)->token.lineNumber;
+            case Kind::LITERAL:    return static_cast<Literal*>(expr)->token.lineNumber;
+            case Kind::UNARY:      return static_cast<Unary*>(expr)->op.lineNumber;
+        }
+        return 0;
+    }
+
+    /* whether evaluating the expression calls a method (which may change globals) */
+    inline bool hasCall(Expression* expr) {
+        switch (expr->kind) {
+            case Kind::BINARY:     return hasCall(static_cast<Binary*>(expr)->left) || hasCall(static_cast<Binary*>(expr)->right);
+            case Kind::CALL:       return true;
+            case Kind::GROUPING:   return hasCall(static_cast<Grouping*>(expr)->expression);
+            case Kind::IDENTIFIER: {
+                Expression* index = static_cast<Identifier*>(expr)->arrayIndexExpression;
+                return index != NULL && hasCall(index);
+            }
+            case Kind::LITERAL:    return false;
+            case Kind::UNARY:      return hasCall(static_cast<Unary*>(expr)->right);
+        }
+        return false;
+    }
 }
 
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string_view>
+#include <vector>
+
+#include "StringInterner.h"
+#include "../../common/token-enum.h"
+
+namespace Flat {
+    /* index of a node inside a FlatAST */
+    typedef uint32_t NodeIndex;
+
+    enum NodeKind : uint8_t {
+        PROGRAM,        // identifier; declarations (VARIABLE), methods (METHOD), main BLOCK
+        METHOD,         // identifier; PARAMETERs, declarations (VARIABLE), return type (if HAS_RETURN_TYPE), BLOCK
+        PARAMETER,      // name; type
+        VARIABLE,       // name; type
+        SIMPLE_TYPE,    // type name
+        ARRAY_TYPE,     // type name; start and stop of the range (LITERAL)
+
+        BLOCK,          // statements
+        ASSIGNMENT,     // identifier; array index (if HAS_ARRAY_INDEX), value
+        CALL_STATEMENT, // callee; arguments
+        IF,             // condition, then, else (if HAS_ELSE)
+        WHILE,          // condition, body
+
+        BINARY,         // operator; left, right
+        CALL,           // callee; arguments
+        GROUPING,       // inner expression
+        IDENTIFIER,     // identifier; array index (if HAS_ARRAY_INDEX)
+        LITERAL,        // literal
+        UNARY,          // operator; operand
+    };
+
+    /* bits of FlatAST::flags, marking the optional children that are present */
+    enum NodeFlags : uint8_t {
+        HAS_ARRAY_INDEX = 1,
+        HAS_ELSE = 2,
+        HAS_RETURN_TYPE = 4,
+    };
+}
+
+/**
+ * An AST stored as a structure of arrays instead of a tree of objects: every node is one entry in each array,
+ * referenced by a 32-bit index. Nodes are laid out in pre-order, so the first child of node n is n + 1 and
+ * every node knows the size of its subtree, which is where its next sibling starts. A whole program can be
+ * scanned front to back without following a single pointer.
+ *
+ * Each node keeps the token it was built from (operator, name, literal...) as type and symbol; nodes
+ * without a token of their own (blocks, if, while, grouping) have type 0. The texts stay in the interner of
+ * the program the flat AST was converted from (see AST2Flat), which has to outlive it.
+ */
+class FlatAST {
+public:
+    FlatAST(const StringInterner* symbols) : symbols{symbols} {}
+
+    /* appends a node without children so far, its subtree grows until close() is called */
+    Flat::NodeIndex open(Flat::NodeKind kind, TokenType tokenType = static_cast<TokenType>(0), Symbol symbol = NO_SYMBOL,
+                         int lineNumber = 0, uint8_t nodeFlags = 0) {
+        Flat::NodeIndex node = kinds.size();
+
+        kinds.push_back(kind);
+        flags.push_back(nodeFlags);
+        tokenTypes.push_back(tokenType);
+        tokenSymbols.push_back(symbol);
+        lines.push_back(lineNumber);
+        sizes.push_back(1);
+
+        return node;
+    }
+
+    /* ends the subtree of a node, everything appended since open() are its descendants */
+    void close(Flat::NodeIndex node) {
+        sizes[node] = kinds.size() - node;
+    }
+
+    /* releases the spare capacity left from building */
+    void shrink() {
+        kinds.shrink_to_fit();
+        flags.shrink_to_fit();
+        tokenTypes.shrink_to_fit();
+        tokenSymbols.shrink_to_fit();
+        lines.shrink_to_fit();
+        sizes.shrink_to_fit();
+    }
+
+    size_t size() const { return kinds.size(); }
+
+    /* the root (PROGRAM) node */
+    Flat::NodeIndex root() const { return 0; }
+
+    Flat::NodeIndex firstChild(Flat::NodeIndex node) const { return node + 1; }
+    Flat::NodeIndex nextSibling(Flat::NodeIndex node) const { return node + sizes[node]; }
+    /* one past the last descendant of the node */
+    Flat::NodeIndex end(Flat::NodeIndex node) const { return node + sizes[node]; }
+
+    bool has(Flat::NodeIndex node, Flat::NodeFlags flag) const { return (flags[node] & flag) != 0; }
+
+    /* text of the token of a node: the interned text or the fixed spelling of the token type */
+    std::string_view text(Flat::NodeIndex node) const {
+        if (tokenSymbols[node] != NO_SYMBOL) {
+            return symbols->text(tokenSymbols[node]);
+        }
+        return TOKEN_SPELLINGS[tokenTypes[node]] != NULL ? TOKEN_SPELLINGS[tokenTypes[node]] : "";
+    }
+
+    /* bytes held by the arrays (for statistics) */
+    size_t memoryBytes() const {
+        return kinds.capacity() * sizeof(uint8_t) + flags.capacity() * sizeof(uint8_t)
+             + tokenTypes.capacity() * sizeof(uint8_t) + tokenSymbols.capacity() * sizeof(Symbol)
+             + lines.capacity() * sizeof(uint32_t) + sizes.capacity() * sizeof(uint32_t);
+    }
+
+    const StringInterner* symbols;
+
+    std::vector<uint8_t> kinds;         // Flat::NodeKind
+    std::vector<uint8_t> flags;         // Flat::NodeFlags
+    std::vector<uint8_t> tokenTypes;    // TokenType of the token of the node
+    std::vector<Symbol> tokenSymbols;   // interned text of the token, NO_SYMBOL for fixed spellings
+    std::vector<uint32_t> lines;        // line of the token
+    std::vector<uint32_t> sizes;        // number of nodes in the subtree, including the node itself
+};
@@ -3,46 +3,24 @@
 
 #include <vector>
 
+#include "Arena.h"
 #include "Statement.h"
 #include "Variable.h"
 
 
 class Method {
 public:
-    /* method visitor */
-    class Visitor {
-    public:
-        virtual ~Visitor() = default;
-
-        virtual void visitMethod(Method* method) {};
-    };
-
-
     Method(Token identifier,
-           std::vector<Variable*> arguments, 
-           std::vector<Variable*> declarations, 
+           ArenaVector<Variable*> arguments, 
+           ArenaVector<Variable*> declarations, 
            Stmt::Block* block,
            Variable::VariableType* returnType)
-        : identifier{identifier}, arguments{arguments}, declarations{declarations}, block{block}, returnType{returnType}
+        : identifier{identifier}, arguments{std::move(arguments)}, declarations{std::move(declarations)}, block{block}, returnType{returnType}
     {}
-    ~Method() {
-        for (auto& arg : arguments) {
-            delete arg;
-        }
-
-        for (auto& decl : declarations) {
-            delete decl;
-        }
-
-        delete block;
-        delete returnType;
-    }
 
     Token identifier;
-    std::vector<Variable*> arguments;
-    std::vector<Variable*> declarations;
+    ArenaVector<Variable*> arguments;
+    ArenaVector<Variable*> declarations;
     Stmt::Block* block;
     Variable::VariableType* returnType;
-
-    void accept(Visitor* visitor) { visitor->visitMethod(this); }
 };
\ No newline at end of file
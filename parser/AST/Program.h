@@ -3,40 +3,38 @@
 
 #include <vector>
 
+#include "Arena.h"
+#include "StringInterner.h"
+#include "../SourceFile.h"
 #include "Statement.h"
 #include "Variable.h"
 #include "Method.h"
 
 class Program {
 public:
-    /* program visitor */
-    class Visitor {
-    public:
-        virtual ~Visitor() = default;
-
-        virtual void visitProgram(Program* prog) {};
-    };
-
-    Program(Token identifier, std::vector<Variable*> declarations, std::vector<Method*> methods, Stmt::Block* main)
-        : identifier{identifier}, declarations{declarations}, methods{methods}, main{main}
+    Program(Token identifier, ArenaVector<Variable*> declarations, ArenaVector<Method*> methods, Stmt::Block* main,
+            Arena* arena, StringInterner* symbols, SourceFile* source)
+        : identifier{identifier}, declarations{std::move(declarations)}, methods{std::move(methods)}, main{main},
+          arena{arena}, symbols{symbols}, source{source}
     {}
 
+    /* all nodes of the program live in its arena, so they are released in one go */
     ~Program() {
-        for (auto& decl : declarations) {
-            delete decl;
+        delete symbols;
+        delete arena;
+        delete source;
+        for (SourceFile* part : parts) {
+            delete part;
         }
-
-        for (auto& meth : methods) {
-            delete meth;
-        }
-
-        delete main;
     }
 
     Token identifier;
-    std::vector<Variable*> declarations;
-    std::vector<Method*> methods;
+    ArenaVector<Variable*> declarations;
+    ArenaVector<Method*> methods;
     Stmt::Block* main;
 
-    void accept(Visitor* visitor) { visitor->visitProgram(this); }
+    Arena* arena;
+    StringInterner* symbols; // texts of all identifiers and literals
+    SourceFile* source;      // mapped input the token texts point into, NULL when parsed from a stream
+    std::vector<SourceFile*> parts; // texts of the methods a Document reparsed since, their tokens point into them
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Run time locations of the names used in the AST. The parser leaves them unresolved, the Resolver
+ * (interpreter/Resolver.h) fills them in, so nothing has to look up a name by its text while running.
+ * Each is packed into 32 bits, which fits into the padding behind the kind tag of the node holding it.
+ */
+const uint32_t UNRESOLVED = 0x7fffffff;
+
+/* a variable: index into the frame of the running method, or into the globals of the program */
+struct VariableSlot {
+    VariableSlot() : index{UNRESOLVED}, global{0} {}
+    VariableSlot(uint32_t index, bool global) : index{index}, global{global} {}
+
+    uint32_t index : 31;
+    uint32_t global : 1;
+};
+
+/* the callee of a call: index into Program::methods, or a Builtin of the interpreter */
+struct CallTarget {
+    CallTarget() : index{UNRESOLVED}, builtin{0} {}
+    CallTarget(uint32_t index, bool builtin) : index{index}, builtin{builtin} {}
+
+    uint32_t index : 31;
+    uint32_t builtin : 1;
+};
+
+/* the static type of an expression, set by the TypeChecker (interpreter/TypeChecker.h); also the tag of a run time Value */
+enum class ValueType : uint8_t { INTEGER, REAL, BOOLEAN, ARRAY, STRING };
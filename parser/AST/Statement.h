@@ -1,121 +1,81 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <vector>
 
+#include "Arena.h"
 #include "Expression.h"
+#include "Slots.h"
 #include "Token.h"
 
 using Expr::Expression;
 
 namespace Stmt {
-    /* forward declarations */
-    class Assignment; class Call; class If; class While; class Block;
-
-     /* statement visitor */
-    class Visitor {
-    public:
-        virtual ~Visitor() = default;
+    /* tag of the concrete statement class, ASTVisitor dispatches on it with a switch (there are no virtual calls) */
+    enum class Kind : uint8_t { ASSIGNMENT, CALL, IF, WHILE, BLOCK };
 
-        virtual void visitAssignment(Assignment* stmt) {};
-        virtual void visitCall(Call* stmt) {};
-        virtual void visitIf(If* stmt) {};
-        virtual void visitWhile(While* stmt) {};
-        virtual void visitBlock(Block* stmt) {};
-    };
-
-
-    /* Base class */
+    /* Base class (allocated in the arena of their program, never deleted on their own) */
     class Statement {
     public:
-        virtual ~Statement() = default;
-        virtual void accept(Visitor* visitor) = 0;
+        Statement(Kind kind) : kind{kind} {}
+
+        Kind kind;
     };
 
     /* different types of statements */
     class Assignment : public Statement {
     public:
         Assignment(Token identifier, Expression* arrayIndex, Expression* value) 
-            : identifier{identifier}, arrayIndex{arrayIndex}, value{value}
+            : Statement(Kind::ASSIGNMENT), identifier{identifier}, arrayIndex{arrayIndex}, value{value}
         {}
-        ~Assignment() {
-            delete arrayIndex;
-            delete value;
-        }
 
+        VariableSlot slot; // set by the Resolver
         Token identifier;
         Expression* arrayIndex;
         Expression* value;
-
-        void accept(Visitor* visitor) { visitor->visitAssignment(this); }
     };
 
     class Call : public Statement {
     public:
-        Call(Token callee, std::vector<Expression*> arguments)
-            : callee{callee}, arguments{arguments}
+        Call(Token callee, ArenaVector<Expression*> arguments)
+            : Statement(Kind::CALL), callee{callee}, arguments{std::move(arguments)}
         {}
-        ~Call() {
-            for (auto& arg : arguments) {
-                delete arg;
-            }
-        }
 
+        CallTarget target; // set by the Resolver
         Token callee;
-        std::vector<Expression*> arguments;
-
-        void accept(Visitor* visitor) { visitor->visitCall(this); }
+        ArenaVector<Expression*> arguments;
     };
 
     class If : public Statement {
     public:
         If(Expression* condition, Statement* thenBody, Statement* elseBody)
-            : condition{condition}, thenBody{thenBody}, elseBody{elseBody}
+            : Statement(Kind::IF), condition{condition}, thenBody{thenBody}, elseBody{elseBody}
         {}
-        ~If() {
-            delete condition;
-            delete thenBody;
-            delete elseBody;
-        }
 
         Expression* condition;
         Statement* thenBody;
         Statement* elseBody;
-
-        void accept(Visitor* visitor) { visitor->visitIf(this); }
-
     };
 
     class While : public Statement {
     public:
         While(Expression* condition, Statement* body)
-            : condition{condition}, body{body}
+            : Statement(Kind::WHILE), condition{condition}, body{body}
         {}
-        ~While() {
-            delete condition;
-            delete body;
-        }
 
         Expression* condition;
         Statement* body;
-
-        void accept(Visitor* visitor) { visitor->visitWhile(this); }
     };
 
     class Block : public Statement {
     public:
-        Block(std::vector<Statement*> statements)
-            : statements{statements}
+        Block(ArenaVector<Statement*> statements)
+            : Statement(Kind::BLOCK), statements{std::move(statements)}
         {}
-        ~Block() {
-            for (auto& stmt : statements) {
-                delete stmt;
-            }
-        }
-
-        std::vector<Statement*> statements;
 
-        void accept(Visitor* visitor) { visitor->visitBlock(this); }
+        ArenaVector<Statement*> statements;
     };
 
 };
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.h"
+
+/* small integer id of an interned identifier or literal text, NO_SYMBOL for tokens with a fixed spelling */
+typedef unsigned int Symbol;
+const Symbol NO_SYMBOL = 0;
+
+/**
+ * Keeps exactly one copy of every distinct identifier/literal text of a program and hands out a symbol id
+ * for it, so names can be compared by integer. The texts are either copied into the arena of the program or,
+ * if they live as long as the program anyway (mapped source files), referenced where they are.
+ */
+class StringInterner {
+public:
+    StringInterner(Arena* arena) : arena{arena} {
+        texts.push_back(std::string_view()); // NO_SYMBOL
+    }
+
+    /* interns a copy of the text (for texts from a temporary lexer buffer) */
+    Symbol intern(std::string_view text) {
+        auto found = symbols.find(text);
+        if (found != symbols.end()) {
+            return found->second;
+        }
+
+        char* copy = static_cast<char*>(arena->allocate(text.size() + 1, 1));
+        memcpy(copy, text.data(), text.size());
+        copy[text.size()] = '\0';
+
+        return add(std::string_view(copy, text.size()));
+    }
+
+    /* interns the text without copying it, it has to stay valid as long as the interner */
+    Symbol internInPlace(std::string_view text) {
+        auto found = symbols.find(text);
+        if (found != symbols.end()) {
+            return found->second;
+        }
+
+        return add(text);
+    }
+
+    /* symbol of an already interned text or NO_SYMBOL, never adds anything */
+    Symbol lookup(std::string_view text) const {
+        auto found = symbols.find(text);
+        return found != symbols.end() ? found->second : NO_SYMBOL;
+    }
+
+    std::string_view text(Symbol symbol) const { return texts[symbol]; }
+
+    /* number of distinct texts (without NO_SYMBOL) */
+    size_t size() const { return texts.size() - 1; }
+
+private:
+    Arena* arena;
+    std::vector<std::string_view> texts; // indexed by symbol
+    std::unordered_map<std::string_view, Symbol> symbols;
+
+    Symbol add(std::string_view text) {
+        Symbol symbol = texts.size();
+        texts.push_back(text);
+        symbols.emplace(text, symbol);
+
+        return symbol;
+    }
+};
@@ -1,19 +1,28 @@
-
 #pragma once
 
-#include <string.h>
+#include <ostream>
+#include <string_view>
 
+#include "StringInterner.h"
 #include "../../common/token-enum.h"
 
 class Token {
 public:
     TokenType type;
-    char* lexeme;
+    const char* lexeme;  // fixed spelling of the token type, interned text or slice of the mapped source
+    unsigned int length; // lexeme is not null terminated when it points into the source
+    Symbol symbol;       // NO_SYMBOL for tokens with a fixed spelling
     int lineNumber;
+    unsigned int offset; // byte offset of the token in the text it was scanned from (a reparsed part counts from its start)
+
+    Token(TokenType type, std::string_view text, int lineNumber, unsigned int offset, Symbol symbol = NO_SYMBOL)
+        : type{type}, lexeme{text.data()}, length{static_cast<unsigned int>(text.size())}, symbol{symbol},
+          lineNumber{lineNumber}, offset{offset}
+    {}
+
+    std::string_view text() const { return std::string_view(lexeme, length); }
+};
 
-    Token(TokenType type, char* lexeme, int lineNumber)
-        : type{type}, lineNumber{lineNumber}
-    {
-        this->lexeme = strdup(lexeme); // TODO: free memory
-    }
-};
\ No newline at end of file
+inline std::ostream& operator<<(std::ostream& out, const Token& token) {
+    return out << token.text();
+}
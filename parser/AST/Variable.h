@@ -1,6 +1,9 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <ostream>
 #include <vector>
 
 #include "Statement.h"
@@ -13,21 +16,24 @@ public:
 
     class VariableType {
     public:
-        virtual ~VariableType() = default;
-        VariableType(Token typeName) : typeName{typeName} {}
+        /* tag of the concrete type class, so nobody has to dynamic_cast to tell them apart */
+        enum class Kind : uint8_t { SIMPLE, ARRAY };
+
+        VariableType(Kind kind, Token typeName) : kind{kind}, typeName{typeName} {}
 
+        Kind kind;
         Token typeName;
     };
 
     class VariableTypeSimple : public VariableType {
     public:
-        VariableTypeSimple(Token typeName) : VariableType(typeName) {}
+        VariableTypeSimple(Token typeName) : VariableType(Kind::SIMPLE, typeName) {}
     };
 
     class VariableTypeArray : public VariableType {
     public:
         VariableTypeArray(Token typeName, Token startRange, Token stopRange) 
-            : VariableType(typeName), startRange{startRange}, stopRange{stopRange}
+            : VariableType(Kind::ARRAY, typeName), startRange{startRange}, stopRange{stopRange}
         {}        
 
         Token startRange;
@@ -40,4 +46,22 @@ public:
 
     Token name;
     VariableType* type;
-};
\ No newline at end of file
+};
+
+/* prints a type the way it is written in Pascal: the type name, followed by [start..stop] for arrays
+   (to a std::ostream or an OutputSink) */
+template <typename Output>
+Output& printType(Output& out, const Variable::VariableType& type) {
+    out << type.typeName.text();
+
+    if (type.kind == Variable::VariableType::Kind::ARRAY) {
+        const Variable::VariableTypeArray& arrayType = static_cast<const Variable::VariableTypeArray&>(type);
+        out << "[" << arrayType.startRange.text() << ".." << arrayType.stopRange.text() << "]";
+    }
+
+    return out;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Variable::VariableType& type) {
+    return printType(out, type);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Expression.h"
+#include "Statement.h"
+#include "Variable.h"
+#include "Method.h"
+#include "Program.h"
+
+/**
+ * Visitor with static dispatch (CRTP): visit() switches over the kind tag of a node and calls visitX() of
+ * Derived directly. Nodes have no vtables, the compiler sees the whole traversal and can inline it.
+ *
+ *     class Printer : public ASTVisitor<Printer> {
+ *     public:
+ *         void visitBinary(Expr::Binary* expr) { visit(expr->left); ... }
+ *     };
+ *
+ * Every visitX() has a default that does nothing (and returns Result()), derived visitors define the ones they
+ * need. A visitor defining only one of the two visitCall() overloads has to pull in the other one with
+ * `using ASTVisitor<Derived>::visitCall;`.
+ */
+template <typename Derived, typename Result = void>
+class ASTVisitor {
+public:
+    Result visit(Program* prog) { return derived()->visitProgram(prog); }
+    Result visit(Method* meth) { return derived()->visitMethod(meth); }
+
+    // forced inline, so every call site gets a jump table of its own, which the branch predictor can tell apart
+    [[gnu::always_inline]] inline Result visit(Stmt::Statement* stmt) {
+        switch (stmt->kind) {
+            case Stmt::Kind::ASSIGNMENT: return derived()->visitAssignment(static_cast<Stmt::Assignment*>(stmt));
+            case Stmt::Kind::CALL:       return derived()->visitCall(static_cast<Stmt::Call*>(stmt));
+            case Stmt::Kind::IF:         return derived()->visitIf(static_cast<Stmt::If*>(stmt));
+            case Stmt::Kind::WHILE:      return derived()->visitWhile(static_cast<Stmt::While*>(stmt));
+            case Stmt::Kind::BLOCK:      return derived()->visitBlock(static_cast<Stmt::Block*>(stmt));
+        }
+        return Result();
+    }
+
+    [[gnu::always_inline]] inline Result visit(Expr::Expression* expr) {
+        switch (expr->kind) {
+            case Expr::Kind::BINARY:     return derived()->visitBinary(static_cast<Expr::Binary*>(expr));
+            case Expr::Kind::CALL:       return derived()->visitCall(static_cast<Expr::Call*>(expr));
+            case Expr::Kind::GROUPING:   return derived()->visitGrouping(static_cast<Expr::Grouping*>(expr));
+            case Expr::Kind::IDENTIFIER: return derived()->visitIdentifier(static_cast<Expr::Identifier*>(expr));
+            case Expr::Kind::LITERAL:    return derived()->visitLiteral(static_cast<Expr::Literal*>(expr));
+            case Expr::Kind::UNARY:      return derived()->visitUnary(static_cast<Expr::Unary*>(expr));
+        }
+        return Result();
+    }
+
+    Result visitProgram(Program* prog) { return Result(); }
+    Result visitMethod(Method* meth) { return Result(); }
+
+    Result visitAssignment(Stmt::Assignment* stmt) { return Result(); }
+    Result visitCall(Stmt::Call* stmt) { return Result(); }
+    Result visitIf(Stmt::If* stmt) { return Result(); }
+    Result visitWhile(Stmt::While* stmt) { return Result(); }
+    Result visitBlock(Stmt::Block* stmt) { return Result(); }
+
+    Result visitBinary(Expr::Binary* expr) { return Result(); }
+    Result visitCall(Expr::Call* expr) { return Result(); }
+    Result visitGrouping(Expr::Grouping* expr) { return Result(); }
+    Result visitIdentifier(Expr::Identifier* expr) { return Result(); }
+    Result visitLiteral(Expr::Literal* expr) { return Result(); }
+    Result visitUnary(Expr::Unary* expr) { return Result(); }
+
+private:
+    Derived* derived() { return static_cast<Derived*>(this); }
+};
@@ -0,0 +1,590 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Expression.h"
+#include "../Statement.h"
+#include "../Method.h"
+#include "../Program.h"
+#include "../Visitor.h"
+#include "../../OutputSink.h"
+#include "../../../interpreter/Resolver.h"
+#include "../../../interpreter/TypeChecker.h"
+
+/**
+ * Translates a program to C99 that behaves like the interpreter: integers wrap around, `/` divides reals, arrays
+ * are passed and assigned by value, indices and divisors are checked, the call depth is limited the same way and
+ * runtime errors are reported in the same words. Operands are evaluated left to right where a call could tell the
+ * difference (C leaves that order open).
+ *
+ * Globals become static variables, methods static functions (the result of a function is the local result_).
+ * Every array length (per element type) is a struct holding the elements, so that C copies it like Pascal does;
+ * element i of an array declared [start..stop] is e[i - start], arrays of the same length with other bounds are
+ * the same C type. All names get a prefix, v_ for variables and f_ for methods, so they cannot clash with C
+ * keywords or the C library.
+ *
+ * The types come from the TypeChecker, mismatches throw a SemanticException like names the Resolver cannot find.
+ */
+class AST2C : public ASTVisitor<AST2C> {
+public:
+    static const int MAX_CALL_DEPTH = 10000;
+
+    AST2C(OutputSink* sink) : out{sink}, sink{*sink} {}
+
+    AST2C(const AST2C&) = delete;
+    AST2C& operator=(const AST2C&) = delete;
+
+    /* --------------- Program ----------------- */
+    void visitProgram(Program* prog) {
+        Resolver resolver(prog);
+        TypeChecker types(prog, resolver);
+        this->prog = prog;
+        this->resolver = &resolver;
+
+        sink << "/* " << prog->identifier.text() << ", translated from Mini-Pascal */\n\n" << INCLUDES
+             << "\n#define MAX_CALL_DEPTH_ " << static_cast<unsigned int>(MAX_CALL_DEPTH) << "\n" << PRELUDE;
+
+        // every array type once, before anything uses it
+        for (const auto& declVar : prog->declarations) {
+            arrayType(*declVar->type);
+        }
+        for (const auto& meth : prog->methods) {
+            for (const auto& argVar : meth->arguments) {
+                arrayType(*argVar->type);
+            }
+            for (const auto& declVar : meth->declarations) {
+                arrayType(*declVar->type);
+            }
+        }
+        if (!arrayTypes.empty()) {
+            sink << "\n";
+        }
+
+        for (const auto& declVar : prog->declarations) {
+            sink << "static " << declaration(*declVar->type, variableName(declVar)) << ";\n";
+        }
+        sink << "\n";
+
+        for (const auto& meth : prog->methods) {
+            prototype(meth);
+            sink << ";\n";
+        }
+        sink << "\n";
+
+        for (size_t i = 0; i < prog->methods.size(); i++) {
+            method = i;
+            visit(prog->methods[i]);
+        }
+
+        method = prog->methods.size();
+        function("int main(void)", "", "", prog->main, "    return 0;\n");
+
+        this->resolver = NULL;
+    }
+
+
+    /* --------------- Methods ----------------- */
+    void visitMethod(Method* meth) {
+        std::string locals;
+        for (const auto& declVar : meth->declarations) {
+            locals += "    " + declaration(*declVar->type, variableName(declVar)) + " = " + zero(*declVar->type) + ";\n";
+        }
+        if (meth->returnType != NULL) {
+            locals += "    " + declaration(*meth->returnType, "result_") + " = 0;\n";
+        }
+
+        prototype(meth);
+        function("", locals, "    depth_++;\n", meth->block, meth->returnType != NULL ? "    depth_--;\n    return result_;\n" : "    depth_--;\n");
+    }
+
+
+    /* --------------- Statements ----------------- */
+    void visitAssignment(Stmt::Assignment* stmt) {
+        const Variable::VariableType* type = resolver->typeOf(stmt->slot, method);
+        int line = stmt->identifier.lineNumber;
+        indent();
+
+        if (stmt->arrayIndex != NULL) {
+            // the index is checked before the value is computed
+            if (Expr::hasCall(stmt->value)) {
+                std::string index = temporary("int64_t");
+                *out << index << " = ";
+                checkedIndex(*type, stmt->arrayIndex, line);
+                *out << "; ";
+                *out << variable(stmt->slot) << ".e[" << index << "] = ";
+            } else {
+                *out << variable(stmt->slot) << ".e[";
+                checkedIndex(*type, stmt->arrayIndex, line);
+                *out << "] = ";
+            }
+        } else {
+            *out << variable(stmt->slot) << " = ";
+        }
+
+        visit(stmt->value);
+        *out << ";\n";
+    }
+
+    void visitCall(Stmt::Call* stmt) {
+        if (!stmt->target.builtin) {
+            indent();
+            call(stmt->target.index, stmt->arguments, stmt->callee.lineNumber);
+            *out << ";\n";
+            return;
+        }
+
+        for (const auto& argExpr : stmt->arguments) {
+            indent();
+            write(argExpr);
+            *out << ";\n";
+        }
+        if (stmt->target.index == WRITELN) {
+            indent();
+            *out << "putchar('\\n');\n";
+        }
+    }
+
+    void visitIf(Stmt::If* stmt) {
+        indent();
+        *out << "if (";
+        visit(stmt->condition);
+        *out << ") ";
+        body(stmt->thenBody);
+
+        if (stmt->elseBody != NULL) {
+            indent();
+            *out << "else ";
+            body(stmt->elseBody);
+        }
+    }
+
+    void visitWhile(Stmt::While* stmt) {
+        indent();
+        *out << "while (";
+        visit(stmt->condition);
+        *out << ") ";
+        body(stmt->body);
+    }
+
+    void visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) {
+            visit(stmtInside);
+        }
+    }
+
+
+    /* --------------- Expressions ---------------- */
+    void visitBinary(Expr::Binary* expr) {
+        TokenType op = expr->op.type;
+
+        if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+            *out << "(";
+            visit(expr->left);
+            *out << (op == TokenType::OP_AND ? " && " : " || ");
+            visit(expr->right);
+            *out << ")";
+            return;
+        }
+
+        // the left operand is computed first when the right one calls a method (which might change it)
+        std::string first;
+        if (Expr::hasCall(expr->right) && expr->left->kind != Expr::Kind::LITERAL) {
+            first = temporary(cType(expr->left->type));
+            *out << "(" << first << " = ";
+            visit(expr->left);
+            *out << ", ";
+        }
+        auto leftOperand = [&]() {
+            if (first.empty()) {
+                visit(expr->left);
+            } else {
+                *out << first;
+            }
+        };
+
+        // integer arithmetic goes through the wrapping macros, everything else is plain C
+        bool integers = expr->operandType == ValueType::INTEGER;
+        const char* function = NULL;
+        const char* infix = NULL;
+        switch (op) {
+            case TokenType::OP_ADD:           function = "ADD_"; infix = " + "; break;
+            case TokenType::OP_SUB:           function = "SUB_"; infix = " - "; break;
+            case TokenType::OP_MUL:           function = "MUL_"; infix = " * "; break;
+            case TokenType::OP_EQUALS:        infix = " == "; break;
+            case TokenType::OP_NOT_EQUALS:    infix = " != "; break;
+            case TokenType::OP_LESS:          infix = " < "; break;
+            case TokenType::OP_LESS_EQUAL:    infix = " <= "; break;
+            case TokenType::OP_GREATER:       infix = " > "; break;
+            case TokenType::OP_GREATER_EQUAL: infix = " >= "; break;
+            case TokenType::OP_INTEGER_DIV:   function = "div_"; break;
+            default: // OP_DIV, on reals even for two integers
+                *out << "((double)";
+                leftOperand();
+                *out << " / (double)";
+                visit(expr->right);
+                *out << ")";
+                break;
+        }
+
+        if (function != NULL && (integers || op == TokenType::OP_INTEGER_DIV)) {
+            *out << function << "(";
+            leftOperand();
+            *out << ", ";
+            visit(expr->right);
+            if (op == TokenType::OP_INTEGER_DIV) {
+                *out << ", " << static_cast<unsigned int>(expr->op.lineNumber);
+            }
+            *out << ")";
+        } else if (infix != NULL) {
+            *out << "(";
+            leftOperand();
+            *out << infix;
+            visit(expr->right);
+            *out << ")";
+        }
+
+        if (!first.empty()) {
+            *out << ")";
+        }
+    }
+
+    void visitCall(Expr::Call* expr) {
+        call(expr->target.index, expr->arguments, expr->callee.lineNumber);
+    }
+
+    void visitGrouping(Expr::Grouping* expr) {
+        visit(expr->expression);
+    }
+
+    void visitIdentifier(Expr::Identifier* expr) {
+        if (expr->arrayIndexExpression == NULL) {
+            *out << variable(expr->slot);
+            return;
+        }
+
+        *out << variable(expr->slot) << ".e[";
+        checkedIndex(*resolver->typeOf(expr->slot, method), expr->arrayIndexExpression, expr->token.lineNumber);
+        *out << "]";
+    }
+
+    void visitLiteral(Expr::Literal* expr) {
+        const Value& value = resolver->constants[expr->constant];
+
+        switch (value.type) {
+            case ValueType::INTEGER:
+                // INT64_MIN has no literal in C (only a folded literal can be it, see ConstantFolder)
+                if (value.integer == INT64_MIN) {
+                    *out << "INT64_MIN";
+                } else {
+                    *out << "INT64_C(" << static_cast<long>(value.integer) << ")";
+                }
+                break;
+            case ValueType::REAL: {
+                char digits[32];
+                snprintf(digits, sizeof(digits), "%.17g", value.real);
+                *out << digits;
+                if (std::string_view(digits).find_first_of(".en") == std::string_view::npos) {
+                    *out << ".0";
+                }
+            } break;
+            default:
+                *out << (value.boolean ? "1" : "0");
+                break;
+        }
+    }
+
+    void visitUnary(Expr::Unary* expr) {
+        if (expr->op.type == TokenType::OP_NOT) {
+            *out << "(!";
+        } else if (expr->type == ValueType::INTEGER) {
+            *out << "NEG_(";
+        } else {
+            *out << "(-";
+        }
+
+        visit(expr->right);
+        *out << ")";
+    }
+
+private:
+    OutputSink* out;       // where the code goes, the body of the function being translated while there is one
+    OutputSink& sink;      // the output
+
+    Program* prog = NULL;
+    Resolver* resolver = NULL;
+    size_t method;         // index of the method being translated, methods.size() for the main block
+
+    int depth = 1;         // indentation
+    std::vector<std::pair<std::string, std::string>> temporaries;  // C type and name, of the function being translated
+
+    // struct name of every array type, by element type and length
+    std::map<std::pair<ValueType, uint64_t>, std::string> arrayTypes;
+
+    static constexpr const char* INCLUDES =
+        "#include <inttypes.h>\n"
+        "#include <stdint.h>\n"
+        "#include <stdio.h>\n"
+        "#include <stdlib.h>\n";
+
+    static constexpr const char* PRELUDE =
+        "\n"
+        "/* integers wrap around like in the interpreter, signed overflow would be undefined */\n"
+        "#define ADD_(a, b) ((int64_t)((uint64_t)(a) + (uint64_t)(b)))\n"
+        "#define SUB_(a, b) ((int64_t)((uint64_t)(a) - (uint64_t)(b)))\n"
+        "#define MUL_(a, b) ((int64_t)((uint64_t)(a) * (uint64_t)(b)))\n"
+        "#define NEG_(a) ((int64_t)(0 - (uint64_t)(a)))\n"
+        "\n"
+        "static int depth_;\n"
+        "\n"
+        "static void error_(const char* what, int line) {\n"
+        "    fflush(stdout);\n"
+        "    fprintf(stderr, \"Runtime error: %s on line %d!\\n\", what, line);\n"
+        "    exit(255);\n"
+        "}\n"
+        "\n"
+        "static inline int64_t div_(int64_t a, int64_t b, int line) {\n"
+        "    if (b == 0) {\n"
+        "        error_(\"Division by zero\", line);\n"
+        "    }\n"
+        "    return b == -1 ? NEG_(a) : a / b;\n"
+        "}\n"
+        "\n"
+        "static inline int64_t index_(int64_t i, int64_t start, uint64_t length, int line) {\n"
+        "    if ((uint64_t)i - (uint64_t)start >= length) {\n"
+        "        char what[64];\n"
+        "        snprintf(what, sizeof(what), \"Array index %\" PRId64 \" out of bounds\", i);\n"
+        "        error_(what, line);\n"
+        "    }\n"
+        "    return (int64_t)((uint64_t)i - (uint64_t)start);\n"
+        "}\n"
+        "\n"
+        "static inline void enter_(int line) {\n"
+        "    if (depth_ >= MAX_CALL_DEPTH_) {\n"
+        "        error_(\"Stack overflow\", line);\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "static inline void write_integer_(int64_t value) { printf(\"%\" PRId64, value); }\n"
+        "static inline void write_real_(double value) { printf(\"%g\", value); }\n"
+        "static inline void write_boolean_(int value) { fputs(value ? \"true\" : \"false\", stdout); }\n"
+        "\n";
+
+    /* --------------- Functions ----------------- */
+
+    void prototype(Method* meth) {
+        *out << "static " << (meth->returnType != NULL ? cType(elementType(*meth->returnType)) : "void") << " "
+             << methodName(meth) << "(";
+
+        if (meth->arguments.empty()) {
+            *out << "void";
+        }
+        for (size_t i = 0; i < meth->arguments.size(); i++) {
+            *out << (i > 0 ? ", " : "") << declaration(*meth->arguments[i]->type, variableName(meth->arguments[i]));
+        }
+        *out << ")";
+    }
+
+    /* the body goes to memory first, the temporaries it needs are only known at its end */
+    void function(std::string_view header, const std::string& locals, std::string_view prologue, Stmt::Statement* block,
+                  std::string_view footer) {
+        OutputSink body;
+        out = &body;
+        temporaries.clear();
+        visit(block);
+        out = &sink;
+
+        sink << header << " {\n" << locals;
+        for (const auto& temp : temporaries) {
+            sink << "    " << temp.first << " " << temp.second << ";\n";
+        }
+        sink << prologue << body.result() << footer << "}\n\n";
+    }
+
+    void body(Stmt::Statement* stmt) {
+        *out << "{\n";
+        depth++;
+        visit(stmt);
+        depth--;
+        indent();
+        *out << "}\n";
+    }
+
+    void indent() {
+        for (int i = 0; i < depth; i++) {
+            *out << "    ";
+        }
+    }
+
+    /* a new local of the function being translated */
+    std::string temporary(const std::string& type) {
+        std::string name = "t" + std::to_string(temporaries.size() + 1) + "_";
+        temporaries.emplace_back(type, name);
+        return name;
+    }
+
+    static std::string cType(ValueType type) {
+        switch (type) {
+            case ValueType::REAL:    return "double";
+            case ValueType::BOOLEAN: return "int";
+            default:                 return "int64_t";
+        }
+    }
+
+    /* --------------- Calls and output ----------------- */
+
+    /* (enter_(line), [tN = argument, ...] f_name(arguments)): the depth is checked before the arguments are computed */
+    void call(uint32_t target, const ArenaVector<Expr::Expression*>& arguments, int line) {
+        Method* callee = prog->methods[target];
+
+        // arguments followed by a call are computed into temporaries first, to keep them in order
+        size_t lastCall = 0;
+        for (size_t i = 0; i < arguments.size(); i++) {
+            if (Expr::hasCall(arguments[i])) {
+                lastCall = i;
+            }
+        }
+
+        std::vector<std::string> computed(arguments.size());
+        *out << "(enter_(" << static_cast<unsigned int>(line) << "), ";
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const Variable::VariableType& type = *callee->arguments[i]->type;
+            if (i < lastCall && arguments[i]->kind != Expr::Kind::LITERAL) {
+                computed[i] = temporary(cType(type));
+                *out << computed[i] << " = ";
+                visit(arguments[i]);
+                *out << ", ";
+            }
+        }
+
+        *out << methodName(callee) << "(";
+        for (size_t i = 0; i < arguments.size(); i++) {
+            *out << (i > 0 ? ", " : "");
+            if (computed[i].empty()) {
+                visit(arguments[i]);
+            } else {
+                *out << computed[i];
+            }
+        }
+        *out << "))";
+    }
+
+    void write(Expr::Expression* expr) {
+        if (expr->kind == Expr::Kind::LITERAL) {
+            const Value& value = resolver->constants[static_cast<Expr::Literal*>(expr)->constant];
+            if (value.type == ValueType::STRING) {
+                *out << "fputs(";
+                string(*value.string);
+                *out << ", stdout)";
+                return;
+            }
+        }
+
+        switch (expr->type) {
+            case ValueType::REAL:    *out << "write_real_("; break;
+            case ValueType::BOOLEAN: *out << "write_boolean_("; break;
+            default:                 *out << "write_integer_("; break;
+        }
+        visit(expr);
+        *out << ")";
+    }
+
+    /* a C string literal */
+    void string(std::string_view text) {
+        *out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                *out << '\\' << c;
+            } else if (c < ' ' || c > '~') {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\%03o", static_cast<unsigned char>(c));
+                *out << escaped;
+            } else {
+                *out << c;
+            }
+        }
+        *out << '"';
+    }
+
+    /* --------------- Variables ----------------- */
+
+    std::string variableName(Variable* var) {
+        return "v_" + std::string(var->name.text());
+    }
+
+    std::string methodName(Method* meth) {
+        return "f_" + std::string(meth->identifier.text());
+    }
+
+    /* C name of the variable in a slot (of the method being translated) */
+    std::string variable(VariableSlot slot) {
+        if (slot.global) {
+            return variableName(prog->declarations[slot.index]);
+        }
+
+        Method* meth = prog->methods[method];
+        if (slot.index < meth->arguments.size()) {
+            return variableName(meth->arguments[slot.index]);
+        }
+        if (slot.index - meth->arguments.size() < meth->declarations.size()) {
+            return variableName(meth->declarations[slot.index - meth->arguments.size()]);
+        }
+        return "result_";
+    }
+
+    /* index_(index, start, length, line) */
+    void checkedIndex(const Variable::VariableType& type, Expr::Expression* index, int line) {
+        const Variable::VariableTypeArray& arrayType = static_cast<const Variable::VariableTypeArray&>(type);
+        int64_t start = Resolver::integer(arrayType.startRange);
+        int64_t stop = Resolver::integer(arrayType.stopRange);
+
+        *out << "index_(";
+        visit(index);
+        *out << ", INT64_C(" << static_cast<long>(start) << "), " << static_cast<unsigned long>(stop >= start ? stop - start + 1 : 0)
+             << "u, " << static_cast<unsigned int>(line) << ")";
+    }
+
+    /* --------------- Types ----------------- */
+
+    /* the struct of an array type (of its length, the bounds only matter to indexes), declared on first use */
+    std::string arrayType(const Variable::VariableType& type) {
+        if (type.kind != Variable::VariableType::Kind::ARRAY) {
+            return "";
+        }
+
+        const Variable::VariableTypeArray& arrayType = static_cast<const Variable::VariableTypeArray&>(type);
+        ValueType element = elementType(type);
+        int64_t start = Resolver::integer(arrayType.startRange);
+        int64_t stop = Resolver::integer(arrayType.stopRange);
+        uint64_t length = stop >= start ? stop - start + 1 : 0;
+
+        auto key = std::make_pair(element, length);
+        auto found = arrayTypes.find(key);
+        if (found != arrayTypes.end()) {
+            return found->second;
+        }
+
+        std::string name = "array_" + std::string(typeName(element)) + "_" + std::to_string(length);
+        arrayTypes.emplace(key, name);
+
+        // C has no empty arrays
+        sink << "typedef struct { " << cType(element) << " e[" << static_cast<unsigned long>(length > 0 ? length : 1) << "]; } " << name << ";\n";
+        return name;
+    }
+
+    std::string cType(const Variable::VariableType& type) {
+        return type.kind == Variable::VariableType::Kind::ARRAY ? arrayType(type) : cType(elementType(type));
+    }
+
+    std::string declaration(const Variable::VariableType& type, const std::string& name) {
+        return cType(type) + " " + name;
+    }
+
+    static const char* zero(const Variable::VariableType& type) {
+        return type.kind == Variable::VariableType::Kind::ARRAY ? "{{0}}" : "0";
+    }
+};
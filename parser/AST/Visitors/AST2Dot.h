@@ -1,241 +1,221 @@
-
 #pragma once
 
-#include <iostream>
 #include <string>
-#include <sstream>
-#include <list>
-#include <map>
 
 #include "../Expression.h"
 #include "../Statement.h"
 #include "../Method.h"
 #include "../Program.h"
+#include "../Visitor.h"
+#include "../../OutputSink.h"
 
 /**
- * Transforms an AST to a textual representation (similar to LISP), that allows seeing the precendence.
+ * Transforms an AST to a .dot file, to render it as a graph with GraphViz.
+ *
+ * Node ids are numbered in traversal order: every visitX() takes the next number for its node, writes the
+ * node, visits the children and then writes the edges to the ids they returned. No table of nodes is kept and
+ * the text goes to an OutputSink while walking the tree, so the memory needed does not grow with the program.
  */
-class AST2Dot : public Expr::Visitor, public Stmt::Visitor, public Method::Visitor, public Program::Visitor {
+class AST2Dot : public ASTVisitor<AST2Dot, unsigned long> {
 private:
-    std::stringstream ss; // holds the result
-    std::map<void*, std::string> nodeNames; // holds unique names for each node
-    unsigned int counter = 0;
-
-    /**
-     * Gets unique name of a node.
-     */
-    std::string getNodeName(void* expOrStmt) {
-        if (nodeNames.count(expOrStmt)) {
-            return nodeNames.find(expOrStmt)->second;
-        }
+    OutputSink* ownSink; // only set when collecting in memory
+    OutputSink& out;
+    unsigned long nextId = 0;
 
-        nodeNames.insert(std::pair<void*, std::string>(expOrStmt, std::to_string(counter++)));
-        return nodeNames.find(expOrStmt)->second;
+    void edge(unsigned long from, unsigned long to) {
+        out << from << " -> " << to << ";\n";
     }
 
 
 public:
+    /* collects the graph for getResult() */
+    AST2Dot() : ownSink{new OutputSink()}, out{*ownSink} {}
+    /* streams the graph to the sink */
+    AST2Dot(OutputSink* sink) : ownSink{NULL}, out{*sink} {}
+
+    ~AST2Dot() { delete ownSink; }
+
+    AST2Dot(const AST2Dot&) = delete;
+    AST2Dot& operator=(const AST2Dot&) = delete;
+
+    /* a graph of its own for a single method or the main block (see DotClusters) */
+    template <typename Node>
+    void digraph(Node* node) {
+        out << "digraph G {\n\n";
+        visit(node);
+        out << "}\n";
+    }
 
     /* --------------- Program ----------------- */
-    void visitProgram(Program* prog) {
-        ss << "digraph G {\n\n";
-
-        // declarations(prog->declarations);
+    unsigned long visitProgram(Program* prog) {
+        out << "digraph G {\n\n";
 
         // methods
         for (const auto& meth : prog->methods) {
-            meth->accept(this);
+            visit(meth);
         }
 
-        prog->main->accept(this);
+        visit(prog->main);
 
-        ss << "}\n";
+        out << "}\n";
+        return nextId;
     };
 
 
     /* --------------- Methods ----------------- */
-    void visitMethod(Method* meth) {
-        auto methNodeName = getNodeName(meth);
+    unsigned long visitMethod(Method* meth) {
+        unsigned long id = nextId++;
 
-        ss << "subgraph cluster" << getNodeName(meth) << "{\n";
-        ss << "label = \"" << meth->identifier.lexeme << "(";
+        out << "subgraph cluster" << id << "{\n";
+        out << "label = \"" << meth->identifier.text() << "(";
 
         for (const auto& argVar : meth->arguments) {
-            ss << argVar->name.lexeme << ": ";
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(argVar->type)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(argVar->type)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
-            ss << ", ";
+            out << argVar->name.text() << ": ";
+            printType(out, *argVar->type) << ", ";
         }
-        ss << ")";
+        out << ")";
 
         if (meth->returnType != NULL) {
-            ss << ": ";
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(meth->returnType)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(meth->returnType)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
+            out << ": ";
+            printType(out, *meth->returnType);
         }
-        
-        ss << "\";\n";
 
-        meth->block->accept(this);
+        out << "\";\n";
+
+        visit(meth->block);
 
-        ss << "}\n\n";
+        out << "}\n\n";
+        return id;
     };
 
     /* --------------- Statements ----------------- */
-    void visitAssignment(Stmt::Assignment* stmt) {
-        auto stmtNodeName = getNodeName(stmt);
-        auto valueNodeName = getNodeName(stmt->value);
+    unsigned long visitAssignment(Stmt::Assignment* stmt) {
+        unsigned long id = nextId++;
 
-        ss << "\n";
-        ss << stmtNodeName << " [label = \"" << stmt->identifier.lexeme << " = \"];\n";
+        out << "\n";
+        out << id << " [label = \"" << stmt->identifier.text() << " = \"];\n";
 
         // array index expression
         if (stmt->arrayIndex != NULL) {
-            auto arrayIndexNodeName = getNodeName(stmt->arrayIndex);
-
-            ss << stmtNodeName << " -> " << arrayIndexNodeName  << ";\n";
-
-            stmt->arrayIndex->accept(this);
+            edge(id, visit(stmt->arrayIndex));
         }
 
-        ss << stmtNodeName << " -> " << valueNodeName << ";\n\n";
-
-        stmt->value->accept(this);
+        edge(id, visit(stmt->value));
+        out << "\n";
+        return id;
     };
 
-    void visitCall(Stmt::Call* stmt) {
-        auto stmtNodeName = getNodeName(stmt);
-        
-        ss << "\n";
-        ss << stmtNodeName << " [label = \"call " << stmt->callee.lexeme << "\"];\n";
-        
+    unsigned long visitCall(Stmt::Call* stmt) {
+        unsigned long id = nextId++;
+
+        out << "\n";
+        out << id << " [label = \"call " << stmt->callee.text() << "\"];\n";
+
         for (const auto& argExpr : stmt->arguments) {
-            auto argExprNodeName = getNodeName(argExpr);
-            ss << stmtNodeName << " -> " << argExprNodeName << ";\n";
-            argExpr->accept(this);
+            edge(id, visit(argExpr));
         }
+        return id;
     };
 
-    void visitIf(Stmt::If* stmt) {
-        auto stmtNodeName = getNodeName(stmt);
-        auto conditionNodeName = getNodeName(stmt->condition);
-        auto thenNodeName = getNodeName(stmt->thenBody);
-
+    unsigned long visitIf(Stmt::If* stmt) {
+        unsigned long id = nextId++;
 
-        ss << "\n";
-        ss << stmtNodeName << " [label = \"if\", fillcolor=lightpink, style=filled];\n";
-        ss << stmtNodeName << " -> " << conditionNodeName << ";\n";
-        ss << stmtNodeName << " -> " << thenNodeName << ";\n";
+        out << "\n";
+        out << id << " [label = \"if\", fillcolor=lightpink, style=filled];\n";
 
-        stmt->condition->accept(this);
-        stmt->thenBody->accept(this);
+        edge(id, visit(stmt->condition));
+        edge(id, visit(stmt->thenBody));
 
         if (stmt->elseBody != NULL) {
-            auto elseNodeName = getNodeName(stmt->elseBody);
-            ss << stmtNodeName << " -> " << elseNodeName << ";\n";
-
-            stmt->elseBody->accept(this);
+            edge(id, visit(stmt->elseBody));
         }
+        return id;
     };
 
-    void visitWhile(Stmt::While* stmt) {
-        auto stmtNodeName = getNodeName(stmt);
-        auto conditionNodeName = getNodeName(stmt->condition);
-        auto bodyNodeName = getNodeName(stmt->body);
-
-        ss << "\n";
-        ss << stmtNodeName << " [label = \"while\", fillcolor=lightpink, style=filled];\n";
-        ss << stmtNodeName << " -> " << conditionNodeName << ";\n";
-        ss << stmtNodeName << " -> " << bodyNodeName << ";\n";
-         
-        stmt->condition->accept(this);
-        stmt->body->accept(this);
+    unsigned long visitWhile(Stmt::While* stmt) {
+        unsigned long id = nextId++;
+
+        out << "\n";
+        out << id << " [label = \"while\", fillcolor=lightpink, style=filled];\n";
+
+        edge(id, visit(stmt->condition));
+        edge(id, visit(stmt->body));
+        return id;
     };
 
-    void visitBlock(Stmt::Block* stmt) {
-        auto blockNodeName = getNodeName(stmt);
+    unsigned long visitBlock(Stmt::Block* stmt) {
+        unsigned long id = nextId++;
 
-        ss << "\n" << blockNodeName << " [label = \"block\"];\n";
+        out << "\n" << id << " [label = \"block\"];\n";
 
         for (auto const& stmtInside : stmt->statements) {
-            auto stmtInsideNodeName = getNodeName(stmtInside);
-
-            ss << blockNodeName << " -> " << stmtInsideNodeName << ";\n";
-            stmtInside->accept(this);
+            edge(id, visit(stmtInside));
         }
-
+        return id;
     };
 
 
     /* --------------- Expressions ---------------- */
-    void visitBinary(Expr::Binary* expr) {
-        auto exprNodeName = getNodeName(expr);
-        auto leftNodeName = getNodeName(expr->left);
-        auto rightNodeName = getNodeName(expr->right);
-
-        ss << "\n";
-        ss << exprNodeName << " [label = \"" << expr->op.lexeme << "\", fillcolor=gray, style=filled];\n";
-        ss << exprNodeName << " -> " << leftNodeName << ";\n";
-        ss << exprNodeName << " -> " << rightNodeName << ";\n\n";
-
-        expr->left->accept(this);
-        expr->right->accept(this);
+    unsigned long visitBinary(Expr::Binary* expr) {
+        unsigned long id = nextId++;
+
+        out << "\n";
+        out << id << " [label = \"" << expr->op.text() << "\", fillcolor=gray, style=filled];\n";
+
+        edge(id, visit(expr->left));
+        edge(id, visit(expr->right));
+        out << "\n";
+        return id;
     };
 
-    void visitCall(Expr::Call* expr) {
-        auto exprNodeName = getNodeName(expr);
-        
-        ss << "\n";
-        ss << exprNodeName << " [label = \"call " << expr->callee.lexeme << "\"];\n";
-        
+    unsigned long visitCall(Expr::Call* expr) {
+        unsigned long id = nextId++;
+
+        out << "\n";
+        out << id << " [label = \"call " << expr->callee.text() << "\"];\n";
+
         for (const auto& argExpr : expr->arguments) {
-            auto argExprNodeName = getNodeName(argExpr);
-            ss << exprNodeName << " -> " << argExprNodeName << ";\n";
-            argExpr->accept(this);
+            edge(id, visit(argExpr));
         }
+        return id;
     };
 
-    void visitGrouping(Expr::Grouping* expr) {
-        auto exprNodeName = getNodeName(expr);
-        auto innerNodeName = getNodeName(expr->expression);
+    unsigned long visitGrouping(Expr::Grouping* expr) {
+        unsigned long id = nextId++;
 
-        ss << "\n";
-        ss << exprNodeName << " [label = \"( )\", fillcolor=gray, style=filled];\n";
-        ss << exprNodeName << " -> " << innerNodeName << ";\n";
+        out << "\n";
+        out << id << " [label = \"( )\", fillcolor=gray, style=filled];\n";
 
-        expr->expression->accept(this); 
+        edge(id, visit(expr->expression));
+        return id;
     };
 
-    void visitIdentifier(Expr::Identifier* expr) {
-        auto exprNodeName = getNodeName(expr);
-        
-        ss << "\n" << exprNodeName << " [label = \"" << expr->token.lexeme << "\", fillcolor=darkseagreen1, style=filled];\n";
+    unsigned long visitIdentifier(Expr::Identifier* expr) {
+        unsigned long id = nextId++;
+
+        out << "\n" << id << " [label = \"" << expr->token.text() << "\", fillcolor=darkseagreen1, style=filled];\n";
+        return id;
     };
 
-    void visitLiteral(Expr::Literal* expr) {
-        auto exprNodeName = getNodeName(expr);
+    unsigned long visitLiteral(Expr::Literal* expr) {
+        unsigned long id = nextId++;
 
-        ss << "\n" << exprNodeName << " [label = \"" << expr->token.lexeme << "\", fillcolor=lightblue, style=filled];\n";
+        out << "\n" << id << " [label = \"" << expr->token.text() << "\", fillcolor=lightblue, style=filled];\n";
+        return id;
     };
 
-    void visitUnary(Expr::Unary* expr) {
-        auto exprNodeName = getNodeName(expr);
-        auto rightNodeName = getNodeName(expr->right);
+    unsigned long visitUnary(Expr::Unary* expr) {
+        unsigned long id = nextId++;
 
-        ss << "\n";
-        ss << exprNodeName << " [label = \"" << expr->op.lexeme << "\", fillcolor=gray, style=filled];\n";
-        ss << exprNodeName << " -> " << rightNodeName << ";\n\n";
+        out << "\n";
+        out << id << " [label = \"" << expr->op.text() << "\", fillcolor=gray, style=filled];\n";
 
-        expr->right->accept(this);
+        edge(id, visit(expr->right));
+        out << "\n";
+        return id;
     };
 
-    std::string getResult() {
-        return ss.str();
+    const std::string& getResult() {
+        return ownSink->result();
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../Expression.h"
+#include "../Statement.h"
+#include "../Method.h"
+#include "../Program.h"
+#include "../Visitor.h"
+#include "../FlatAST.h"
+
+/**
+ * Converts an AST into a FlatAST. Every node is appended before its children (pre-order) and closed after
+ * them. The flat AST refers to the symbols of the program, so the program has to outlive it.
+ */
+class AST2Flat : public ASTVisitor<AST2Flat> {
+private:
+    FlatAST* flat;
+
+    Flat::NodeIndex open(Flat::NodeKind kind, const Token& token, uint8_t flags = 0) {
+        return flat->open(kind, token.type, token.symbol, token.lineNumber, flags);
+    }
+
+    void variable(Flat::NodeKind kind, Variable* var) {
+        Flat::NodeIndex node = open(kind, var->name);
+        type(var->type);
+        flat->close(node);
+    }
+
+    void type(Variable::VariableType* type) {
+        if (type->kind == Variable::VariableType::Kind::ARRAY) {
+            Variable::VariableTypeArray* arrayType = static_cast<Variable::VariableTypeArray*>(type);
+
+            Flat::NodeIndex node = open(Flat::ARRAY_TYPE, arrayType->typeName);
+            flat->close(open(Flat::LITERAL, arrayType->startRange));
+            flat->close(open(Flat::LITERAL, arrayType->stopRange));
+            flat->close(node);
+        } else {
+            flat->close(open(Flat::SIMPLE_TYPE, type->typeName));
+        }
+    }
+
+    void arguments(ArenaVector<Expression*>& arguments) {
+        for (const auto& argument : arguments) {
+            visit(argument);
+        }
+    }
+
+public:
+    /* converts the program, the result is owned by the caller */
+    FlatAST* convert(Program* prog) {
+        flat = new FlatAST(prog->symbols);
+        visit(prog);
+        flat->shrink();
+
+        return flat;
+    }
+
+    /* --------------- Program ----------------- */
+    void visitProgram(Program* prog) {
+        Flat::NodeIndex node = open(Flat::PROGRAM, prog->identifier);
+
+        for (const auto& declaration : prog->declarations) {
+            variable(Flat::VARIABLE, declaration);
+        }
+        for (const auto& meth : prog->methods) {
+            visit(meth);
+        }
+        visit(prog->main);
+
+        flat->close(node);
+    }
+
+    /* --------------- Methods ----------------- */
+    void visitMethod(Method* meth) {
+        Flat::NodeIndex node = open(Flat::METHOD, meth->identifier, meth->returnType != NULL ? Flat::HAS_RETURN_TYPE : 0);
+
+        for (const auto& argument : meth->arguments) {
+            variable(Flat::PARAMETER, argument);
+        }
+        for (const auto& declaration : meth->declarations) {
+            variable(Flat::VARIABLE, declaration);
+        }
+        if (meth->returnType != NULL) {
+            type(meth->returnType);
+        }
+        visit(meth->block);
+
+        flat->close(node);
+    }
+
+    /* --------------- Statements ----------------- */
+    void visitAssignment(Stmt::Assignment* stmt) {
+        Flat::NodeIndex node = open(Flat::ASSIGNMENT, stmt->identifier, stmt->arrayIndex != NULL ? Flat::HAS_ARRAY_INDEX : 0);
+
+        if (stmt->arrayIndex != NULL) {
+            visit(stmt->arrayIndex);
+        }
+        visit(stmt->value);
+
+        flat->close(node);
+    }
+
+    void visitCall(Stmt::Call* stmt) {
+        Flat::NodeIndex node = open(Flat::CALL_STATEMENT, stmt->callee);
+        arguments(stmt->arguments);
+        flat->close(node);
+    }
+
+    void visitIf(Stmt::If* stmt) {
+        Flat::NodeIndex node = flat->open(Flat::IF);
+        flat->flags[node] = stmt->elseBody != NULL ? Flat::HAS_ELSE : 0;
+
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+
+        flat->close(node);
+    }
+
+    void visitWhile(Stmt::While* stmt) {
+        Flat::NodeIndex node = flat->open(Flat::WHILE);
+
+        visit(stmt->condition);
+        visit(stmt->body);
+
+        flat->close(node);
+    }
+
+    void visitBlock(Stmt::Block* stmt) {
+        Flat::NodeIndex node = flat->open(Flat::BLOCK);
+
+        for (const auto& statement : stmt->statements) {
+            visit(statement);
+        }
+
+        flat->close(node);
+    }
+
+    /* --------------- Expressions ---------------- */
+    void visitBinary(Expr::Binary* expr) {
+        Flat::NodeIndex node = open(Flat::BINARY, expr->op);
+
+        visit(expr->left);
+        visit(expr->right);
+
+        flat->close(node);
+    }
+
+    void visitCall(Expr::Call* expr) {
+        Flat::NodeIndex node = open(Flat::CALL, expr->callee);
+        arguments(expr->arguments);
+        flat->close(node);
+    }
+
+    void visitGrouping(Expr::Grouping* expr) {
+        Flat::NodeIndex node = flat->open(Flat::GROUPING);
+        visit(expr->expression);
+        flat->close(node);
+    }
+
+    void visitIdentifier(Expr::Identifier* expr) {
+        Flat::NodeIndex node = open(Flat::IDENTIFIER, expr->token, expr->arrayIndexExpression != NULL ? Flat::HAS_ARRAY_INDEX : 0);
+
+        if (expr->arrayIndexExpression != NULL) {
+            visit(expr->arrayIndexExpression);
+        }
+
+        flat->close(node);
+    }
+
+    void visitLiteral(Expr::Literal* expr) {
+        flat->close(open(Flat::LITERAL, expr->token));
+    }
+
+    void visitUnary(Expr::Unary* expr) {
+        Flat::NodeIndex node = open(Flat::UNARY, expr->op);
+        visit(expr->right);
+        flat->close(node);
+    }
+};
@@ -1,185 +1,177 @@
 
 #pragma once
 
-#include <iostream>
 #include <string>
-#include <sstream>
-#include <list>
 
 #include "../Expression.h"
 #include "../Statement.h"
 #include "../Method.h"
 #include "../Program.h"
+#include "../Visitor.h"
+#include "../../OutputSink.h"
 
 /**
  * Transforms an AST to a textual representation (similar to LISP), that allows seeing the precendence.
+ *
+ * The text is written to an OutputSink while walking the tree, nothing is allocated per node. Given a sink on
+ * a file descriptor it streams, otherwise it collects the text for getResult().
  */
-class AST2Text : public Expr::Visitor, public Stmt::Visitor, public Method::Visitor, public Program::Visitor {
+class AST2Text : public ASTVisitor<AST2Text> {
 private:
-    std::stringstream ss; // holds the result
+    OutputSink* ownSink; // only set when collecting in memory
+    OutputSink& out;
 
-    // helper function to paranthesize expressions (LISP like)
-    void parenthesize(std::string name, const std::list<Expr::Expression*>& expressions) {
-        ss << "(" << name;
+    // helper functions to paranthesize expressions (LISP like)
+    void parenthesize(std::string_view name, std::initializer_list<Expr::Expression*> expressions) {
+        out << "(" << name;
 
         for (auto const& exp : expressions) {
-            ss << " ";
-            exp->accept(this);
+            out << " ";
+            visit(exp);
         }
 
-        ss << ")";
+        out << ")";
     }
 
-    // helper function to print declarations (for <program> and <function>/<procedure>)
-    void declarations(std::vector<Variable*>& declarations) {
-        ss << " (defs ";
+    void parenthesize(std::string_view name, const ArenaVector<Expr::Expression*>& expressions) {
+        out << "(" << name;
 
-        for (const auto& declVar : declarations) {
-            ss << " (" << declVar->name.lexeme << ": ";
+        for (auto const& exp : expressions) {
+            out << " ";
+            visit(exp);
+        }
+
+        out << ")";
+    }
+
+    // helper function to print a declared variable or argument with its type
+    void variable(Variable* var) {
+        out << " (" << var->name.text() << ": ";
+        printType(out, *var->type) << ")";
+    }
 
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(declVar->type)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(declVar->type)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
+    // helper function to print declarations (for <program> and <function>/<procedure>)
+    void declarations(ArenaVector<Variable*>& declarations) {
+        out << " (defs ";
 
-            ss << ")";
+        for (const auto& declVar : declarations) {
+            variable(declVar);
         }
 
-        ss << ")\n";
+        out << ")\n";
     }
 
 
 public:
+    /* collects the text for getResult() */
+    AST2Text() : ownSink{new OutputSink()}, out{*ownSink} {}
+    /* streams the text to the sink */
+    AST2Text(OutputSink* sink) : ownSink{NULL}, out{*sink} {}
+
+    ~AST2Text() { delete ownSink; }
+
+    AST2Text(const AST2Text&) = delete;
+    AST2Text& operator=(const AST2Text&) = delete;
 
     /* --------------- Program ----------------- */
     void visitProgram(Program* prog) {
-        ss << "(program " << prog->identifier.lexeme;
+        out << "(program " << prog->identifier.text();
 
         declarations(prog->declarations);
 
         // methods
         for (const auto& meth : prog->methods) {
-            meth->accept(this);
-            ss << "\n\n";
+            visit(meth);
+            out << "\n\n";
         }
 
-        ss << "(main\n";
-        prog->main->accept(this);
-        ss << ")";
+        out << "(main\n";
+        visit(prog->main);
+        out << ")";
     };
 
 
     /* --------------- Methods ----------------- */
     void visitMethod(Method* meth) {
-        ss << "(method " << meth->identifier.lexeme << " (args";
+        out << "(method " << meth->identifier.text() << " (args";
 
         for (const auto& argVar : meth->arguments) {
-            ss << " (" << argVar->name.lexeme << ": ";
-
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(argVar->type)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(argVar->type)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
-            
-            ss << ")";
+            variable(argVar);
         }
-        ss << ")";
+        out << ")";
 
-        ss << " (defs";
+        out << " (defs";
         for (const auto& declVar : meth->declarations) {
-            ss << " (" << declVar->name.lexeme << ": ";
-
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(declVar->type)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(declVar->type)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
-
-            ss << ")";
+            variable(declVar);
         }
 
-        ss << ")";
+        out << ")";
         
         if (meth->returnType != NULL) {
-            ss << " (returns ";
-            if (Variable::VariableTypeSimple* simpleVar = dynamic_cast<Variable::VariableTypeSimple*>(meth->returnType)) {
-                ss << simpleVar->typeName.lexeme;
-            } else if (Variable::VariableTypeArray* arrayVar = dynamic_cast<Variable::VariableTypeArray*>(meth->returnType)) {
-                ss << arrayVar->typeName.lexeme << "[" << arrayVar->startRange.lexeme << ".." << arrayVar->stopRange.lexeme << "]";
-            }
-            ss << ")";
+            out << " (returns ";
+            printType(out, *meth->returnType) << ")";
         }
-        ss << "\n";
+        out << "\n";
 
-        meth->block->accept(this);
+        visit(meth->block);
     };
 
     /* --------------- Statements ----------------- */
     void visitAssignment(Stmt::Assignment* stmt) {
-        ss << "(assign " << stmt->identifier.lexeme;
+        out << "(assign " << stmt->identifier.text();
         if (stmt->arrayIndex != NULL) {
-            ss << "[";
-            stmt->arrayIndex->accept(this);
-            ss << "]";
+            out << "[";
+            visit(stmt->arrayIndex);
+            out << "]";
         }
-        ss << " := ";
-        stmt->value->accept(this);
-        ss << ")";
+        out << " := ";
+        visit(stmt->value);
+        out << ")";
     };
 
     void visitCall(Stmt::Call* stmt) {
-         // convert the vector to list
-        std::list<Expr::Expression*> exprList;
-        std::copy(stmt->arguments.begin(), stmt->arguments.end(), std::back_inserter(exprList));
-
-        parenthesize(stmt->callee.lexeme, exprList);
+        parenthesize(stmt->callee.text(), stmt->arguments);
     };
 
     void visitIf(Stmt::If* stmt) {
-        ss << "(if ";
-        stmt->condition->accept(this);
-        ss << " (then ";
-        stmt->thenBody->accept(this);
-        ss << ")";
+        out << "(if ";
+        visit(stmt->condition);
+        out << " (then ";
+        visit(stmt->thenBody);
+        out << ")";
 
         if (stmt->elseBody != NULL) {
-            ss << " (else ";
-            stmt->elseBody->accept(this);
-            ss << ")";
+            out << " (else ";
+            visit(stmt->elseBody);
+            out << ")";
         }
-        ss << ")";
+        out << ")";
     };
 
     void visitWhile(Stmt::While* stmt) {
-        ss << "(while ";
-        stmt->condition->accept(this);
-        ss << " (do ";
-        stmt->body->accept(this);
-        ss << "))";
+        out << "(while ";
+        visit(stmt->condition);
+        out << " (do ";
+        visit(stmt->body);
+        out << "))";
     };
 
     void visitBlock(Stmt::Block* stmt) {
-        ss << "(";
+        out << "(";
         for (auto const& stmtInside : stmt->statements) {
-            stmtInside->accept(this);
+            visit(stmtInside);
         }
-        ss << ")";
+        out << ")";
     };
 
 
     /* --------------- Expressions ---------------- */
     void visitBinary(Expr::Binary* expr) {
-        parenthesize(expr->op.lexeme, {expr->left, expr->right});
+        parenthesize(expr->op.text(), {expr->left, expr->right});
     };
 
     void visitCall(Expr::Call* expr) {
-        // convert the vector to list
-        std::list<Expr::Expression*> exprList;
-        std::copy(expr->arguments.begin(), expr->arguments.end(), std::back_inserter(exprList));
-
-        parenthesize(expr->callee.lexeme, exprList);
+        parenthesize(expr->callee.text(), expr->arguments);
     };
 
     void visitGrouping(Expr::Grouping* expr) {
@@ -187,24 +179,25 @@ public:
     };
 
     void visitIdentifier(Expr::Identifier* expr) {
-        ss << expr->token.lexeme;
+        out << expr->token.text();
 
         if (expr->arrayIndexExpression != NULL) {
-            ss << "[";
-            expr->arrayIndexExpression->accept(this);
-            ss << "]";
+            out << "[";
+            visit(expr->arrayIndexExpression);
+            out << "]";
         }
     };
 
     void visitLiteral(Expr::Literal* expr) {
-        ss << expr->token.lexeme;
+        out << expr->token.text();
     };
 
     void visitUnary(Expr::Unary* expr) {
-        parenthesize(expr->op.lexeme, {expr->right});
+        parenthesize(expr->op.text(), {expr->right});
     };
 
+    /* the collected text (only for an AST2Text without a sink of its own) */
     std::string getResult() {
-        return ss.str();
+        return ownSink->result();
     }
 };
\ No newline at end of file
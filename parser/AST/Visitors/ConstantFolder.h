@@ -0,0 +1,467 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <charconv>
+#include <string>
+#include <unordered_map>
+
+#include "../Expression.h"
+#include "../Statement.h"
+#include "../Method.h"
+#include "../Program.h"
+#include "../Visitor.h"
+#include "../../../interpreter/Value.h"
+
+/**
+ * Rewrites the expressions of a program in place, before anything resolves, prints or runs it:
+ *
+ *  - Binary and Unary nodes whose operands are literals become a Literal of their value (2 * 3 + 1 is 7),
+ *  - Grouping nodes disappear, the tree already encodes the precedence the brackets stood for,
+ *  - x * 1, 1 * x, x + 0, 0 + x, x - 0, x div 1, not not x and - - x become x.
+ *
+ * Nothing is folded that would behave differently at run time: integers wrap around like in the Interpreter,
+ * `div` by zero, operands of the wrong type and reals that are not finite are left for the engines to report.
+ * The identities only apply when the declared types of x prove them exact (x + 0 changes -0.0 to 0.0, so it is
+ * only dropped for integers), and never where they would hide a type error. New literals are allocated in the
+ * arena of the program, their texts are interned like those of the parser.
+ */
+class ConstantFolder : public ASTVisitor<ConstantFolder, Expr::Expression*> {
+public:
+    size_t folded = 0;     // Binary/Unary nodes replaced by a literal
+    size_t simplified = 0; // identities applied
+    size_t groupings = 0;  // Grouping nodes removed
+
+    ConstantFolder(Program* prog) : prog{prog} {}
+
+    void fold() { visit(prog); }
+
+    Expr::Expression* visitProgram(Program* prog) {
+        for (const auto& var : prog->declarations) {
+            globals.emplace(var->name.symbol, var->type);
+        }
+        for (const auto& meth : prog->methods) {
+            methods.emplace(meth->identifier.symbol, meth);
+        }
+
+        for (const auto& meth : prog->methods) {
+            visit(meth);
+        }
+
+        locals.clear();
+        visit(prog->main);
+        return NULL;
+    }
+
+    Expr::Expression* visitMethod(Method* meth) {
+        locals.clear();
+        for (const auto& var : meth->arguments) {
+            locals.emplace(var->name.symbol, var->type);
+        }
+        for (const auto& var : meth->declarations) {
+            locals.emplace(var->name.symbol, var->type);
+        }
+        if (meth->returnType != NULL) {
+            locals.emplace(meth->identifier.symbol, meth->returnType);
+        }
+
+        visit(meth->block);
+        return NULL;
+    }
+
+    /* --------------- Statements ----------------- */
+    Expr::Expression* visitAssignment(Stmt::Assignment* stmt) {
+        if (stmt->arrayIndex != NULL) {
+            stmt->arrayIndex = visit(stmt->arrayIndex);
+        }
+        stmt->value = visit(stmt->value);
+        return NULL;
+    }
+
+    Expr::Expression* visitCall(Stmt::Call* stmt) {
+        for (auto& argument : stmt->arguments) {
+            argument = visit(argument);
+        }
+        return NULL;
+    }
+
+    Expr::Expression* visitIf(Stmt::If* stmt) {
+        stmt->condition = visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+        return NULL;
+    }
+
+    Expr::Expression* visitWhile(Stmt::While* stmt) {
+        stmt->condition = visit(stmt->condition);
+        visit(stmt->body);
+        return NULL;
+    }
+
+    Expr::Expression* visitBlock(Stmt::Block* stmt) {
+        for (const auto& statement : stmt->statements) {
+            visit(statement);
+        }
+        return NULL;
+    }
+
+    /* --------------- Expressions (each returns what replaces it) ----------------- */
+    Expr::Expression* visitBinary(Expr::Binary* expr) {
+        expr->left = visit(expr->left);
+        expr->right = visit(expr->right);
+
+        Value left, right, result;
+        if (constant(expr->left, left) && constant(expr->right, right) && evaluate(left, expr->op.type, right, result)) {
+            folded++;
+            return literal(result, expr);
+        }
+
+        ValueType leftType, rightType;
+        bool leftTyped = typeOf(expr->left, leftType), rightTyped = typeOf(expr->right, rightType);
+
+        switch (expr->op.type) {
+            case TokenType::OP_MUL:
+                if (isOne(expr->right, leftTyped, leftType)) return simplify(expr->left);
+                if (isOne(expr->left, rightTyped, rightType) && sameLine(expr->left, expr->right)) return simplify(expr->right);
+                break;
+            case TokenType::OP_ADD:
+                if (isZero(expr->right) && leftTyped && leftType == ValueType::INTEGER) return simplify(expr->left);
+                if (isZero(expr->left) && rightTyped && rightType == ValueType::INTEGER && sameLine(expr->left, expr->right)) {
+                    return simplify(expr->right);
+                }
+                break;
+            case TokenType::OP_SUB:
+                if (isZero(expr->right) && leftTyped && isNumber(leftType)) return simplify(expr->left);
+                break;
+            case TokenType::OP_INTEGER_DIV:
+                if (isOne(expr->right, leftTyped, leftType) && leftType == ValueType::INTEGER) return simplify(expr->left);
+                break;
+            default:
+                break;
+        }
+        return expr;
+    }
+
+    Expr::Expression* visitCall(Expr::Call* expr) {
+        for (auto& argument : expr->arguments) {
+            argument = visit(argument);
+        }
+        return expr;
+    }
+
+    Expr::Expression* visitGrouping(Expr::Grouping* expr) {
+        groupings++;
+        return visit(expr->expression);
+    }
+
+    Expr::Expression* visitIdentifier(Expr::Identifier* expr) {
+        if (expr->arrayIndexExpression != NULL) {
+            expr->arrayIndexExpression = visit(expr->arrayIndexExpression);
+        }
+        return expr;
+    }
+
+    Expr::Expression* visitLiteral(Expr::Literal* expr) {
+        return expr;
+    }
+
+    Expr::Expression* visitUnary(Expr::Unary* expr) {
+        expr->right = visit(expr->right);
+
+        Value right;
+        if (constant(expr->right, right)) {
+            if (expr->op.type == TokenType::OP_NOT && right.type == ValueType::BOOLEAN) {
+                folded++;
+                return literal(Value::ofBoolean(!right.boolean), expr);
+            }
+            if (expr->op.type == TokenType::OP_SUB && right.type == ValueType::INTEGER) {
+                folded++;
+                return literal(Value::ofInteger(-static_cast<uint64_t>(right.integer)), expr);
+            }
+            if (expr->op.type == TokenType::OP_SUB && right.type == ValueType::REAL) {
+                folded++;
+                return literal(Value::ofReal(-right.real), expr);
+            }
+            return expr;
+        }
+
+        // not not b, - - x (negating twice is exact, even for the wrapping INT64_MIN)
+        if (expr->right->kind == Expr::Kind::UNARY) {
+            Expr::Unary* inner = static_cast<Expr::Unary*>(expr->right);
+            ValueType type;
+
+            if (inner->op.type == expr->op.type && typeOf(inner->right, type) && sameLine(expr, inner->right) &&
+                (expr->op.type == TokenType::OP_NOT ? type == ValueType::BOOLEAN : isNumber(type))) {
+                return simplify(inner->right);
+            }
+        }
+        return expr;
+    }
+
+private:
+    Program* prog;
+
+    std::unordered_map<Symbol, const Variable::VariableType*> globals;
+    std::unordered_map<Symbol, const Variable::VariableType*> locals;  // of the method being folded
+    std::unordered_map<Symbol, const Method*> methods;
+
+    Expr::Expression* simplify(Expr::Expression* expr) {
+        simplified++;
+        return expr;
+    }
+
+    static bool isNumber(ValueType type) { return type == ValueType::INTEGER || type == ValueType::REAL; }
+
+    /* the value of a literal other than a string; false for those and for integers out of range */
+    static bool constant(Expr::Expression* expr, Value& value) {
+        if (expr->kind != Expr::Kind::LITERAL) {
+            return false;
+        }
+
+        const Token& token = static_cast<Expr::Literal*>(expr)->token;
+        std::string_view text = token.text();
+
+        switch (token.type) {
+            case TokenType::LITERAL_INTEGER: {
+                int64_t integer;
+                auto result = std::from_chars(text.data(), text.data() + text.size(), integer);
+                value = Value::ofInteger(integer);
+                return result.ec == std::errc();
+            }
+            case TokenType::LITERAL_REAL: {
+                double real = strtod(std::string(text).c_str(), NULL);
+                value = Value::ofReal(real);
+                return isfinite(real);
+            }
+            case TokenType::LITERAL_TRUE:  value = Value::ofBoolean(true); return true;
+            case TokenType::LITERAL_FALSE: value = Value::ofBoolean(false); return true;
+            default:                       return false;
+        }
+    }
+
+    /* x op right is x for a literal 1 (an integer one for any number, a real one only for reals) */
+    static bool isOne(Expr::Expression* expr, bool xTyped, ValueType xType) {
+        Value value;
+        if (!xTyped || !isNumber(xType) || !constant(expr, value)) {
+            return false;
+        }
+        return value.type == ValueType::INTEGER ? value.integer == 1 : value.type == ValueType::REAL && xType == ValueType::REAL && value.real == 1.0;
+    }
+
+    static bool isZero(Expr::Expression* expr) {
+        Value value;
+        return constant(expr, value) && value.type == ValueType::INTEGER && value.integer == 0;
+    }
+
+    /* errors about a whole expression name the line of its first token, which must not move */
+    static bool sameLine(Expr::Expression* before, Expr::Expression* after) {
+        return Expr::lineOf(before) == Expr::lineOf(after);
+    }
+
+    /* left op right like the Interpreter computes it, false where it would fail (or the result is no literal) */
+    static bool evaluate(Value left, TokenType op, Value right, Value& result) {
+        if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+            if (left.type != ValueType::BOOLEAN || right.type != ValueType::BOOLEAN) {
+                return false;
+            }
+            result = Value::ofBoolean(op == TokenType::OP_AND ? left.boolean && right.boolean : left.boolean || right.boolean);
+            return true;
+        }
+
+        if (left.type == ValueType::INTEGER && right.type == ValueType::INTEGER) {
+            uint64_t l = left.integer, r = right.integer; // wraps around instead of overflowing
+
+            switch (op) {
+                case TokenType::OP_ADD: result = Value::ofInteger(l + r); return true;
+                case TokenType::OP_SUB: result = Value::ofInteger(l - r); return true;
+                case TokenType::OP_MUL: result = Value::ofInteger(l * r); return true;
+                case TokenType::OP_DIV: result = Value::ofReal(static_cast<double>(left.integer) / right.integer); return isfinite(result.real);
+                case TokenType::OP_INTEGER_DIV:
+                    if (right.integer == 0) {
+                        return false; // a runtime error on its line
+                    }
+                    result = Value::ofInteger(right.integer == -1 ? -l : left.integer / right.integer);
+                    return true;
+                default:
+                    return compare(left.integer, op, right.integer, result);
+            }
+        }
+
+        if (isNumber(left.type) && isNumber(right.type)) {
+            double l = left.type == ValueType::REAL ? left.real : left.integer;
+            double r = right.type == ValueType::REAL ? right.real : right.integer;
+
+            switch (op) {
+                case TokenType::OP_ADD: result = Value::ofReal(l + r); break;
+                case TokenType::OP_SUB: result = Value::ofReal(l - r); break;
+                case TokenType::OP_MUL: result = Value::ofReal(l * r); break;
+                case TokenType::OP_DIV: result = Value::ofReal(l / r); break;
+                case TokenType::OP_INTEGER_DIV: return false;
+                default: return compare(l, op, r, result);
+            }
+            return isfinite(result.real);
+        }
+
+        // false < true
+        if (left.type == ValueType::BOOLEAN && right.type == ValueType::BOOLEAN) {
+            return compare(left.boolean, op, right.boolean, result);
+        }
+        return false;
+    }
+
+    template <typename T>
+    static bool compare(T left, TokenType op, T right, Value& result) {
+        switch (op) {
+            case TokenType::OP_EQUALS:        result = Value::ofBoolean(left == right); return true;
+            case TokenType::OP_NOT_EQUALS:    result = Value::ofBoolean(left != right); return true;
+            case TokenType::OP_LESS:          result = Value::ofBoolean(left < right); return true;
+            case TokenType::OP_LESS_EQUAL:    result = Value::ofBoolean(left <= right); return true;
+            case TokenType::OP_GREATER:       result = Value::ofBoolean(left > right); return true;
+            case TokenType::OP_GREATER_EQUAL: result = Value::ofBoolean(left >= right); return true;
+            default:                          return false;
+        }
+    }
+
+    /* the static type of an expression, false where it is unknown or wrong (which the engines report) */
+    bool typeOf(Expr::Expression* expr, ValueType& type) const {
+        switch (expr->kind) {
+            case Expr::Kind::LITERAL: {
+                Value value;
+                if (!constant(expr, value)) {
+                    return false;
+                }
+                type = value.type;
+                return true;
+            }
+            case Expr::Kind::IDENTIFIER: {
+                Expr::Identifier* identifier = static_cast<Expr::Identifier*>(expr);
+                const Variable::VariableType* declared = variable(identifier->token.symbol);
+                if (declared == NULL) {
+                    return false;
+                }
+
+                bool array = declared->kind == Variable::VariableType::Kind::ARRAY;
+                if (array != (identifier->arrayIndexExpression != NULL)) {
+                    return false;
+                }
+                type = elementType(*declared);
+                return true;
+            }
+            case Expr::Kind::CALL: {
+                auto method = methods.find(static_cast<Expr::Call*>(expr)->callee.symbol);
+                if (method == methods.end() || method->second->returnType == NULL ||
+                    method->second->returnType->kind != Variable::VariableType::Kind::SIMPLE) {
+                    return false;
+                }
+                type = elementType(*method->second->returnType);
+                return true;
+            }
+            case Expr::Kind::GROUPING:
+                return typeOf(static_cast<Expr::Grouping*>(expr)->expression, type);
+            case Expr::Kind::UNARY: {
+                Expr::Unary* unary = static_cast<Expr::Unary*>(expr);
+                if (!typeOf(unary->right, type)) {
+                    return false;
+                }
+                return unary->op.type == TokenType::OP_NOT ? type == ValueType::BOOLEAN : isNumber(type);
+            }
+            case Expr::Kind::BINARY: {
+                Expr::Binary* binary = static_cast<Expr::Binary*>(expr);
+                ValueType left, right;
+                if (!typeOf(binary->left, left) || !typeOf(binary->right, right)) {
+                    return false;
+                }
+                return binaryType(left, binary->op.type, right, type);
+            }
+        }
+        return false;
+    }
+
+    static bool binaryType(ValueType left, TokenType op, ValueType right, ValueType& type) {
+        bool numbers = isNumber(left) && isNumber(right);
+
+        switch (op) {
+            case TokenType::OP_AND:
+            case TokenType::OP_OR:
+                type = ValueType::BOOLEAN;
+                return left == ValueType::BOOLEAN && right == ValueType::BOOLEAN;
+            case TokenType::OP_INTEGER_DIV:
+                type = ValueType::INTEGER;
+                return left == ValueType::INTEGER && right == ValueType::INTEGER;
+            case TokenType::OP_DIV:
+                type = ValueType::REAL;
+                return numbers;
+            case TokenType::OP_ADD:
+            case TokenType::OP_SUB:
+            case TokenType::OP_MUL:
+                type = left == ValueType::INTEGER && right == ValueType::INTEGER ? ValueType::INTEGER : ValueType::REAL;
+                return numbers;
+            default:
+                type = ValueType::BOOLEAN;
+                return numbers || (left == ValueType::BOOLEAN && right == ValueType::BOOLEAN);
+        }
+    }
+
+    const Variable::VariableType* variable(Symbol name) const {
+        auto local = locals.find(name);
+        if (local != locals.end()) {
+            return local->second;
+        }
+        auto global = globals.find(name);
+        return global != globals.end() ? global->second : NULL;
+    }
+
+    /* the first token of an expression, whose line and offset a literal replacing it keeps */
+    static const Token& firstToken(Expr::Expression* expr) {
+        switch (expr->kind) {
+            case Expr::Kind::BINARY:     return firstToken(static_cast<Expr::Binary*>(expr)->left);
+            case Expr::Kind::CALL:       return static_cast<Expr::Call*>(expr)->callee;
+            case Expr::Kind::GROUPING:   return firstToken(static_cast<Expr::Grouping*>(expr)->expression);
+            case Expr::Kind::IDENTIFIER: return static_cast<Expr::Identifier*>(expr)->token;
+            case Expr::Kind::LITERAL:    return static_cast<Expr::Literal*>(expr)->token;
+            case Expr::Kind::UNARY:      return static_cast<Expr::Unary*>(expr)->op;
+        }
+        return static_cast<Expr::Literal*>(expr)->token;
+    }
+
+    /* a new literal node for the value of expr */
+    Expr::Literal* literal(Value value, Expr::Expression* expr) {
+        const Token& first = firstToken(expr);
+
+        if (value.type == ValueType::BOOLEAN) {
+            TokenType type = value.boolean ? TokenType::LITERAL_TRUE : TokenType::LITERAL_FALSE;
+            return prog->arena->make<Expr::Literal>(Token(type, TOKEN_SPELLINGS[type], first.lineNumber, first.offset));
+        }
+
+        std::string text;
+        TokenType type = TokenType::LITERAL_INTEGER;
+        if (value.type == ValueType::INTEGER) {
+            text = std::to_string(value.integer);
+        } else {
+            type = TokenType::LITERAL_REAL;
+            text = realText(value.real);
+        }
+
+        Symbol symbol = prog->symbols->intern(text);
+        return prog->arena->make<Expr::Literal>(Token(type, prog->symbols->text(symbol), first.lineNumber, first.offset, symbol));
+    }
+
+    /* the shortest of %.15g/%.17g that reads back as the same real, always with a point so it looks like one */
+    static std::string realText(double real) {
+        char digits[32];
+        snprintf(digits, sizeof(digits), "%.15g", real);
+        if (strtod(digits, NULL) != real) {
+            snprintf(digits, sizeof(digits), "%.17g", real);
+        }
+
+        std::string text = digits;
+        if (text.find_first_of(".e") == std::string::npos) {
+            text += ".0";
+        }
+        return text;
+    }
+};
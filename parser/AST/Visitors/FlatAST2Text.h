@@ -0,0 +1,185 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+#include "../FlatAST.h"
+
+/**
+ * AST2Text for a FlatAST, producing exactly the same text. Walks the node arrays by index: children are
+ * reached through firstChild()/nextSibling() and dispatched on their kind.
+ */
+class FlatAST2Text {
+private:
+    const FlatAST* flat;
+    std::stringstream ss; // holds the result
+
+    // helper function to paranthesize the children of a node (LISP like)
+    void parenthesize(std::string_view name, Flat::NodeIndex node) {
+        ss << "(" << name;
+
+        for (Flat::NodeIndex child = flat->firstChild(node); child < flat->end(node); child = flat->nextSibling(child)) {
+            ss << " ";
+            visit(child);
+        }
+
+        ss << ")";
+    }
+
+    // helper function to print a variable or parameter with its type
+    void variable(Flat::NodeIndex node) {
+        ss << " (" << flat->text(node) << ": ";
+        type(flat->firstChild(node));
+        ss << ")";
+    }
+
+    void type(Flat::NodeIndex node) {
+        ss << flat->text(node);
+
+        if (flat->kinds[node] == Flat::ARRAY_TYPE) {
+            Flat::NodeIndex start = flat->firstChild(node);
+            ss << "[" << flat->text(start) << ".." << flat->text(flat->nextSibling(start)) << "]";
+        }
+    }
+
+    void program(Flat::NodeIndex node) {
+        ss << "(program " << flat->text(node);
+
+        Flat::NodeIndex child = flat->firstChild(node);
+
+        ss << " (defs ";
+        for (; flat->kinds[child] == Flat::VARIABLE; child = flat->nextSibling(child)) {
+            variable(child);
+        }
+        ss << ")\n";
+
+        for (; flat->kinds[child] == Flat::METHOD; child = flat->nextSibling(child)) {
+            method(child);
+            ss << "\n\n";
+        }
+
+        ss << "(main\n";
+        visit(child);
+        ss << ")";
+    }
+
+    void method(Flat::NodeIndex node) {
+        ss << "(method " << flat->text(node) << " (args";
+
+        Flat::NodeIndex child = flat->firstChild(node);
+        for (; flat->kinds[child] == Flat::PARAMETER; child = flat->nextSibling(child)) {
+            variable(child);
+        }
+        ss << ")";
+
+        ss << " (defs";
+        for (; flat->kinds[child] == Flat::VARIABLE; child = flat->nextSibling(child)) {
+            variable(child);
+        }
+        ss << ")";
+
+        if (flat->has(node, Flat::HAS_RETURN_TYPE)) {
+            ss << " (returns ";
+            type(child);
+            ss << ")";
+            child = flat->nextSibling(child);
+        }
+        ss << "\n";
+
+        visit(child);
+    }
+
+    void visit(Flat::NodeIndex node) {
+        Flat::NodeIndex child = flat->firstChild(node);
+
+        switch (flat->kinds[node]) {
+            /* --------------- Statements ----------------- */
+            case Flat::ASSIGNMENT:
+                ss << "(assign " << flat->text(node);
+                if (flat->has(node, Flat::HAS_ARRAY_INDEX)) {
+                    ss << "[";
+                    visit(child);
+                    ss << "]";
+                    child = flat->nextSibling(child);
+                }
+                ss << " := ";
+                visit(child);
+                ss << ")";
+                break;
+
+            case Flat::CALL_STATEMENT:
+            case Flat::CALL:
+                parenthesize(flat->text(node), node);
+                break;
+
+            case Flat::IF:
+                ss << "(if ";
+                visit(child);
+                child = flat->nextSibling(child);
+                ss << " (then ";
+                visit(child);
+                ss << ")";
+
+                if (flat->has(node, Flat::HAS_ELSE)) {
+                    ss << " (else ";
+                    visit(flat->nextSibling(child));
+                    ss << ")";
+                }
+                ss << ")";
+                break;
+
+            case Flat::WHILE:
+                ss << "(while ";
+                visit(child);
+                ss << " (do ";
+                visit(flat->nextSibling(child));
+                ss << "))";
+                break;
+
+            case Flat::BLOCK:
+                ss << "(";
+                for (; child < flat->end(node); child = flat->nextSibling(child)) {
+                    visit(child);
+                }
+                ss << ")";
+                break;
+
+            /* --------------- Expressions ---------------- */
+            case Flat::BINARY:
+            case Flat::UNARY:
+                parenthesize(flat->text(node), node);
+                break;
+
+            case Flat::GROUPING:
+                parenthesize("group", node);
+                break;
+
+            case Flat::IDENTIFIER:
+                ss << flat->text(node);
+
+                if (flat->has(node, Flat::HAS_ARRAY_INDEX)) {
+                    ss << "[";
+                    visit(child);
+                    ss << "]";
+                }
+                break;
+
+            case Flat::LITERAL:
+                ss << flat->text(node);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+public:
+    FlatAST2Text(const FlatAST* flat) : flat{flat} {}
+
+    /* prints the whole program */
+    std::string getResult() {
+        ss.str("");
+        program(flat->root());
+        return ss.str();
+    }
+};
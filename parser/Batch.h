@@ -0,0 +1,197 @@
+#pragma once
+
+#include <errno.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "Parser.h"
+#include "ThreadPool.h"
+
+/**
+ * Parses many files in one process (pascal-parser --batch). Directories are searched recursively for .pas
+ * files, all inputs are sorted and spread over a work stealing thread pool.
+ *
+ * Without an output directory the AST2Text results are written to stdout in the sorted input order, each
+ * preceded by a "==> file <==" line. With an output directory every input gets its own file
+ * <outputDirectory>/<input path>.ast instead; an input outside the working directory (its path still starts
+ * with ".." once normalized) is written under its absolute path there, like absolute inputs are.
+ */
+class Batch {
+public:
+    Batch(std::string outputDirectory, unsigned int threadCount, LexerKind lexerKind = LexerKind::FLEX)
+        : outputDirectory{outputDirectory}, pool{threadCount}, lexerKind{lexerKind}
+    {}
+
+    /*
+     * adds a single file or all .pas files below a directory; a directory that cannot be read (or searched to
+     * the end) is an input that fails, like a file that cannot be opened
+     */
+    void add(const std::string& path) {
+        std::error_code error;
+        if (std::filesystem::is_directory(path, error)) {
+            addDirectory(path);
+        } else {
+            inputs.push_back(path);
+        }
+    }
+
+    /* parses all inputs, returns the number of inputs that could not be parsed */
+    size_t run() {
+        std::sort(inputs.begin(), inputs.end());
+
+        results.assign(inputs.size(), std::string());
+        finished.assign(inputs.size(), false);
+        nextToWrite = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        pool.forEach(inputs.size(), [this](size_t i) { parse(i); });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printStatistics(seconds);
+
+        return failedFiles;
+    }
+
+private:
+    std::string outputDirectory;
+    ThreadPool pool;
+    LexerKind lexerKind;
+
+    std::vector<std::string> inputs;
+    std::map<std::string, std::string> unreadable; // directories that are inputs, with the reason
+
+    // results that are waiting for all previous inputs to be written (stdout mode only), the mutex guards the
+    // messages about files that cannot be written in the other mode as well
+    std::mutex outputMutex;
+    std::vector<std::string> results;
+    std::vector<bool> finished;
+    size_t nextToWrite;
+
+    std::atomic<size_t> totalBytes{0};
+    std::atomic<size_t> totalTokens{0};
+    std::atomic<size_t> failedFiles{0};
+
+    void parse(size_t index) {
+        const std::string& path = inputs[index];
+        std::string result;
+        bool failed = false;
+
+        auto directory = unreadable.find(path);
+        SourceFile* source = directory == unreadable.end() ? SourceFile::map(path.c_str()) : NULL;
+        if (directory != unreadable.end()) {
+            result = "Cannot read " + path + ": " + directory->second + "\n";
+            failed = true;
+        } else if (source == NULL) {
+            result = "Cannot open " + path + "\n";
+            failed = true;
+        } else {
+            totalBytes += source->size;
+            Parser p(source, lexerKind);
+            p.recovering = true;
+
+            Program* prog = p.program();
+            if (p.errors.empty()) {
+                AST2Text ast2text;
+                ast2text.visit(prog);
+                result = ast2text.getResult() + "\n";
+            } else {
+                // every error of the file, not just the first
+                for (const SyntaxException& ex : p.errors) {
+                    result += std::string("Syntax error: ") + ex.what() + "\n";
+                }
+                failed = true;
+            }
+            delete prog;
+
+            totalTokens += p.tokenCount;
+        }
+
+        if (outputDirectory.empty()) {
+            writeInOrder(index, std::move(result));
+        } else if (!writeFile(path, result)) {
+            failed = true;
+        }
+        if (failed) {
+            failedFiles++;
+        }
+    }
+
+    /* the .pas files below a directory, without following links to directories */
+    void addDirectory(const std::filesystem::path& directory) {
+        std::error_code error;
+        std::filesystem::directory_iterator entries(directory, error), end;
+        for (; !error && entries != end; entries.increment(error)) {
+            std::error_code ignored; // a dangling link is neither
+            if (entries->is_directory(ignored) && !entries->is_symlink(ignored)) {
+                addDirectory(entries->path());
+            } else if (entries->is_regular_file(ignored) && entries->path().extension() == ".pas") {
+                inputs.push_back(entries->path().string());
+            }
+        }
+        if (error) {
+            inputs.push_back(directory.string());
+            unreadable.emplace(directory.string(), error.message());
+        }
+    }
+
+    /* whoever completes the next input in line writes everything that is ready by now */
+    void writeInOrder(size_t index, std::string&& result) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+
+        results[index] = std::move(result);
+        finished[index] = true;
+
+        while (nextToWrite < inputs.size() && finished[nextToWrite]) {
+            std::cout << "==> " << inputs[nextToWrite] << " <==\n" << results[nextToWrite];
+            std::string().swap(results[nextToWrite]);
+            nextToWrite++;
+        }
+    }
+
+    /* false (with a message on stderr) if the file cannot be written, which fails the input but not the others */
+    bool writeFile(const std::string& inputPath, const std::string& result) {
+        std::error_code error;
+        std::filesystem::path input = std::filesystem::path(inputPath).lexically_normal();
+        if (input.is_relative() && input.begin() != input.end() && *input.begin() == "..") {
+            input = std::filesystem::absolute(input, error).lexically_normal(); // no ".." leads out of the output directory
+        }
+        std::filesystem::path outputPath = std::filesystem::path(outputDirectory) / input.relative_path();
+        outputPath += ".ast";
+
+        if (!error) {
+            std::filesystem::create_directories(outputPath.parent_path(), error);
+        }
+        if (!error) {
+            std::ofstream out(outputPath);
+            out << result;
+            out.close();
+            if (out) {
+                return true;
+            }
+            error.assign(errno, std::generic_category()); // why open (or writing) failed
+        }
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cerr << "Cannot write " << outputPath.string() << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    void printStatistics(double seconds) {
+        double megabytes = totalBytes / (1024.0 * 1024.0);
+
+        std::cerr << inputs.size() << " files (" << failedFiles << " failed), " << megabytes << " MB, "
+                  << totalTokens << " tokens in " << seconds << " s on " << pool.size() << " threads: "
+                  << inputs.size() / seconds << " files/s, " << megabytes / seconds << " MB/s, "
+                  << totalTokens / seconds << " tokens/s" << std::endl;
+    }
+};
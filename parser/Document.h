@@ -0,0 +1,521 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Parser.h"
+#include "AST/Visitor.h"
+
+/* moves every token of the nodes it visits the given number of lines down (or up) */
+class LineShifter : public ASTVisitor<LineShifter> {
+public:
+    LineShifter(int delta) : delta{delta} {}
+
+    void visitMethod(Method* meth) {
+        shift(meth->identifier);
+        variables(meth->arguments);
+        variables(meth->declarations);
+        if (meth->returnType != NULL) {
+            type(meth->returnType);
+        }
+        visit(meth->block);
+    }
+
+    void visitAssignment(Stmt::Assignment* stmt) {
+        shift(stmt->identifier);
+        if (stmt->arrayIndex != NULL) {
+            visit(stmt->arrayIndex);
+        }
+        visit(stmt->value);
+    }
+
+    void visitCall(Stmt::Call* stmt) {
+        shift(stmt->callee);
+        for (const auto& argExpr : stmt->arguments) {
+            visit(argExpr);
+        }
+    }
+
+    void visitIf(Stmt::If* stmt) {
+        visit(stmt->condition);
+        visit(stmt->thenBody);
+        if (stmt->elseBody != NULL) {
+            visit(stmt->elseBody);
+        }
+    }
+
+    void visitWhile(Stmt::While* stmt) {
+        visit(stmt->condition);
+        visit(stmt->body);
+    }
+
+    void visitBlock(Stmt::Block* stmt) {
+        for (const auto& stmtInside : stmt->statements) {
+            visit(stmtInside);
+        }
+    }
+
+    void visitBinary(Expr::Binary* expr) {
+        visit(expr->left);
+        shift(expr->op);
+        visit(expr->right);
+    }
+
+    void visitCall(Expr::Call* expr) {
+        shift(expr->callee);
+        for (const auto& argExpr : expr->arguments) {
+            visit(argExpr);
+        }
+    }
+
+    void visitGrouping(Expr::Grouping* expr) { visit(expr->expression); }
+
+    void visitIdentifier(Expr::Identifier* expr) {
+        shift(expr->token);
+        if (expr->arrayIndexExpression != NULL) {
+            visit(expr->arrayIndexExpression);
+        }
+    }
+
+    void visitLiteral(Expr::Literal* expr) { shift(expr->token); }
+
+    void visitUnary(Expr::Unary* expr) {
+        shift(expr->op);
+        visit(expr->right);
+    }
+
+private:
+    int delta;
+
+    void shift(Token& token) { token.lineNumber += delta; }
+
+    /* the variables of one declaration line share their type, which must only move once */
+    void variables(const ArenaVector<Variable*>& variables) {
+        const Variable::VariableType* last = NULL;
+        for (Variable* variable : variables) {
+            shift(variable->name);
+            if (variable->type != last) {
+                type(variable->type);
+                last = variable->type;
+            }
+        }
+    }
+
+    void type(Variable::VariableType* type) {
+        shift(type->typeName);
+        if (type->kind == Variable::VariableType::Kind::ARRAY) {
+            Variable::VariableTypeArray* arrayType = static_cast<Variable::VariableTypeArray*>(type);
+            shift(arrayType->startRange);
+            shift(arrayType->stopRange);
+        }
+    }
+};
+
+
+/**
+ * The text of a program being edited together with its parsed Program, which is kept up to date by reparsing
+ * only what an edit touched. The text is split into regions that each parse on their own: the header (program
+ * name and global declarations), one per method (from its first token up to the first token of the next one)
+ * and the main block. An edit within a single region relexes and reparses just that region into the arena of
+ * the program and splices the methods it yields (none, one or more) in place of the old one; all other Method
+ * subtrees are reused as they are. Everything else, an edit across regions or one that could change how the
+ * text around the region is scanned (an unclosed comment or string, a word growing into the next region), is
+ * parsed from scratch.
+ *
+ * Parses recover from syntax errors (see Parser::recovering), errors holds all of them, the same a full parse would
+ * report: the region stays marked as broken, edits to it keep being parsed incrementally until it parses again.
+ * Line numbers of the methods after an edit that added or removed lines are brought up to date by program().
+ * Replaced subtrees stay in the arena until so much was replaced that a full parse compacts it.
+ */
+class Document {
+public:
+    static const size_t NONE = SIZE_MAX;
+
+    Document(std::string text, LexerKind lexerKind = LexerKind::FLEX)
+        : buffer{std::move(text)}, gapStart{buffer.size()}, lexerKind{lexerKind}
+    {}
+
+    ~Document() {
+        delete prog;
+    }
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    /* parses the whole text, throws the SyntaxException of the first error (errors has all of them) */
+    void parse() {
+        delete prog;
+        prog = NULL;
+        starts.clear();
+        lines.clear();
+        builtLines.clear();
+        shifts.clear();
+        broken = NONE;
+        garbage = 0;
+        errors.clear();
+        fullParses++;
+
+        std::string_view content = text();
+        Parser parser(SourceFile::copy(content), lexerKind);
+        parser.recovering = true;
+        prog = parser.program();
+        if (!parser.errors.empty()) {
+            // what is left of a broken text is no program to edit incrementally
+            delete prog;
+            prog = NULL;
+            errors = std::move(parser.errors);
+            throw errors[0];
+        }
+
+        starts.push_back(0);
+        starts.insert(starts.end(), parser.methodOffsets.begin(), parser.methodOffsets.end());
+
+        // line of every region start, in one pass over the text
+        int line = 1;
+        size_t counted = 0;
+        for (unsigned int start : starts) {
+            line += std::count(content.begin() + counted, content.begin() + start, '\n');
+            counted = start;
+            lines.push_back(line);
+        }
+        builtLines = lines;
+        shifts.assign(starts.size(), 0);
+    }
+
+    /**
+     * replaces length bytes at offset by the inserted text and brings the program up to date, throws the
+     * SyntaxException of the first error (the text is edited nevertheless, errors has all of them)
+     */
+    void edit(size_t offset, size_t length, std::string_view inserted) {
+        if (offset > size() || length > size() - offset) {
+            throw std::out_of_range("Edit outside of the document");
+        }
+
+        size_t region = prog != NULL ? regionAt(offset) : NONE;
+        // compacts with a full parse once as much text was reparsed as there is, unless that could not succeed
+        bool local = region != NONE && offset + length <= end(region) &&
+                     (broken == NONE ? garbage <= size() : broken == region);
+
+        // the removed bytes join the gap, the inserted ones are copied to its start
+        moveGap(offset);
+        const char* removed = buffer.data() + gapStart + gapSize;
+        int addedLines = std::count(inserted.begin(), inserted.end(), '\n') - std::count(removed, removed + length, '\n');
+        gapSize += length;
+        if (gapSize < inserted.size()) {
+            size_t added = std::max(inserted.size(), buffer.size() / 8 + MIN_GAP);
+            buffer.insert(gapStart, added, '\0');
+            gapSize += added;
+        }
+        memcpy(&buffer[gapStart], inserted.data(), inserted.size());
+        gapStart += inserted.size();
+        gapSize -= inserted.size();
+
+        if (!local) {
+            parse();
+            return;
+        }
+
+        for (size_t r = region + 1; r < starts.size(); r++) {
+            starts[r] += inserted.size() - length;
+            lines[r] += addedLines;
+            shifts[r] += static_cast<int64_t>(inserted.size()) - static_cast<int64_t>(length);
+        }
+
+        if (!separate(region)) {
+            parse();
+            return;
+        }
+        reparse(region);
+    }
+
+    /* the parsed program, with the line numbers of all its tokens up to date; NULL after a full parse failed */
+    Program* program() {
+        for (size_t r = 1; prog != NULL && r < starts.size(); r++) {
+            if (lines[r] != builtLines[r]) {
+                LineShifter shifter(lines[r] - builtLines[r]);
+                if (r + 1 < starts.size()) {
+                    shifter.visit(prog->methods[r - 1]);
+                } else {
+                    shifter.visit(prog->main);
+                }
+                builtLines[r] = lines[r];
+            }
+        }
+        return prog;
+    }
+
+    /* the whole text, in one piece (which moves the gap left by the last edit to its end) */
+    std::string_view text() { return slice(0, size()); }
+
+    size_t size() const { return buffer.size() - gapSize; }
+
+    /* whether the program is the one of the current text, which has no syntax error */
+    bool valid() const { return prog != NULL && broken == NONE; }
+
+    /* offset of the first token of the given method */
+    size_t methodStart(size_t method) const { return starts[method + 1]; }
+
+    /*
+     * Positions, with methods numbered like Program::methods (the main block is methods.size(), the header NONE).
+     * Lines count from 1, columns (in bytes) from 0.
+     */
+
+    /* the method the text at offset belongs to, the whitespace after one included */
+    size_t methodAt(size_t offset) const {
+        return starts.empty() ? NONE : regionAt(offset) - 1;
+    }
+
+    /* where a token of the given method is now (its line is only up to date after program()), NONE + 1 wraps to the header */
+    size_t offsetOf(const Token& token, size_t method) const {
+        return token.offset + shifts[method + 1];
+    }
+
+    size_t columnOf(size_t offset) const {
+        size_t lineStart = offset;
+        while (lineStart > 0 && at(lineStart - 1) != '\n') {
+            lineStart--;
+        }
+        return offset - lineStart;
+    }
+
+    int lineOf(size_t offset) const {
+        size_t region = starts.empty() ? 0 : regionAt(offset);
+        int line = starts.empty() ? 1 : lines[region];
+        for (size_t i = starts.empty() ? 0 : starts[region]; i < offset; i++) {
+            line += at(i) == '\n';
+        }
+        return line;
+    }
+
+    /* offset of the column of the line, the end of the line (or text) if it is shorter */
+    size_t offsetAt(int line, size_t column) const {
+        size_t offset = 0;
+        int current = 1;
+        if (!starts.empty()) {
+            // from the start of the last region that starts on an earlier line (or the same one)
+            size_t region = std::upper_bound(lines.begin(), lines.end(), line) - lines.begin();
+            region = region > 0 ? region - 1 : 0;
+            offset = starts[region];
+            current = lines[region];
+        }
+
+        while (current < line && offset < size()) {
+            current += at(offset++) == '\n';
+        }
+        offset -= current == line ? columnOf(offset) : 0;
+        for (; column > 0 && offset < size() && at(offset) != '\n'; column--) {
+            offset++;
+        }
+        return offset;
+    }
+
+    char at(size_t offset) const {
+        return buffer[offset < gapStart ? offset : offset + gapSize];
+    }
+
+    static bool isWord(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    std::vector<SyntaxException> errors; // of the current text, in the order of the text; empty if it parses
+
+    size_t incrementalParses = 0;
+    size_t fullParses = 0;
+
+private:
+    static const size_t MIN_GAP = 4096;
+
+    // the text with a gap at the last edit, so that typing only moves the bytes between one edit and the next
+    std::string buffer;
+    size_t gapStart;
+    size_t gapSize = 0;
+
+    LexerKind lexerKind;
+    Program* prog = NULL;
+
+    // per region (header, methods, main): offset of its start, the line it starts on and the line its nodes were
+    // parsed for (they are shifted to the one it starts on now by program())
+    std::vector<unsigned int> starts;
+    std::vector<int> lines;
+    std::vector<int> builtLines;
+    std::vector<int64_t> shifts; // added to the token offsets of the region for where they are now
+
+    size_t broken = NONE; // region with a syntax error, the program still has the nodes from before it
+    size_t garbage = 0;   // bytes of text reparsed since the last full parse
+
+    size_t end(size_t region) const {
+        return region + 1 < starts.size() ? starts[region + 1] : size();
+    }
+
+    void moveGap(size_t offset) {
+        if (offset < gapStart) {
+            memmove(&buffer[offset + gapSize], &buffer[offset], gapStart - offset);
+        } else {
+            memmove(&buffer[gapStart], &buffer[gapStart + gapSize], offset - gapStart);
+        }
+        gapStart = offset;
+    }
+
+    /* the text from start to stop in one piece, moves the gap behind it if it is in between */
+    std::string_view slice(size_t start, size_t stop) {
+        if (gapStart > start && gapStart < stop) {
+            moveGap(stop);
+        }
+        return std::string_view(buffer).substr(start < gapStart ? start : start + gapSize, stop - start);
+    }
+
+    /* the last region starting at or before the offset, an insertion right before a method belongs to it */
+    size_t regionAt(size_t offset) const {
+        return std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+    }
+
+    /**
+     * whether the region still scans the same on its own as within the whole text: it must not end inside a
+     * comment or a string, and its first and last word must not run into the neighbouring regions
+     */
+    bool separate(size_t region) const {
+        size_t start = starts[region];
+        size_t stop = end(region);
+
+        if ((start > 0 && isWord(at(start - 1)) && start < stop && isWord(at(start))) ||
+            (stop < size() && stop > start && isWord(at(stop - 1)) && isWord(at(stop)))) {
+            return false;
+        }
+
+        char closing = 0;
+        for (size_t i = start; i < stop; i++) {
+            char c = at(i);
+            if (closing != 0) {
+                closing = c == closing ? 0 : closing;
+            } else if (c == '{') {
+                closing = '}';
+            } else if (c == '\'') {
+                closing = '\'';
+            }
+        }
+        return closing == 0;
+    }
+
+    /**
+     * parses the region on its own and splices the result into the program, throws the first syntax error (the
+     * region stays broken, with its nodes from before). An error can leave the parser out of step at the end of
+     * the region (a method that lost its end takes the next one with it): the full parse would go on with the
+     * next region from there, so the regions after it are parsed along, twice as many each time, until the parser
+     * is in step again at the end of one or has stopped before it
+     */
+    void reparse(size_t region) {
+        size_t stop = region + 1;
+        while (!reparse(region, stop)) {
+            stop = std::min(starts.size(), 2 * stop - region);
+        }
+    }
+
+    /**
+     * parses the regions from region up to stop in one part, false if the parser is not in step at its end (or
+     * the region has to be parsed together with the header, region is set to it then)
+     */
+    bool reparse(size_t& region, size_t stop) {
+        size_t start = starts[region];
+        bool main = stop == starts.size();
+
+        SourceFile* part = SourceFile::copy(slice(start, end(stop - 1)));
+        prog->parts.push_back(part);
+        garbage += part->size;
+        incrementalParses++;
+
+        // the steps of Parser::program() for the regions in the part
+        Parser parser(part, prog, lines[region], lexerKind);
+        parser.recovering = true;
+        if (region == 1 && parser.nextToken == TokenType::IDENTIFIER) {
+            // the declarations of the header would go on with it
+            region = 0;
+            return false;
+        }
+        Token programIdentifier = prog->identifier;
+        std::vector<Variable*> decls;
+        if (region == 0) {
+            parser.match(TokenType::PROGRAM);
+            programIdentifier = parser.match(TokenType::IDENTIFIER);
+            parser.synchronize();
+            parser.match(TokenType::SEMICOLON);
+            decls = parser.declarations();
+        }
+
+        std::vector<Method*> meths;
+        while (parser.nextToken == TokenType::FUNCTION || parser.nextToken == TokenType::PROCEDURE) {
+            parser.panicking = false;
+            parser.methodOffsets.push_back(parser.currentOffset());
+            meths.push_back(parser.method());
+            parser.synchronize();
+        }
+
+        // anything but a method is taken for the main block, the full parse ends with it (and ignores the rest)
+        Stmt::Block* block = NULL;
+        bool last = main;
+        main = main || parser.nextToken != 0;
+        if (main) {
+            parser.methodOffsets.push_back(parser.currentOffset());
+            block = parser.statement_block();
+            parser.match(TokenType::DOT);
+        }
+        // the declarations of a header that ends the part would go on with an identifier after it
+        if (!last && parser.nextToken == 0 && (main || parser.panicking || parser.errorAtEnd || stop == 1)) {
+            return false;
+        }
+        stop = main ? starts.size() : stop;
+
+        if (!parser.errors.empty()) {
+            broken = region;
+            errors = std::move(parser.errors);
+            throw errors[0];
+        }
+
+        // replace the regions by one per method they hold now (and the header and main block), any text in front
+        // of the first method is left to the region before
+        if (region == 0) {
+            prog->identifier = programIdentifier;
+            prog->declarations = parser.toArena(decls);
+        }
+        auto firstMethod = prog->methods.begin() + (region == 0 ? 0 : region - 1);
+        firstMethod = prog->methods.erase(firstMethod, main ? prog->methods.end() : prog->methods.begin() + (stop - 1));
+        prog->methods.insert(firstMethod, meths.begin(), meths.end());
+        if (main) {
+            prog->main = block;
+        }
+
+        int line = lines[region];
+        unsigned int counted = 0;
+        std::vector<unsigned int> newStarts;
+        std::vector<int> newLines;
+        if (region == 0) {
+            newStarts.push_back(start);
+            newLines.push_back(line);
+        }
+        for (unsigned int offset : parser.methodOffsets) {
+            line += std::count(part->data + counted, part->data + offset, '\n');
+            counted = offset;
+            newStarts.push_back(start + offset);
+            newLines.push_back(line);
+        }
+        std::vector<int64_t> newShifts(newStarts.size(), start); // the tokens count from the start of the part
+
+        starts.erase(starts.begin() + region, starts.begin() + stop);
+        starts.insert(starts.begin() + region, newStarts.begin(), newStarts.end());
+        lines.erase(lines.begin() + region, lines.begin() + stop);
+        lines.insert(lines.begin() + region, newLines.begin(), newLines.end());
+        builtLines.erase(builtLines.begin() + region, builtLines.begin() + stop);
+        builtLines.insert(builtLines.begin() + region, newLines.begin(), newLines.end());
+        shifts.erase(shifts.begin() + region, shifts.begin() + stop);
+        shifts.insert(shifts.begin() + region, newShifts.begin(), newShifts.end());
+
+        broken = NONE;
+        errors.clear();
+        return true;
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+
+#include "Parser.h"
+#include "ThreadPool.h"
+
+/**
+ * Writes one .dot file per method of a program (pascal-parser --dot-dir=<directory>), in parallel on a thread
+ * pool. The methods become <directory>/<index>-<name>.dot in the order they are declared, the main block comes
+ * last as <directory>/<index>-<program name>.dot. Every file is a digraph of its own that GraphViz can render
+ * separately, which is the only practical way to look at programs with millions of nodes.
+ */
+class DotClusters {
+public:
+    DotClusters(std::string directory, unsigned int threadCount = std::thread::hardware_concurrency())
+        : directory{directory}, pool{threadCount}
+    {}
+
+    /* writes all files, returns the number of files that could not be written */
+    size_t write(Program* prog) {
+        std::filesystem::create_directories(directory);
+
+        std::atomic<size_t> failed{0};
+        size_t methodCount = prog->methods.size();
+
+        pool.forEach(methodCount + 1, [&](size_t i) {
+            bool written = i < methodCount
+                ? writeFile(i, prog->methods[i]->identifier.text(), prog->methods[i])
+                : writeFile(i, prog->identifier.text(), prog->main);
+
+            if (!written) {
+                failed++;
+            }
+        });
+
+        return failed;
+    }
+
+private:
+    std::string directory;
+    ThreadPool pool;
+
+    template <typename Node>
+    bool writeFile(size_t index, std::string_view name, Node* node) {
+        std::filesystem::path path = std::filesystem::path(directory) / (std::to_string(index) + "-" + std::string(name) + ".dot");
+
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+
+        bool good;
+        {
+            OutputSink output(fd);
+            AST2Dot ast2dot(&output);
+            ast2dot.digraph(node);
+
+            output.flush();
+            good = output.good();
+        }
+
+        return close(fd) == 0 && good;
+    }
+};
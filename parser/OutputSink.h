@@ -0,0 +1,121 @@
+#pragma once
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+
+/**
+ * Fixed-size output buffer in front of a file descriptor: emitters append small pieces, every full buffer
+ * goes out with a single write(), so the first bytes arrive while the rest is still being produced and memory
+ * stays the same no matter how large the output gets.
+ *
+ * Without a file descriptor the flushed data is collected in a string instead (see result()), for callers
+ * that need the whole output at once (batch mode writes the results in input order).
+ */
+class OutputSink {
+public:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    /* writes to fd, which stays open */
+    OutputSink(int fd) : fd{fd} {}
+    /* collects everything in memory */
+    OutputSink() : fd{-1} {}
+
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    OutputSink& operator<<(std::string_view text) {
+        if (used + text.size() > BUFFER_SIZE) {
+            flush();
+
+            // larger than the whole buffer, no point in copying it
+            if (text.size() > BUFFER_SIZE) {
+                emit(text.data(), text.size());
+                return *this;
+            }
+        }
+
+        memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    OutputSink& operator<<(const char* text) { return *this << std::string_view(text); }
+
+    OutputSink& operator<<(char c) {
+        if (used == BUFFER_SIZE) {
+            flush();
+        }
+        buffer[used++] = c;
+        return *this;
+    }
+
+    OutputSink& operator<<(unsigned long number) {
+        char digits[20];
+        size_t length = 0;
+
+        do {
+            digits[sizeof(digits) - ++length] = '0' + number % 10;
+            number /= 10;
+        } while (number > 0);
+
+        return *this << std::string_view(digits + sizeof(digits) - length, length);
+    }
+
+    OutputSink& operator<<(unsigned int number) { return *this << static_cast<unsigned long>(number); }
+
+    OutputSink& operator<<(long number) {
+        if (number < 0) {
+            *this << '-';
+            return *this << -static_cast<unsigned long>(number);
+        }
+        return *this << static_cast<unsigned long>(number);
+    }
+
+    /* hands the buffered bytes on to the file descriptor (or the collected string) */
+    void flush() {
+        emit(buffer, used);
+        used = 0;
+    }
+
+    /* everything written so far (memory sinks only) */
+    const std::string& result() {
+        flush();
+        return collected;
+    }
+
+    /* false once a write to the file descriptor failed (e.g. a closed pipe), further output is dropped */
+    bool good() const { return !failed; }
+
+private:
+    int fd;
+    char buffer[BUFFER_SIZE];
+    size_t used = 0;
+    bool failed = false;
+
+    std::string collected;
+
+    void emit(const char* data, size_t size) {
+        if (fd < 0) {
+            collected.append(data, size);
+            return;
+        }
+
+        while (size > 0 && !failed) {
+            ssize_t written = write(fd, data, size);
+
+            if (written < 0) {
+                failed = errno != EINTR;
+                continue;
+            }
+
+            data += written;
+            size -= written;
+        }
+    }
+};
@@ -1,5 +1,19 @@
-
 #include "Parser.h"
+#include "Batch.h"
+#include "DotClusters.h"
+#include "../interpreter/Interpreter.h"
+#include "AST/Visitors/AST2C.h"
+#include "AST/Visitors/ConstantFolder.h"
+#include "../bytecode/Compiler.h"
+#include "../bytecode/VM.h"
+#include "../bytecode/Disassembler.h"
+#include "../jit/JIT.h"
+#include "../ir/Builder.h"
+#include "../ir/Passes.h"
+#include "../ir/Printer.h"
+#include "../lsp/Server.h"
+
+#include <limits.h>
 
 #include <iostream>
 #include <string>
@@ -7,21 +21,350 @@
 #include <list>
 
 
-int main(int argc, char **argv) {
-    Parser p;
+// -j beyond this many threads per core is cut down, more would only cost memory (and thread creation)
+static const unsigned int MAX_THREADS_PER_CORE = 8;
+
+/* pascal-parser --batch [-j threads] [-o output directory] files or directories... */
+int batch(const std::vector<char*>& arguments, LexerKind lexerKind) {
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::string outputDirectory;
+
+    size_t i = 0;
+    for (; i < arguments.size(); i++) {
+        if (strcmp(arguments[i], "-j") == 0 && i + 1 < arguments.size()) {
+            char* end;
+            long count = strtol(arguments[++i], &end, 10);
+            if (*arguments[i] == '\0' || *end != '\0' || count <= 0 || count > INT_MAX) {
+                std::cerr << "Usage: pascal-parser --batch [-j threads] [-o output directory] files or directories...\n"
+                          << "-j takes a positive number of threads, not \"" << arguments[i] << "\"" << std::endl;
+                return -1;
+            }
+            threads = std::min<long>(count, MAX_THREADS_PER_CORE * std::max(1u, std::thread::hardware_concurrency()));
+        } else if (strcmp(arguments[i], "-o") == 0 && i + 1 < arguments.size()) {
+            outputDirectory = arguments[++i];
+        } else {
+            break;
+        }
+    }
+
+    // before any input is parsed, instead of failing every one of them
+    if (!outputDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(outputDirectory, error);
+        if (error) {
+            std::cerr << "Cannot create the output directory " << outputDirectory << ": " << error.message() << std::endl;
+            return -1;
+        }
+    }
+
+    Batch batch(outputDirectory, threads, lexerKind);
+    for (; i < arguments.size(); i++) {
+        batch.add(arguments[i]);
+    }
+
+    return batch.run() == 0 ? 0 : -1;
+}
+
+/* parses a whole program, with its constant expressions folded if fold is set (see ConstantFolder),
+   or prints all its syntax errors and returns NULL */
+Program* parse(Parser& p, bool fold) {
+    p.recovering = true;
+    Program* prog = p.program();
+    if (!p.errors.empty()) {
+        for (const SyntaxException& ex : p.errors) {
+            std::cout << "Syntax error: " << ex.what() << '\n';
+        }
+        std::cout.flush();
+
+        delete prog;
+        return NULL;
+    }
+
+    if (fold) {
+        ConstantFolder(prog).fold();
+    }
+    return prog;
+}
+
+/* parses a whole program and prints its text representation (from the flat AST if flat is set) */
+int print(Parser& p, bool flat, bool fold) {
+    Program* prog = parse(p, fold);
+    if (prog == NULL) {
+        return -1;
+    }
+
+    if (flat) {
+        AST2Flat ast2flat;
+        FlatAST* flatAST = ast2flat.convert(prog);
+
+        FlatAST2Text flat2text(flatAST);
+        std::cout << flat2text.getResult() << std::endl;
+
+        delete flatAST;
+    } else {
+        // streamed straight to stdout, the text is never held in memory as a whole
+        OutputSink output(STDOUT_FILENO);
+        AST2Text ast2text(&output);
+        ast2text.visit(prog);
+
+        output << '\n';
+    }
+
+    delete prog;
+    return 0;
+}
+
+/* parses a whole program and prints it as .dot file, or writes one .dot file per method into directory */
+int printDot(Parser& p, const char* directory, bool fold) {
+    Program* prog = parse(p, fold);
+    if (prog == NULL) {
+        return -1;
+    }
+
+    size_t failed = 0;
+    if (directory != NULL) {
+        DotClusters clusters(directory);
+        failed = clusters.write(prog);
+
+        if (failed > 0) {
+            std::cerr << "Cannot write " << failed << " files to " << directory << std::endl;
+        }
+    } else {
+        OutputSink output(STDOUT_FILENO);
+        AST2Dot ast2dot(&output);
+        ast2dot.visit(prog);
+    }
+
+    delete prog;
+    return failed == 0 ? 0 : -1;
+}
+
+/* parses a whole program and prints it translated to C */
+int printC(Parser& p, bool fold) {
+    Program* prog = parse(p, fold);
+    if (prog == NULL) {
+        return -1;
+    }
+
+    // translated in memory first, so that a semantic error does not leave half a program on stdout
+    int status = 0;
+    OutputSink translated;
+    try {
+        AST2C ast2c(&translated);
+        ast2c.visit(prog);
 
-    Program* prog;
+        OutputSink output(STDOUT_FILENO);
+        output << translated.result();
+    } catch (SemanticException ex) {
+        std::cerr << "Semantic error: " << ex.what() << std::endl;
+        status = -1;
+    }
+
+    delete prog;
+    return status;
+}
+
+/* parses a whole program and prints it lowered to SSA form, optimized unless raw; timePasses reports the passes on stderr */
+int printIR(Parser& p, bool fold, bool raw, bool timePasses) {
+    Program* prog = parse(p, fold);
+    if (prog == NULL) {
+        return -1;
+    }
+
+    int status = 0;
     try {
-         prog = p.program();
-    } catch (SyntaxException ex) {
-        std::cout << "Syntax error: " << ex.what() << std::endl;
+        IR::Builder builder(prog);
+        std::unique_ptr<IR::Module> module(builder.build());
+
+        IR::PassManager passes = raw ? IR::PassManager() : IR::PassManager::standard();
+        passes.run(*module);
+        if (timePasses) {
+            passes.report(std::cerr);
+        }
+
+        OutputSink output(STDOUT_FILENO);
+        IR::Printer(module.get(), &output).print();
+    } catch (SemanticException ex) {
+        std::cerr << "Semantic error: " << ex.what() << std::endl;
+        status = -1;
+    }
+
+    delete prog;
+    return status;
+}
+
+enum class Engine { TREE, VM, JIT, DISASSEMBLE };
+
+/* parses a whole program and runs it (write()/writeln() print to stdout), or prints its bytecode */
+int interpret(Parser& p, Engine engine, bool fold) {
+    Program* prog = parse(p, fold);
+    if (prog == NULL) {
         return -1;
     }
 
-    AST2Text ast2text;
-    prog->accept(&ast2text);
-    
-    std::cout << ast2text.getResult() << std::endl;
+    int status = 0;
+    {
+        OutputSink output(STDOUT_FILENO);
+
+        try {
+            if (engine == Engine::TREE) {
+                Interpreter interpreter(prog, &output);
+                interpreter.run();
+            } else {
+                Bytecode::Compiler compiler(prog);
+                std::unique_ptr<Bytecode::Module> module(compiler.compile());
+                JIT::Compiler jit(module.get());
+
+                if (engine == Engine::DISASSEMBLE) {
+                    Bytecode::Disassembler(module.get(), &output).print();
+                } else {
+                    if (engine == Engine::JIT) {
+                        jit.compile();
+                    }
+                    Bytecode::VM vm(module.get(), &output);
+                    vm.run();
+                }
+            }
+        } catch (SemanticException ex) {
+            output.flush();
+            std::cerr << "Semantic error: " << ex.what() << std::endl;
+            status = -1;
+        } catch (RuntimeException ex) {
+            output.flush();
+            std::cerr << "Runtime error: " << ex.what() << std::endl;
+            status = -1;
+        }
+    }
 
     delete prog;
-}
\ No newline at end of file
+    return status;
+}
+
+/* prints the token stream only (used to compare the lexers) */
+int printTokens(Parser& p) {
+    while (p.nextToken != 0) {
+        Token token = p.match();
+        std::cout << token.lineNumber << " " << token.offset << " " << TOKEN_NAMES[token.type] << " \"" << token.text() << "\"" << std::endl;
+    }
+
+    return 0;
+}
+
+/* pascal-parser [--lexer=flex|simd] [--pretokenize] [--flat] [--tokens] [--fold] [--dot | --dot-dir=directory | --c | --ir[=raw] [--time-passes] | --run[=tree|vm] | --jit | --disassemble] [file]
+   or pascal-parser [--lexer=flex|simd] --batch ... or pascal-parser [--lexer=flex|simd] --lsp */
+int main(int argc, char **argv) {
+    LexerKind lexerKind = LexerKind::FLEX;
+    bool tokensOnly = false;
+    bool pretokenize = false;
+    bool flat = false;
+    bool dot = false;
+    const char* dotDirectory = NULL;
+    bool execute = false;
+    bool c = false;
+    bool fold = false;
+    bool ir = false;
+    bool rawIR = false;
+    bool timePasses = false;
+    bool languageServer = false;
+    Engine engine = Engine::TREE;
+
+    std::vector<char*> arguments;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lexer=simd") == 0) {
+            lexerKind = LexerKind::SIMD;
+        } else if (strcmp(argv[i], "--lexer=flex") == 0) {
+            lexerKind = LexerKind::FLEX;
+        } else if (strcmp(argv[i], "--tokens") == 0) {
+            tokensOnly = true;
+        } else if (strcmp(argv[i], "--pretokenize") == 0) {
+            pretokenize = true;
+        } else if (strcmp(argv[i], "--flat") == 0) {
+            flat = true;
+        } else if (strcmp(argv[i], "--run") == 0 || strcmp(argv[i], "--run=tree") == 0) {
+            execute = true;
+            engine = Engine::TREE;
+        } else if (strcmp(argv[i], "--run=vm") == 0) {
+            execute = true;
+            engine = Engine::VM;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            execute = true;
+            engine = Engine::JIT;
+        } else if (strcmp(argv[i], "--disassemble") == 0) {
+            execute = true;
+            engine = Engine::DISASSEMBLE;
+        } else if (strcmp(argv[i], "--c") == 0) {
+            c = true;
+        } else if (strcmp(argv[i], "--ir") == 0 || strcmp(argv[i], "--ir=raw") == 0) {
+            ir = true;
+            rawIR = strcmp(argv[i], "--ir=raw") == 0;
+        } else if (strcmp(argv[i], "--time-passes") == 0) {
+            timePasses = true;
+        } else if (strcmp(argv[i], "--lsp") == 0) {
+            languageServer = true;
+        } else if (strcmp(argv[i], "--fold") == 0) {
+            fold = true;
+        } else if (strcmp(argv[i], "--dot") == 0) {
+            dot = true;
+        } else if (strncmp(argv[i], "--dot-dir=", 10) == 0) {
+            dot = true;
+            dotDirectory = argv[i] + 10;
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    if (languageServer) {
+        return LSP::Server(stdin, STDOUT_FILENO, lexerKind).run();
+    }
+
+    if (!arguments.empty() && strcmp(arguments[0], "--batch") == 0) {
+        return batch(std::vector<char*>(arguments.begin() + 1, arguments.end()), lexerKind);
+    }
+
+    auto run = [&](Parser& p) {
+        if (tokensOnly) {
+            return printTokens(p);
+        }
+        if (execute) {
+            return interpret(p, engine, fold);
+        }
+        if (c) {
+            return printC(p, fold);
+        }
+        if (ir) {
+            return printIR(p, fold, rawIR, timePasses);
+        }
+        return dot ? printDot(p, dotDirectory, fold) : print(p, flat, fold);
+    };
+
+    // without a file read stdin (through flex)
+    if (arguments.empty()) {
+        if (lexerKind != LexerKind::FLEX) {
+            std::cerr << "The SIMD lexer can only read files" << std::endl;
+            return -1;
+        }
+
+        Parser p(stdin);
+        return run(p);
+    }
+
+    // files are mapped and scanned in place
+    SourceFile* source = SourceFile::map(arguments[0]);
+    if (source == NULL) {
+        std::cerr << "Cannot open " << arguments[0] << std::endl;
+        return -1;
+    }
+
+    if (pretokenize) {
+        // lex everything first, then parse from the token buffer
+        Lexer* lexer = Parser::createLexer(source, lexerKind);
+        TokenBuffer tokens(*lexer);
+        delete lexer;
+
+        Parser p(&tokens, source);
+        return run(p);
+    }
+
+    Parser p(source, lexerKind);
+    return run(p);
+}
@@ -1,10 +1,16 @@
+#pragma once
 
+
+#include <array>
 #include <iostream>
 #include <exception>
 
 #include "../common/token-enum.h"
-#include "../lexer/lex.yy.c"
+#include "../lexer/FlexScanner.h"
+#include "../lexer/SimdLexer.h"
+#include "../lexer/TokenBuffer.h"
 
+#include "SourceFile.h"
 #include "SyntaxException.h"
 
 #include "AST/Expression.h"
@@ -15,46 +21,252 @@
 
 #include "AST/Visitors/AST2Text.h"
 #include "AST/Visitors/AST2Dot.h"
-
-// extern int yylex();
-// extern int yylineno;
-// extern char* yytext;
-// extern FILE *yyin;
+#include "AST/Visitors/AST2Flat.h"
+#include "AST/Visitors/FlatAST2Text.h"
 
 using Expr::Expression;
 using Stmt::Statement;
 
+/* precedence and associativity of a binary operator */
+struct BinaryOperator {
+    uint8_t precedence = 0; // 0 for tokens that are no binary operator, higher binds more tightly
+    bool chains = false;    // left associative, otherwise an expression has one operator of its level at most (relations)
+};
+
+constexpr std::array<BinaryOperator, TokenType::IDENTIFIER + 1> binaryOperators() {
+    std::array<BinaryOperator, TokenType::IDENTIFIER + 1> table{};
+    for (TokenType relation : { TokenType::OP_EQUALS, TokenType::OP_NOT_EQUALS, TokenType::OP_LESS,
+                                TokenType::OP_LESS_EQUAL, TokenType::OP_GREATER, TokenType::OP_GREATER_EQUAL }) {
+        table[relation] = { 1, false };
+    }
+    for (TokenType addition : { TokenType::OP_ADD, TokenType::OP_SUB, TokenType::OP_OR }) {
+        table[addition] = { 2, true };
+    }
+    for (TokenType multiplication : { TokenType::OP_MUL, TokenType::OP_DIV, TokenType::OP_INTEGER_DIV, TokenType::OP_AND }) {
+        table[multiplication] = { 3, true };
+    }
+    return table;
+}
+
+/* by token type, see Parser::expression() */
+constexpr std::array<BinaryOperator, TokenType::IDENTIFIER + 1> BINARY_OPERATORS = binaryOperators();
+
 class Parser {
 public:
-    Parser() {
+    /* every parser owns its own lexer (flex scanners are reentrant), so any number of them can run in parallel */
+    Parser(FILE* input = stdin)
+        : tokens{NULL}, position{0}, arena{new Arena()}, symbols{new StringInterner(arena)}, source{NULL}
+    {
+        lexer = new FlexScanner(input);
+
+        // consume first token at start
+        nextToken = lexer->next();
+    }
+
+    /* scans a mapped file in place, the texts of all tokens point into it (the program takes over the source) */
+    Parser(SourceFile* source, LexerKind lexerKind = LexerKind::FLEX)
+        : lexer{createLexer(source, lexerKind)}, tokens{NULL}, position{0}, arena{new Arena()}, symbols{new StringInterner(arena)},
+          source{source}
+    {
+        // consume first token at start
+        nextToken = lexer->next();
+    }
+
+    /**
+     * scans a part of the text of a program that starts on the given line (a method reparsed by a Document):
+     * the nodes go into the arena of the program and the texts into its interner, the caller hands the part
+     * over to the program as well (Program::parts), since the token texts point into it
+     */
+    Parser(SourceFile* part, Program* prog, int firstLine, LexerKind lexerKind = LexerKind::FLEX)
+        : lexer{createLexer(part, lexerKind)}, tokens{NULL}, position{0}, arena{prog->arena}, symbols{prog->symbols},
+          source{part}, lineOffset{firstLine - 1}, continued{true}
+    {
         // consume first token at start
-        nextToken = static_cast<TokenType>(yylex());
+        nextToken = lexer->next();
+    }
+
+    /* walks a token buffer of the source (which stays owned by the caller, so it can be reused) */
+    Parser(const TokenBuffer* tokens, SourceFile* source)
+        : lexer{NULL}, tokens{tokens}, position{0}, arena{new Arena()}, symbols{new StringInterner(arena)}, source{source}
+    {
+        nextToken = static_cast<TokenType>(tokens->types[0]);
+    }
+
+    ~Parser() {
+        delete lexer;
+
+        // only still set if no program was parsed successfully, a part belongs to the program it was parsed into
+        if (!continued) {
+            delete source;
+            delete symbols;
+            delete arena;
+        }
+    }
+
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+
+    /* lexer of the given kind that scans the source in place */
+    static Lexer* createLexer(SourceFile* source, LexerKind lexerKind) {
+        if (lexerKind == LexerKind::SIMD) {
+            return new SimdLexer(source->data, source->size);
+        }
+        return new FlexScanner(source->data, source->size);
     }
 
 
 // private:
+    Lexer* lexer;                // either tokens are scanned one at a time
+    const TokenBuffer* tokens;   // or taken from a buffer of the whole input
+    size_t position;             // index of the next token in the buffer
     TokenType nextToken;
+    size_t tokenCount = 0; // number of consumed tokens
+
+    /* holds every node created while parsing, ownership moves to the parsed program */
+    Arena* arena;
+    /* identifier and literal texts of the tokens, owned by the parsed program as well */
+    StringInterner* symbols;
+    /* mapped input file (if any), owned by the parsed program as well */
+    SourceFile* source;
+
+    int lineOffset = 0;      // added to the line numbers of the lexer, for parts that do not start on line 1
+    bool continued = false;  // arena, symbols and source belong to a program already
+    std::vector<unsigned int> methodOffsets; // of the first token of every method, then of the main block (by program())
+
+    /* an operator or an opening bracket of the expression being parsed, waiting for what follows (see expression()) */
+    struct ExpressionFrame {
+        enum class Kind : uint8_t { EXPRESSION, BINARY, UNARY, GROUPING, CALL, INDEX };
+
+        Kind kind;
+        uint8_t precedence; // operators: how tightly they bind (prefix ones most), 0 for the others
+        bool relation;      // brackets: whether the expression around them had its relation already
+        Token token;        // the operator, or the name that is called or indexed
+        size_t operands;    // call: where its arguments start on the operand stack
+    };
+    static const uint8_t UNARY_PRECEDENCE = 4;
+    // kept between expressions, so that their memory is reused
+    std::vector<ExpressionFrame> expressionFrames;
+    std::vector<Expression*> expressionOperands; // left operands and arguments parsed so far
+
+    /* with recovering set syntax errors are collected in errors instead of thrown, and parsing goes on (see synchronize()) */
+    bool recovering = false;
+    std::vector<SyntaxException> errors;
+    bool panicking = false; // an error put the parser out of step with the input, until the next synchronization token
+    bool errorAtEnd = false; // one of the errors was recorded at the end of the input, more input could have changed it
+
+    /* copies a temporary list into the arena, so that the node storing it never has to free it */
+    template <typename T>
+    ArenaVector<T> toArena(const std::vector<T>& list) {
+        return ArenaVector<T>(list.begin(), list.end(), ArenaAllocator<T>(arena));
+    }
 
     Token match(TokenType expectedToken) {
         if (nextToken == expectedToken) {
             // consume next token
             return match();
         } else {
-            throw SyntaxException(nextToken, expectedToken, yylineno);
+            error(SyntaxException(nextToken, expectedToken, lineNumber()));
+            return missing(expectedToken);
         }
     }
 
     /* Matches every token and consumes it */
     Token match() {
-        Token consumedToken(nextToken, yytext, yylineno);
+        tokenCount++;
+
+        Token consumedToken = currentToken();
+
+        if (TOKEN_SPELLINGS[nextToken] != NULL) {
+            // fixed spelling, nothing has to be kept from the scanner buffer
+            consumedToken.lexeme = TOKEN_SPELLINGS[nextToken];
+        } else if (source != NULL) {
+            // identifiers and literals of a mapped source stay slices of the source
+            consumedToken.symbol = symbols->internInPlace(consumedToken.text());
+        } else {
+            // the scanner buffer of a stream is reused, so the text is interned as a copy
+            consumedToken.symbol = symbols->intern(consumedToken.text());
+            consumedToken.lexeme = symbols->text(consumedToken.symbol).data();
+        }
         
-        // std::cout << "updated next token from " << TOKEN_NAMES[nextToken] << " (\"" << yytext << "\") to ";
-        nextToken = static_cast<TokenType>(yylex());
-        // std::cout << TOKEN_NAMES[nextToken] << " (\"" << yytext << "\")" << std::endl;
+        // std::cout << "updated next token from " << TOKEN_NAMES[nextToken] << " (\"" << consumedToken.text() << "\") to ";
+        advance();
+        // std::cout << TOKEN_NAMES[nextToken] << " (\"" << currentToken().text() << "\")" << std::endl;
 
         return consumedToken;
     }
 
+    /* the next token as the lexer scanned it or as it is stored in the token buffer */
+    Token currentToken() {
+        if (tokens != NULL) {
+            unsigned int offset = tokens->offsets[position];
+            return Token(nextToken, std::string_view(source->data + offset, tokens->lengths[position]), tokens->lines[position], offset);
+        }
+
+        return Token(nextToken, std::string_view(lexer->text, lexer->length), lexer->lineNumber + lineOffset, lexer->offset);
+    }
+
+    void advance() {
+        if (tokens != NULL) {
+            // stay on the end of input entry
+            if (position + 1 < tokens->size()) {
+                position++;
+            }
+            nextToken = static_cast<TokenType>(tokens->types[position]);
+        } else {
+            nextToken = lexer->next();
+        }
+    }
+
+    /* byte offset of the next token */
+    unsigned int currentOffset() {
+        return tokens != NULL ? tokens->offsets[position] : lexer->offset;
+    }
+
+    /* line of the next token */
+    int lineNumber() {
+        return tokens != NULL ? tokens->lines[position] : lexer->lineNumber + lineOffset;
+    }
+
+    /**
+     * Throws the error, or when recovering records it and returns, the caller goes on as if the input was right
+     * (a token that was expected is treated as missing, see missing()). Errors that leave the parser out of step
+     * (desynchronized) start panic mode: the errors that follow are dropped, they are most likely caused by the
+     * first one, until synchronize() has skipped to a token the parser can continue from.
+     */
+    void error(const SyntaxException& ex, bool desynchronized = true) {
+        if (!recovering) {
+            throw ex;
+        }
+        if (!panicking || !desynchronized) {
+            errors.push_back(ex);
+            errorAtEnd = errorAtEnd || nextToken == 0;
+        }
+        panicking = panicking || desynchronized;
+    }
+
+    /* stands in for an expected token that is not there, without text, at the position of the next one */
+    Token missing(TokenType type) {
+        return Token(type, std::string_view("", 0), lineNumber(), currentOffset());
+    }
+
+    /**
+     * In panic mode skips ahead to the next SEMICOLON, END_, FUNCTION or PROCEDURE (or the end of the input). The
+     * parser is in step again at the first two. At the others the block or declaration it is in cannot go on, it
+     * stays in panic mode (everything missing up to the next method is missing because of the error) and returns true.
+     */
+    bool synchronize() {
+        if (!panicking) {
+            return false;
+        }
+        while (nextToken != 0 && nextToken != TokenType::SEMICOLON && nextToken != TokenType::END_ &&
+               nextToken != TokenType::FUNCTION && nextToken != TokenType::PROCEDURE) {
+            tokenCount++;
+            advance();
+        }
+        panicking = nextToken != TokenType::SEMICOLON && nextToken != TokenType::END_;
+        return panicking;
+    }
+
     /* =========================================================================================================================== */
     /* ========= Program ========================================================================================================= */
     /* =========================================================================================================================== */
@@ -62,6 +274,7 @@ public:
     Program* program() {
         match(TokenType::PROGRAM);
         Token programIdentifier = match(TokenType::IDENTIFIER);
+        synchronize();
         match(TokenType::SEMICOLON);
 
         // declarations
@@ -70,15 +283,24 @@ public:
         // methods
         std::vector<Method*> meths;
         while (nextToken == TokenType::FUNCTION || nextToken == TokenType::PROCEDURE) {
+            panicking = false; // a method is where an error in the one before ends
+            methodOffsets.push_back(currentOffset());
             meths.push_back(method());
+            synchronize();
         }
 
         // match main
+        methodOffsets.push_back(currentOffset());
         Stmt::Block* main = statement_block();
 
         match(TokenType::DOT);
 
-        return new Program(programIdentifier, decls, meths, main);
+        Program* prog = new Program(programIdentifier, toArena(decls), toArena(meths), main, arena, symbols, source);
+        arena = NULL;
+        symbols = NULL;
+        source = NULL;
+
+        return prog;
     }
 
     /* --------------- Declarations --------------------- */
@@ -88,12 +310,14 @@ public:
         if (nextToken == TokenType::VAR) {
             match(TokenType::VAR);
             declarations = declaration_line();
+            synchronize();
             match(TokenType::SEMICOLON);
 
 
             // check for more lines
             while (nextToken == TokenType::IDENTIFIER) {
                 std::vector<Variable*> newDeclarations = declaration_line();
+                synchronize();
                 match(TokenType::SEMICOLON);
                 // copy the new ones to our declaration list
                 declarations.insert(declarations.end(), newDeclarations.begin(), newDeclarations.end());
@@ -120,7 +344,7 @@ public:
 
 
         for (Token identifier : variableNames) {
-            declarations.push_back(new Variable(identifier, variableType));
+            declarations.push_back(arena->make<Variable>(identifier, variableType));
         }
 
         return declarations;
@@ -144,10 +368,10 @@ public:
 
             Token typeName = simple_type();
 
-            temp = new Variable::VariableTypeArray(typeName, startRange, stopRange);
+            temp = arena->make<Variable::VariableTypeArray>(typeName, startRange, stopRange);
         } else {
             // standard type
-            temp = new Variable::VariableTypeSimple(simple_type());
+            temp = arena->make<Variable::VariableTypeSimple>(simple_type());
         }
 
         return temp;
@@ -158,8 +382,9 @@ public:
             return match();
         } else {
             std::stringstream ss;
-            ss << "Expected standard type (integer, real or boolean), but got " << TOKEN_NAMES[nextToken] << " at line " << yylineno;
-            throw SyntaxException(ss.str().c_str());
+            ss << "Expected standard type (integer, real or boolean), but got " << TOKEN_NAMES[nextToken] << " at line " << lineNumber();
+            error(SyntaxException(ss.str(), lineNumber()));
+            return missing(TokenType::INTEGER);
         }
     }
 
@@ -171,8 +396,8 @@ public:
     Method* method() {
         if (nextToken != TokenType::FUNCTION && nextToken != TokenType::PROCEDURE) {
             std::stringstream ss;
-            ss << "Expected method declaration (starting with either 'function' or 'procedure') but got " << TOKEN_NAMES[nextToken] << " at line " << yylineno;
-            throw SyntaxException(ss.str().c_str());
+            ss << "Expected method declaration (starting with either 'function' or 'procedure') but got " << TOKEN_NAMES[nextToken] << " at line " << lineNumber();
+            error(SyntaxException(ss.str(), lineNumber()));
         }
 
         Token methodKeyword = match(); // consume FUNCTION or PROCEDURE token
@@ -197,11 +422,11 @@ public:
         // return type
         Variable::VariableType* returnType = NULL;
         if (nextToken == TokenType::COLON) {
-            // throw exception when a procedure has a return type
+            // error when a procedure has a return type
             if (methodKeyword.type == TokenType::PROCEDURE) {
                 std::stringstream ss;
-                ss << "Procedure cannot have a return type at line " << yylineno;
-                throw SyntaxException(ss.str().c_str());
+                ss << "Procedure cannot have a return type at line " << lineNumber();
+                error(SyntaxException(ss.str(), lineNumber()), false);
             }
 
             // method with return value
@@ -209,13 +434,14 @@ public:
 
             returnType = variable_type();
         }
+        synchronize();
         match(TokenType::SEMICOLON);
 
-        // throw exception when a function has no return type
+        // error when a function has no return type
         if (returnType == NULL && methodKeyword.type == TokenType::FUNCTION) {
             std::stringstream ss;
-            ss << "Function must have a return type at line " << yylineno;
-            throw SyntaxException(ss.str().c_str());
+            ss << "Function must have a return type at line " << lineNumber();
+            error(SyntaxException(ss.str(), lineNumber()), false);
         }
 
         // declarations
@@ -228,19 +454,21 @@ public:
 
         if (nextToken != TokenType::END_) {
             statementsInBlock.push_back(statement());
+            bool cutOff = synchronize();
 
-            while (nextToken != TokenType::END_) {
+            while (nextToken != TokenType::END_ && !cutOff) {
                 match(TokenType::SEMICOLON);
 
                 statementsInBlock.push_back(statement());
+                cutOff = synchronize();
             }
         }
-        Stmt::Block* methodBlock = new Stmt::Block(statementsInBlock);
+        Stmt::Block* methodBlock = arena->make<Stmt::Block>(toArena(statementsInBlock));
 
         match(TokenType::END_);
         match(TokenType::SEMICOLON);
 
-        return new Method(methodIdentifier, args, decls, methodBlock, returnType);
+        return arena->make<Method>(methodIdentifier, toArena(args), toArena(decls), methodBlock, returnType);
     }
 
 
@@ -255,17 +483,19 @@ public:
 
         if (nextToken != TokenType::END_) {
             statementsInBlock.push_back(statement());
+            bool cutOff = synchronize();
 
-            while (nextToken != TokenType::END_) {
+            while (nextToken != TokenType::END_ && !cutOff) {
                 match(TokenType::SEMICOLON);
 
                 statementsInBlock.push_back(statement());
+                cutOff = synchronize();
             }
         }
 
         match(TokenType::END_);
 
-        return new Stmt::Block(statementsInBlock);
+        return arena->make<Stmt::Block>(toArena(statementsInBlock));
     }
 
     Stmt::While* statement_while() {
@@ -275,7 +505,7 @@ public:
         match(TokenType::DO);
         Statement* body = statement();
 
-        return new Stmt::While(condition, body);
+        return arena->make<Stmt::While>(condition, body);
     }
 
     Stmt::If* statment_if() {
@@ -292,7 +522,7 @@ public:
             elseBody = statement();
         }
 
-        return new Stmt::If(condition, thenBody, elseBody);
+        return arena->make<Stmt::If>(condition, thenBody, elseBody);
     }
 
     Stmt::Call* statement_method_call(Token identifierToken) {
@@ -310,7 +540,7 @@ public:
 
         match(TokenType::BRACKETS_CLOSING);
 
-        return new Stmt::Call(identifierToken, argumentList); 
+        return arena->make<Stmt::Call>(identifierToken, toArena(argumentList)); 
     }
 
     Stmt::Assignment* statement_assignment(Token identifierToken) {
@@ -325,7 +555,7 @@ public:
 
         Expression* assignmentValue = expression();
 
-        return new Stmt::Assignment(identifierToken, arrayIndexValue, assignmentValue);
+        return arena->make<Stmt::Assignment>(identifierToken, arrayIndexValue, assignmentValue);
     }
     
     
@@ -351,8 +581,9 @@ public:
             } break;
             default: {
                 std::stringstream ss;
-                ss << "Expected statement, but got token '" << TOKEN_NAMES[nextToken] << "' at line " << yylineno;
-                throw SyntaxException(ss.str().c_str());
+                ss << "Expected statement, but got token '" << TOKEN_NAMES[nextToken] << "' at line " << lineNumber();
+                error(SyntaxException(ss.str(), lineNumber()));
+                temp = arena->make<Stmt::Block>(toArena(std::vector<Statement*>())); // nothing, in its place
             }; break;
         }
 
@@ -365,131 +596,145 @@ public:
     /* ========= Expressions ===================================================================================================== */
     /* =========================================================================================================================== */
 
+    /**
+     * Precedence climbing over explicit stacks rather than one function per level of the grammar
+     *
+     *     expression        = simple_expression [relation simple_expression]
+     *     simple_expression = term {("+" | "-" | "or") term}
+     *     term              = factor {("*" | "/" | "div" | "and") factor}
+     *     factor            = ("-" | "not") factor | "(" expression ")" | literal | IDENTIFIER ["(" [arguments] ")" | "[" expression "]"]
+     *
+     * A binary operator waits in expressionFrames until an operator that binds less tightly (BINARY_OPERATORS)
+     * or the end of its expression comes. Prefix operators bind to the operand right behind them, and brackets
+     * open a frame in which an expression of its own is parsed. Nothing recurses, however deeply an expression
+     * nests. The trees and the tokens at which errors come up are the same as those of the grammar above.
+     */
     Expression* expression() {
-        Expression* temp = simple_expression(); // left expression
-
-        if (nextToken == TokenType::OP_EQUALS || nextToken == TokenType::OP_NOT_EQUALS || nextToken == TokenType::OP_LESS ||
-            nextToken == TokenType::OP_LESS_EQUAL || nextToken == TokenType::OP_GREATER || nextToken == TokenType::OP_GREATER_EQUAL) {
-
-            Token operatorToken = match();
-            Expression* rightSide = simple_expression();
-
-            temp = new Expr::Binary(temp, operatorToken, rightSide);
-        }
-
-        return temp;
-    }
-
-    Expression* simple_expression() {
-        Expression* temp = term();
-
-        // add operations
-        while (nextToken == TokenType::OP_ADD || nextToken == TokenType::OP_SUB || nextToken == TokenType::OP_OR) {
-            Token opToken = match();
-            Expression* rightSide = term();
-
-            temp = new Expr::Binary(temp, opToken, rightSide);
-        }
-
-        return temp;
-    }
-
-    Expression* term() {
-        // main factor
-        Expression* temp = factor();
-
-        // mult operations
-        while (nextToken == TokenType::OP_MUL || nextToken == TokenType::OP_DIV || nextToken == TokenType::OP_INTEGER_DIV || nextToken == TokenType::OP_AND) {
-            Token operatorToken = match();
-            Expression* rightSide = factor();
-
-            temp = new Expr::Binary(temp, operatorToken, rightSide);
-        }
-
-        return temp;
-    }
-
-    Expression* factor() {
-        Expression* temp;
-
-        switch (nextToken) {
-            // arbitrary amount of "not"'s or "-"'s
-            case TokenType::OP_SUB:
-            case TokenType::OP_NOT:
-            {
-                Token opToken = match();
-
-                temp = new Expr::Unary(opToken, factor());
-            } break;
-
-            // groupings (with brackets)
-            case TokenType::BRACKETS_OPEN:
-            {
-                match(TokenType::BRACKETS_OPEN);
-                temp = new Expr::Grouping(expression());
-                match(TokenType::BRACKETS_CLOSING);
-
-            } break;
-
-            // literals
-            case TokenType::LITERAL_INTEGER:
-            case TokenType::LITERAL_REAL:
-            case TokenType::LITERAL_STRING: 
-            case TokenType::LITERAL_TRUE:
-            case TokenType::LITERAL_FALSE:
-            {
-                Token literalToken = match();
-                temp = new Expr::Literal{literalToken};
-            } break;
-
-            // identifiers and function calls
-            case TokenType::IDENTIFIER:
-            {
-                Token identifierToken = match();
-
-                // check if we have a function call (starts with opening bracket)
-                if (nextToken == TokenType::BRACKETS_OPEN) {
-                    // a function call
-                    match(TokenType::BRACKETS_OPEN);
-
-                    // matching argument list (list of expressions)
-                    std::vector<Expression*> argumentList;
-                    if (nextToken != TokenType::BRACKETS_CLOSING) {
-                        argumentList.push_back(expression());
-
-                        while (nextToken == TokenType::COMMA) {
-                            match(TokenType::COMMA); // consume the comma
-                            argumentList.push_back(expression());
+        // nothing else parses in between, the stacks are empty but for what an exception left behind
+        expressionFrames.clear();
+        expressionOperands.clear();
+        // at the bottom, it ends the expression as a closing bracket ends a grouping (its token is not used)
+        expressionFrames.push_back({ ExpressionFrame::Kind::EXPRESSION, 0, false, Token(nextToken, std::string_view(), 0, 0), 0 });
+        bool relation = false; // the innermost expression has its relation (no second one can follow)
+
+        while (true) {
+            // an operand, behind any prefix operators and opening brackets
+            Expression* operand;
+            switch (nextToken) {
+                case TokenType::OP_SUB:
+                case TokenType::OP_NOT:
+                    expressionFrames.push_back({ ExpressionFrame::Kind::UNARY, UNARY_PRECEDENCE, false, match(), 0 });
+                    continue;
+
+                case TokenType::BRACKETS_OPEN:
+                    expressionFrames.push_back({ ExpressionFrame::Kind::GROUPING, 0, relation, match(), 0 });
+                    relation = false;
+                    continue;
+
+                case TokenType::LITERAL_INTEGER:
+                case TokenType::LITERAL_REAL:
+                case TokenType::LITERAL_STRING:
+                case TokenType::LITERAL_TRUE:
+                case TokenType::LITERAL_FALSE:
+                    operand = arena->make<Expr::Literal>(match());
+                    break;
+
+                case TokenType::IDENTIFIER: {
+                    Token identifierToken = match();
+
+                    if (nextToken == TokenType::BRACKETS_OPEN) {
+                        // a function call
+                        match(TokenType::BRACKETS_OPEN);
+                        if (nextToken != TokenType::BRACKETS_CLOSING) {
+                            expressionFrames.push_back({ ExpressionFrame::Kind::CALL, 0, relation, identifierToken, expressionOperands.size() });
+                            relation = false;
+                            continue;
                         }
+                        operand = arena->make<Expr::Call>(identifierToken, ArenaVector<Expression*>(ArenaAllocator<Expression*>(arena)));
+                        match(TokenType::BRACKETS_CLOSING);
+                    } else if (nextToken == TokenType::SQUARE_OPEN) {
+                        // an array element
+                        match(TokenType::SQUARE_OPEN);
+                        expressionFrames.push_back({ ExpressionFrame::Kind::INDEX, 0, relation, identifierToken, 0 });
+                        relation = false;
+                        continue;
+                    } else {
+                        operand = arena->make<Expr::Identifier>(identifierToken, static_cast<Expression*>(NULL));
                     }
+                } break;
+
+                default: {
+                    std::stringstream ss;
+                    ss << "Unexpected token (" << TOKEN_NAMES[nextToken] << ") at line " << lineNumber();
+                    error(SyntaxException(ss.str(), lineNumber()));
+                    operand = arena->make<Expr::Literal>(missing(TokenType::LITERAL_INTEGER));
+                } break;
+            }
 
-                    temp = new Expr::Call(identifierToken, argumentList); 
+            // behind the operand: operators take it, or expressions end and close their brackets
+            while (true) {
+                BinaryOperator binary = BINARY_OPERATORS[nextToken];
+                if (binary.precedence > 0 && (binary.chains || !relation)) {
+                    // the operators before it that bind at least as tightly have their right operand now
+                    while (expressionFrames.back().precedence >= binary.precedence) {
+                        operand = reduce(operand);
+                    }
+                    relation = relation || !binary.chains;
 
-                    match(TokenType::BRACKETS_CLOSING);
-                    
-                } else {
-                    // just a regular identifier
-                    Expression* arrayIndexExpression = NULL;
+                    expressionOperands.push_back(operand);
+                    expressionFrames.push_back({ ExpressionFrame::Kind::BINARY, binary.precedence, false, match(), 0 });
+                    break;
+                }
 
-                    if (nextToken == TokenType::SQUARE_OPEN) {
-                        match(TokenType::SQUARE_OPEN);
-                        arrayIndexExpression = expression();
-                        match(TokenType::SQUARE_CLOSING);
+                // the innermost expression ends, all of its operators have their right operand
+                while (expressionFrames.back().precedence > 0) {
+                    operand = reduce(operand);
+                }
 
-                    }
+                ExpressionFrame& frame = expressionFrames.back();
+                if (frame.kind == ExpressionFrame::Kind::EXPRESSION) {
+                    expressionFrames.pop_back();
+                    return operand;
+                }
+                if (frame.kind == ExpressionFrame::Kind::CALL && nextToken == TokenType::COMMA) {
+                    // the next argument
+                    match(TokenType::COMMA);
+                    expressionOperands.push_back(operand);
+                    relation = false;
+                    break;
+                }
 
-                    temp = new Expr::Identifier(identifierToken, arrayIndexExpression);
+                relation = frame.relation;
+                if (frame.kind == ExpressionFrame::Kind::GROUPING) {
+                    operand = arena->make<Expr::Grouping>(operand);
+                    match(TokenType::BRACKETS_CLOSING);
+                } else if (frame.kind == ExpressionFrame::Kind::INDEX) {
+                    match(TokenType::SQUARE_CLOSING);
+                    operand = arena->make<Expr::Identifier>(frame.token, operand);
+                } else {
+                    expressionOperands.push_back(operand);
+                    auto arguments = expressionOperands.begin() + frame.operands;
+                    operand = arena->make<Expr::Call>(frame.token, ArenaVector<Expression*>(arguments, expressionOperands.end(), ArenaAllocator<Expression*>(arena)));
+                    expressionOperands.erase(arguments, expressionOperands.end());
+                    match(TokenType::BRACKETS_CLOSING);
                 }
-            } break;
-            default: 
-            {
-                std::stringstream ss;
-                ss << "Unexpected token (" << TOKEN_NAMES[nextToken] << ") at line " << yylineno;
-                throw SyntaxException(ss.str().c_str());
-            } break;
+                expressionFrames.pop_back();
+            }
         }
+    }
 
-        return temp;
+    /* the operator on top of the frames applied to the given (right) operand, and to its left one from the operand stack */
+    Expression* reduce(Expression* right) {
+        const ExpressionFrame& frame = expressionFrames.back();
+        Expression* result;
+        if (frame.kind == ExpressionFrame::Kind::UNARY) {
+            result = arena->make<Expr::Unary>(frame.token, right);
+        } else {
+            result = arena->make<Expr::Binary>(expressionOperands.back(), frame.token, right);
+            expressionOperands.pop_back();
+        }
+        expressionFrames.pop_back();
+        return result;
     }
 
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <exception>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+/* a program that parses, but refers to names (or uses types) that do not fit together */
+class SemanticException : public std::exception {
+public:
+    SemanticException(std::string_view what, std::string_view name, int lineNumber)
+    {
+        std::stringstream ss;
+        ss << what << " '" << name << "' on line " << lineNumber << "!";
+        message = ss.str();
+    };
+
+    SemanticException(std::string message) : message{message} {}
+
+    const char* what() const throw() {
+        return message.c_str();
+    }
+
+private:
+    std::string message;
+};
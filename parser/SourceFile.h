@@ -0,0 +1,87 @@
+#pragma once
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+#include <string_view>
+
+/**
+ * Program text mapped into memory instead of being read through stdio. The mapping is followed by PADDING zero
+ * bytes: flex needs two of them to scan a buffer in place (yy_scan_buffer), the SIMD lexer reads up to a vector
+ * beyond the end. Token texts of a program parsed from a SourceFile point right into the mapping, so the program
+ * keeps its source file alive.
+ */
+class SourceFile {
+public:
+    static const size_t PADDING = 64;
+
+    /* maps the given file, returns NULL if it cannot be opened */
+    static SourceFile* map(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return NULL;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return NULL;
+        }
+
+        size_t size = info.st_size;
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t mappedSize = (size + PADDING + pageSize - 1) / pageSize * pageSize;
+
+        // reserve zeroed memory for the file plus the terminating zeros, then map the file over its start.
+        // Private and writable, because flex temporarily terminates the current token inside the buffer.
+        void* base = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            return NULL;
+        }
+
+        if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, mappedSize);
+            close(fd);
+            return NULL;
+        }
+
+        close(fd);
+        madvise(base, mappedSize, MADV_SEQUENTIAL);
+
+        return new SourceFile(static_cast<char*>(base), size, mappedSize);
+    }
+
+    /* a padded copy of the given text, for text that is not in a file (an edited Document) */
+    static SourceFile* copy(std::string_view text) {
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t mappedSize = (text.size() + PADDING + pageSize - 1) / pageSize * pageSize;
+
+        void* base = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        memcpy(base, text.data(), text.size());
+
+        return new SourceFile(static_cast<char*>(base), text.size(), mappedSize);
+    }
+
+    ~SourceFile() {
+        munmap(data, mappedSize);
+    }
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    char* data;  // file content, followed by PADDING zero bytes
+    size_t size; // file size without the zeros
+
+private:
+    size_t mappedSize;
+
+    SourceFile(char* data, size_t size, size_t mappedSize) : data{data}, size{size}, mappedSize{mappedSize} {}
+};
@@ -8,19 +8,21 @@
 
 class SyntaxException : public std::exception {
 public:
-    SyntaxException(TokenType gottenToken, TokenType expectedToken, int lineNumber = -1)
+    SyntaxException(TokenType gottenToken, TokenType expectedToken, int lineNumber = -1) : lineNumber{lineNumber}
     {
         std::stringstream ss;
         ss << "Expected token '" << TOKEN_NAMES[expectedToken] << "', but got '" << TOKEN_NAMES[gottenToken] << "' on line " << lineNumber << "!";
         message = ss.str();
     };
 
-    SyntaxException(std::string message) : message{message} {}
+    SyntaxException(std::string message, int lineNumber = -1) : lineNumber{lineNumber}, message{message} {}
 
     const char* what() const throw() {
         return message.c_str();
     }
 
+    int lineNumber; // -1 if unknown
+
 private:
     std::string message;
 };
\ No newline at end of file
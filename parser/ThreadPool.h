@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs a known number of tasks on a fixed set of worker threads. Every worker starts with its own contiguous
+ * share of the tasks and takes them from the front; once its share is used up it steals from the back of the
+ * other workers' queues, so a few large inputs don't leave the remaining cores idle.
+ */
+class ThreadPool {
+public:
+    ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency())
+        : threadCount{threadCount > 0 ? threadCount : 1}
+    {}
+
+    /* runs task(i) for every i in [0, count) and returns once all of them are done */
+    void forEach(size_t count, const std::function<void(size_t)>& task) {
+        std::vector<WorkQueue> queues(threadCount);
+
+        for (size_t worker = 0; worker < threadCount; worker++) {
+            size_t begin = count * worker / threadCount;
+            size_t end = count * (worker + 1) / threadCount;
+
+            for (size_t i = begin; i < end; i++) {
+                queues[worker].tasks.push_back(i);
+            }
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned int worker = 0; worker < threadCount; worker++) {
+            workers.emplace_back([&, worker] { work(queues, worker, task); });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    unsigned int size() const { return threadCount; }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    unsigned int threadCount;
+
+    void work(std::vector<WorkQueue>& queues, unsigned int self, const std::function<void(size_t)>& task) {
+        size_t next;
+
+        while (true) {
+            if (takeOwn(queues[self], next)) {
+                task(next);
+                continue;
+            }
+
+            bool stolen = false;
+            for (unsigned int i = 1; i < threadCount && !stolen; i++) {
+                stolen = steal(queues[(self + i) % threadCount], next);
+            }
+
+            // no tasks are added while running, so empty queues everywhere means we are done
+            if (!stolen) {
+                return;
+            }
+
+            task(next);
+        }
+    }
+
+    static bool takeOwn(WorkQueue& queue, size_t& task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    static bool steal(WorkQueue& queue, size_t& task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+};
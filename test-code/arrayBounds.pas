@@ -0,0 +1,47 @@
+{ Arrays passed and assigned to arrays of the same length with other bounds: the elements keep their order, the
+  indexes are the ones the receiving array is declared with }
+
+program arrayBounds;
+
+  var a: array [1..3] of integer;
+      c: array [4..6] of integer;
+      r: array [5..6] of real;
+      s: array [0..1] of real;
+
+  function first (b: array [0..2] of integer) : integer;
+  begin
+    first := b[0]
+  end;
+
+  function sum (b: array [10..12] of integer) : integer;
+  begin
+    b[10] := b[10] + b[11] + b[12];
+    sum := b[10]
+  end;
+
+  function last (b: array [7..9] of integer) : integer;
+    var d: array [0..2] of integer;
+  begin
+    d := b;
+    last := d[2] + first(d)
+  end;
+
+begin
+  a[1] := 10;
+  a[2] := 20;
+  a[3] := 30;
+  writeln(first(a));
+  writeln(sum(a));
+  writeln(a[1]);
+
+  c := a;
+  c[4] := c[4] + 1;
+  writeln(c[4], ' ', c[5], ' ', c[6], ' ', a[1]);
+  writeln(last(c));
+
+  r[5] := 1.5;
+  r[6] := 2.5;
+  s := r;
+  writeln(s[0], ' ', s[1]);
+  writeln(a[0])
+end.
@@ -0,0 +1,19 @@
+{ Edge cases for the lexers, not a valid program }
+program lexer_edges;
+  var veryLongIdentifierNameThatSpansMoreThanOneVectorOfSixtyFourBytes_0123456789abcdefghij: integer;
+  x1, _under, do123, ifx, endx, div2: real;
+
+	{ a comment
+	  spanning several lines with 'quotes' and ; symbols }
+begin
+  a:=1;b :=2.5;c:= 3.;d := 12..34;
+  e := 'a string
+spanning lines';
+  f := 12abc + 3.14x - 007 * 1.2.3;
+  if a<>b then if a<=b then if a>=b then a := a<b else a := a>b;
+  g := not true and false or x div 2 / 3;
+  h := 'unterminated string ; 
+  $ ? ! # @ ~ ^ &
+  i := {unterminated comment
+  PROGRAM Begin END
+end.
@@ -0,0 +1,10 @@
+{ A real literal beyond the range of a double is a semantic error, not a crash }
+
+program realOutOfRange;
+
+  var r: real;
+
+begin
+  r := 10000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000.5;
+  writeln(r)
+end.